@@ -0,0 +1,129 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/core/css/compiled_selector.h"
+
+#include <algorithm>
+
+#include "third_party/blink/renderer/core/css/css_selector.h"
+#include "third_party/blink/renderer/core/dom/qualified_name.h"
+#include "third_party/blink/renderer/platform/wtf/vector.h"
+
+namespace blink {
+
+namespace {
+
+// Pseudo-classes whose result only depends on the element and its siblings,
+// and which CheckPseudoClass handles without looking at the rest of the
+// matching context.
+bool IsCompilablePseudoClass(CSSSelector::PseudoType pseudo_type) {
+  switch (pseudo_type) {
+    case CSSSelector::kPseudoEmpty:
+    case CSSSelector::kPseudoFirstChild:
+    case CSSSelector::kPseudoFirstOfType:
+    case CSSSelector::kPseudoLastChild:
+    case CSSSelector::kPseudoLastOfType:
+    case CSSSelector::kPseudoOnlyChild:
+    case CSSSelector::kPseudoOnlyOfType:
+    case CSSSelector::kPseudoNthChild:
+    case CSSSelector::kPseudoNthOfType:
+    case CSSSelector::kPseudoNthLastChild:
+    case CSSSelector::kPseudoNthLastOfType:
+    case CSSSelector::kPseudoRoot:
+    case CSSSelector::kPseudoAnyLink:
+    case CSSSelector::kPseudoWebkitAnyLink:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+CompiledSelector::CompiledSelector(const Instruction* instructions,
+                                   wtf_size_t size)
+    : size_(size) {
+  std::copy_n(instructions, size,
+              const_cast<Instruction*>(InstructionArray()));
+}
+
+const CompiledSelector* CompiledSelector::Compile(
+    const CSSSelector& selector) {
+  Vector<Instruction, 16> instructions;
+  uint16_t backtracking_point = kNoBacktrackingPoint;
+  unsigned backtracking_point_count = 0;
+
+  auto append = [&](Opcode opcode, const CSSSelector* simple_selector) {
+    instructions.push_back(
+        Instruction{opcode, 0, backtracking_point, simple_selector});
+  };
+
+  for (const CSSSelector* current = &selector; current;
+       current = current->TagHistory()) {
+    switch (current->Match()) {
+      case CSSSelector::kTag:
+        // Universal selectors match every element.
+        if (current->TagQName() != AnyQName())
+          append(Opcode::kTag, current);
+        break;
+      case CSSSelector::kClass:
+        append(Opcode::kClass, current);
+        break;
+      case CSSSelector::kId:
+        append(Opcode::kId, current);
+        break;
+      case CSSSelector::kAttributeExact:
+      case CSSSelector::kAttributeSet:
+      case CSSSelector::kAttributeHyphen:
+      case CSSSelector::kAttributeList:
+      case CSSSelector::kAttributeContain:
+      case CSSSelector::kAttributeBegin:
+      case CSSSelector::kAttributeEnd:
+        append(Opcode::kAttribute, current);
+        break;
+      case CSSSelector::kPseudoClass:
+        if (!IsCompilablePseudoClass(current->GetPseudoType()))
+          return nullptr;
+        append(Opcode::kPseudoClass, current);
+        break;
+      default:
+        return nullptr;
+    }
+
+    if (current->IsLastInTagHistory())
+      break;
+
+    switch (current->Relation()) {
+      case CSSSelector::kSubSelector:
+        break;
+      case CSSSelector::kChild:
+        append(Opcode::kChild, nullptr);
+        break;
+      case CSSSelector::kDirectAdjacent:
+        append(Opcode::kDirectAdjacent, nullptr);
+        break;
+      case CSSSelector::kDescendant:
+      case CSSSelector::kIndirectAdjacent:
+        if (backtracking_point_count == kMaxBacktrackingPoints)
+          return nullptr;
+        append(current->Relation() == CSSSelector::kDescendant
+                   ? Opcode::kDescendant
+                   : Opcode::kIndirectAdjacent,
+               nullptr);
+        instructions.back().slot = backtracking_point_count++;
+        backtracking_point = instructions.size() - 1;
+        break;
+      default:
+        return nullptr;
+    }
+  }
+
+  if (instructions.size() >= kNoBacktrackingPoint)
+    return nullptr;
+  return MakeGarbageCollected<CompiledSelector>(
+      AdditionalBytes(sizeof(Instruction) * instructions.size()),
+      instructions.data(), instructions.size());
+}
+
+}  // namespace blink
@@ -0,0 +1,121 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef THIRD_PARTY_BLINK_RENDERER_CORE_CSS_COMPILED_SELECTOR_H_
+#define THIRD_PARTY_BLINK_RENDERER_CORE_CSS_COMPILED_SELECTOR_H_
+
+#include <type_traits>
+
+#include "base/containers/span.h"
+#include "third_party/blink/renderer/core/core_export.h"
+#include "third_party/blink/renderer/platform/heap/garbage_collected.h"
+#include "third_party/blink/renderer/platform/wtf/allocator/allocator.h"
+#include "third_party/blink/renderer/platform/wtf/wtf_size_t.h"
+
+namespace blink {
+
+class CSSSelector;
+
+// A complex selector lowered to a flat array of instructions, which
+// SelectorChecker runs in a loop instead of recursing through MatchSelector.
+//
+// The instructions are ordered like the TagHistory() of the selector, i.e.
+// from the rightmost compound selector to the leftmost one. Each compound
+// selector is a run of checks against the current element, and compounds are
+// separated by combinator instructions which move to another element.
+//
+// The descendant and indirect adjacent combinators may have to try several
+// elements: they are backtracking points, and remember the element they are
+// currently trying in a slot. Every instruction knows the closest backtracking
+// point before it, which is where matching resumes when the instruction fails.
+// This gives the same results, and skips the same elements, as the
+// kSelectorFailsAllSiblings and kSelectorFailsCompletely statuses of the
+// recursive matching.
+//
+// Only a common subset of selectors is compiled: type, class, id and attribute
+// selectors, structural pseudo-classes which only depend on the element, and
+// the descendant, child and sibling combinators. Compile() returns nullptr for
+// any other selector, which is then matched by the regular SelectorChecker
+// code.
+//
+// There can be a compiled selector for each of the 30k+ RuleData objects of a
+// big website, so the instructions are stored inline after the object, and
+// CompiledSelector is trivially destructible to avoid a finalizer.
+class CORE_EXPORT CompiledSelector final
+    : public GarbageCollected<CompiledSelector> {
+ public:
+  enum class Opcode : uint8_t {
+    // Checks of the current element against a simple selector.
+    kTag,
+    kClass,
+    kId,
+    kAttribute,
+    kPseudoClass,
+    // Combinators, moving to another element.
+    kDescendant,
+    kChild,
+    kDirectAdjacent,
+    kIndirectAdjacent,
+  };
+
+  static constexpr uint16_t kNoBacktrackingPoint = 0xffff;
+
+  // Selectors with more descendant and indirect adjacent combinators than this
+  // are not compiled, so that the slots fit on the stack.
+  static constexpr unsigned kMaxBacktrackingPoints = 8;
+
+  struct Instruction {
+    DISALLOW_NEW();
+
+    Opcode opcode;
+    // For kDescendant and kIndirectAdjacent, the slot holding the element the
+    // combinator is trying.
+    uint8_t slot;
+    // Index of the closest kDescendant or kIndirectAdjacent instruction before
+    // this one, or kNoBacktrackingPoint.
+    uint16_t backtracking_point;
+    // The simple selector checked by this instruction, null for combinators.
+    // Owned by the CSSSelectorList the compiled selector was built from.
+    const CSSSelector* selector;
+  };
+
+  // Returns nullptr if |selector| uses anything which can't be compiled.
+  static const CompiledSelector* Compile(const CSSSelector& selector);
+
+  // Use Compile().
+  CompiledSelector(const Instruction* instructions, wtf_size_t size);
+  CompiledSelector(const CompiledSelector&) = delete;
+  CompiledSelector& operator=(const CompiledSelector&) = delete;
+
+  base::span<const Instruction> Instructions() const {
+    return base::make_span(InstructionArray(), size_);
+  }
+
+  // The number of bytes allocated for this compiled selector, including the
+  // instructions.
+  size_t AllocationSize() const {
+    return sizeof(CompiledSelector) + sizeof(Instruction) * size_;
+  }
+
+  // The instructions only point into the CSSSelectorList, which is kept alive
+  // by the owner of the compiled selector.
+  void Trace(Visitor*) const {}
+
+ private:
+  const Instruction* InstructionArray() const {
+    static_assert(sizeof(CompiledSelector) % alignof(Instruction) == 0,
+                  "InstructionArray may be improperly aligned");
+    return reinterpret_cast<const Instruction*>(this + 1);
+  }
+
+  // Keeps the instructions which follow the object aligned.
+  alignas(Instruction) wtf_size_t size_;
+};
+
+static_assert(std::is_trivially_destructible<CompiledSelector>::value,
+              "CompiledSelector should not need a finalizer");
+
+}  // namespace blink
+
+#endif  // THIRD_PARTY_BLINK_RENDERER_CORE_CSS_COMPILED_SELECTOR_H_
@@ -0,0 +1,310 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/core/css/compiled_selector.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/blink/renderer/core/css/css_selector_list.h"
+#include "third_party/blink/renderer/core/css/parser/css_parser.h"
+#include "third_party/blink/renderer/core/css/parser/css_parser_context.h"
+#include "third_party/blink/renderer/core/css/properties/longhands.h"
+#include "third_party/blink/renderer/core/css/resolver/style_resolver_stats.h"
+#include "third_party/blink/renderer/core/css/selector_checker.h"
+#include "third_party/blink/renderer/core/css/style_engine.h"
+#include "third_party/blink/renderer/core/css/style_request.h"
+#include "third_party/blink/renderer/core/dom/element_traversal.h"
+#include "third_party/blink/renderer/core/testing/page_test_base.h"
+#include "third_party/blink/renderer/platform/graphics/color.h"
+#include "third_party/blink/renderer/platform/wtf/text/text_encoding.h"
+
+namespace blink {
+
+class CompiledSelectorTest : public PageTestBase {
+ protected:
+  CSSSelectorList ParseSelector(const char* selector_text) {
+    return CSSParser::ParseSelector(
+        MakeGarbageCollected<CSSParserContext>(
+            GetDocument(), NullURL(), true /* origin_clean */, Referrer(),
+            WTF::TextEncoding(), CSSParserContext::kSnapshotProfile),
+        nullptr, selector_text);
+  }
+
+  // The instructions point into the parsed selector list, which is kept in
+  // |selector_list_| until the next call.
+  const CompiledSelector* Compile(const char* selector_text) {
+    selector_list_ = ParseSelector(selector_text);
+    EXPECT_TRUE(selector_list_.First()) << selector_text;
+    if (!selector_list_.First())
+      return nullptr;
+    return CompiledSelector::Compile(*selector_list_.First());
+  }
+
+  // Runs |selector_text| through |checker| on every element of the document,
+  // with or without its compiled version. For each element, returns whether
+  // it matched and, for the elements in the body, the restyle flags it has
+  // after matching.
+  Vector<unsigned> MatchAll(const SelectorChecker& checker,
+                            const char* selector_text,
+                            bool use_compiled_selector) {
+    Vector<unsigned> results;
+    CSSSelectorList selector_list = ParseSelector(selector_text);
+    EXPECT_TRUE(selector_list.First());
+    if (!selector_list.First())
+      return results;
+    const CompiledSelector* compiled_selector =
+        CompiledSelector::Compile(*selector_list.First());
+    EXPECT_TRUE(compiled_selector);
+
+    for (Element& element : ElementTraversal::DescendantsOf(GetDocument())) {
+      SelectorChecker::SelectorCheckingContext context(&element);
+      context.selector = selector_list.First();
+      context.scope = &GetDocument();
+      EXPECT_TRUE(SelectorChecker::CanUseCompiledSelector(context));
+      if (use_compiled_selector)
+        context.compiled_selector = compiled_selector;
+      results.push_back(checker.Match(context));
+    }
+    // The flags are only ever set, so only look at the elements recreated by
+    // SetBodyInnerHTML().
+    wtf_size_t index = 0;
+    for (Element& element : ElementTraversal::DescendantsOf(GetDocument())) {
+      if (element.IsDescendantOf(GetDocument().body()))
+        results[index] |= RestyleFlags(element) << 1;
+      index++;
+    }
+    return results;
+  }
+
+  static unsigned RestyleFlags(const Element& element) {
+    const bool flags[] = {
+        element.ChildrenAffectedByFirstChildRules(),
+        element.ChildrenAffectedByLastChildRules(),
+        element.ChildrenAffectedByDirectAdjacentRules(),
+        element.ChildrenAffectedByIndirectAdjacentRules(),
+        element.ChildrenAffectedByForwardPositionalRules(),
+        element.ChildrenAffectedByBackwardPositionalRules(),
+        element.AffectedByFirstChildRules(),
+        element.AffectedByLastChildRules(),
+        element.StyleAffectedByEmpty(),
+    };
+    unsigned result = 0;
+    for (unsigned i = 0; i < std::size(flags); i++)
+      result |= flags[i] << i;
+    return result;
+  }
+
+ private:
+  CSSSelectorList selector_list_;
+};
+
+TEST_F(CompiledSelectorTest, Compile) {
+  const char* compiled[] = {
+      "*",
+      "div",
+      ".a",
+      "#id",
+      "[attr]",
+      "[attr=value i]",
+      "div.a#id[attr~=x]",
+      "div > .a",
+      "div .a",
+      "div + .a",
+      "div ~ .a",
+      ".a .b > .c ~ .d + .e",
+      "li:first-child",
+      "li:nth-child(2n+1)",
+      ":root > body :empty",
+  };
+  for (const char* selector_text : compiled)
+    EXPECT_TRUE(Compile(selector_text)) << selector_text;
+
+  const char* not_compiled[] = {
+      "div::before",
+      "a:hover",
+      "a:visited",
+      ":not(.a)",
+      ":is(.a, .b) .c",
+      ":has(.a)",
+      ":scope > div",
+      ".a .b .c .d .e .f .g .h .i .j",
+  };
+  for (const char* selector_text : not_compiled)
+    EXPECT_FALSE(Compile(selector_text)) << selector_text;
+}
+
+TEST_F(CompiledSelectorTest, Instructions) {
+  using Opcode = CompiledSelector::Opcode;
+  const CompiledSelector* compiled_selector = Compile(".a > * .b.c");
+  ASSERT_TRUE(compiled_selector);
+  const auto instructions = compiled_selector->Instructions();
+  // The universal selector is dropped.
+  ASSERT_EQ(5u, instructions.size());
+  // The instructions are allocated along with the object.
+  EXPECT_EQ(sizeof(CompiledSelector) +
+                5 * sizeof(CompiledSelector::Instruction),
+            compiled_selector->AllocationSize());
+  EXPECT_EQ(Opcode::kClass, instructions[0].opcode);
+  EXPECT_EQ(Opcode::kClass, instructions[1].opcode);
+  EXPECT_EQ(Opcode::kDescendant, instructions[2].opcode);
+  EXPECT_EQ(Opcode::kChild, instructions[3].opcode);
+  EXPECT_EQ(Opcode::kClass, instructions[4].opcode);
+
+  EXPECT_EQ(CompiledSelector::kNoBacktrackingPoint,
+            instructions[0].backtracking_point);
+  EXPECT_EQ(CompiledSelector::kNoBacktrackingPoint,
+            instructions[2].backtracking_point);
+  EXPECT_EQ(2u, instructions[3].backtracking_point);
+  EXPECT_EQ(2u, instructions[4].backtracking_point);
+}
+
+namespace {
+
+const char kMatchingHTML[] = R"HTML(
+    <div id=outer class="a">
+      <ul class="list">
+        <li class="item first" data-x="foo-bar">One</li>
+        <li class="item">Two</li>
+        <li class="item selected" data-x="foo">Three</li>
+        <li class="item"></li>
+      </ul>
+      <div class="b">
+        <p class="c">Text</p>
+        <span class="d"><em class="e">Em</em></span>
+        <p class="c last"></p>
+      </div>
+    </div>
+    <section class="a">
+      <div class="b"><div class="b"><span class="c"></span></div></div>
+      <h1>Title</h1><h2 lang="en-US">Sub</h2><p class="e"></p>
+    </section>
+  )HTML";
+
+// Selectors which all compile and match some element of kMatchingHTML.
+const char* const kMatchingSelectors[] = {
+    "*",
+    "li",
+    ".item",
+    "#outer",
+    "[data-x]",
+    "[data-x|=foo]",
+    "[data-x^=FOO i]",
+    "li.item.selected",
+    "ul > li",
+    "div li",
+    ".a .b .c",
+    ".a > .b > .c",
+    ".a .b > .c",
+    "section .b .b .c",
+    ".b > span .e",
+    "li + li",
+    "li ~ .selected",
+    ".selected ~ li",
+    "h1 + h2 ~ p",
+    "h1 ~ h2 + p.e",
+    ".a .c ~ .c",
+    ".a p + span > em",
+    "div ~ h1",
+    "li:first-child",
+    "li:last-child",
+    "li:nth-child(2n+1)",
+    "li:nth-last-of-type(2)",
+    ".list :empty",
+    ":root body > .a",
+    ".b > :only-child",
+    "body > * > * > .c",
+    "p:first-of-type",
+    "em:only-of-type",
+};
+
+}  // namespace
+
+TEST_F(CompiledSelectorTest, MatchesLikeSelectorChecker) {
+  SetBodyInnerHTML(kMatchingHTML);
+
+  SelectorChecker checker(SelectorChecker::kQueryingRules);
+  for (const char* selector_text : kMatchingSelectors) {
+    SCOPED_TRACE(selector_text);
+    const Vector<unsigned> expected =
+        MatchAll(checker, selector_text, false /* use_compiled_selector */);
+    EXPECT_EQ(expected, MatchAll(checker, selector_text,
+                                 true /* use_compiled_selector */));
+    // Make sure the test selectors aren't trivially failing.
+    EXPECT_TRUE(std::any_of(expected.begin(), expected.end(),
+                            [](unsigned result) { return result & 1; }));
+  }
+}
+
+// When resolving style, the compiled selectors must also set the same restyle
+// flags as the recursive matching.
+TEST_F(CompiledSelectorTest, MatchesLikeSelectorCheckerWhenResolvingStyle) {
+  SelectorChecker checker(nullptr /* element_style */, nullptr /* part_names */,
+                          StyleRequest(), SelectorChecker::kResolvingStyle,
+                          false /* is_ua_rule */);
+  for (const char* selector_text : kMatchingSelectors) {
+    SCOPED_TRACE(selector_text);
+    SetBodyInnerHTML(kMatchingHTML);
+    const Vector<unsigned> expected =
+        MatchAll(checker, selector_text, false /* use_compiled_selector */);
+    SetBodyInnerHTML(kMatchingHTML);
+    EXPECT_EQ(expected, MatchAll(checker, selector_text,
+                                 true /* use_compiled_selector */));
+  }
+}
+
+// Style recalc matches the rules of the document with compiled selectors.
+TEST_F(CompiledSelectorTest, ElementRuleCollector) {
+  GetStyleEngine().SetStatsEnabled(true);
+  SetBodyInnerHTML(R"HTML(
+    <style>
+      .list > li:first-child { color: green }
+      li + li.selected { color: green }
+      .a .b > .c ~ .c { color: green }
+      section .b .b > .c { color: green }
+      h1 ~ p:last-child { color: green }
+    </style>
+    <div class="a">
+      <ul class="list">
+        <li id=first>One</li>
+        <li id=second>Two</li>
+        <li id=selected class="selected">Three</li>
+      </ul>
+      <div class="b"><p id=c1 class="c"></p><p id=c2 class="c"></p></div>
+    </div>
+    <section>
+      <div class="b"><div class="b"><span id=span class="c"></span></div></div>
+      <div class="b"><span id=not_nested class="c"></span></div>
+      <h1></h1><p id=last></p>
+    </section>
+  )HTML");
+
+  const StyleResolverStats* stats = GetStyleEngine().Stats();
+  ASSERT_TRUE(stats);
+  EXPECT_GT(stats->compiled_selector_matches, 0u);
+
+  const char* matching[] = {"first", "selected", "c2", "span", "last"};
+  for (const char* id : matching) {
+    SCOPED_TRACE(id);
+    EXPECT_EQ(MakeRGB(0, 128, 0),
+              GetElementById(id)->GetComputedStyle()->VisitedDependentColor(
+                  GetCSSPropertyColor()));
+  }
+  const char* not_matching[] = {"second", "c1", "not_nested"};
+  for (const char* id : not_matching) {
+    SCOPED_TRACE(id);
+    EXPECT_EQ(MakeRGB(0, 0, 0),
+              GetElementById(id)->GetComputedStyle()->VisitedDependentColor(
+                  GetCSSPropertyColor()));
+  }
+
+  // The restyle flags for later DOM mutations are set too.
+  Element* list = GetDocument().QuerySelector(".list");
+  EXPECT_TRUE(list->ChildrenAffectedByFirstChildRules());
+  EXPECT_TRUE(list->ChildrenAffectedByDirectAdjacentRules());
+  EXPECT_TRUE(GetElementById("last")->AffectedByLastChildRules());
+}
+
+}  // namespace blink
@@ -241,9 +241,14 @@ void ElementRuleCollector::CollectMatchingRulesForList(
 
   CascadeLayerSeeker layer_seeker(match_request);
 
+  const bool can_use_compiled_selectors =
+      SelectorChecker::CanUseCompiledSelector(context);
+
   unsigned rejected = 0;
   unsigned fast_rejected = 0;
   unsigned matched = 0;
+  unsigned compiled_selector_matches = 0;
+  unsigned fallback_selector_matches = 0;
 
   for (const auto& rule_data : *rules) {
     if (can_use_fast_reject_ &&
@@ -277,6 +282,12 @@ void ElementRuleCollector::CollectMatchingRulesForList(
 
     SelectorChecker::MatchResult result;
     context.selector = &selector;
+    context.compiled_selector =
+        can_use_compiled_selectors ? rule_data->GetCompiledSelector() : nullptr;
+    if (context.compiled_selector)
+      compiled_selector_matches++;
+    else
+      fallback_selector_matches++;
     context.is_inside_visited_link =
         rule_data->LinkMatchType() == CSSSelector::kMatchVisited;
     DCHECK(!context.is_inside_visited_link ||
@@ -329,6 +340,10 @@ void ElementRuleCollector::CollectMatchingRulesForList(
   INCREMENT_STYLE_STATS_COUNTER(style_engine, rules_fast_rejected,
                                 fast_rejected);
   INCREMENT_STYLE_STATS_COUNTER(style_engine, rules_matched, matched);
+  INCREMENT_STYLE_STATS_COUNTER(style_engine, compiled_selector_matches,
+                                compiled_selector_matches);
+  INCREMENT_STYLE_STATS_COUNTER(style_engine, fallback_selector_matches,
+                                fallback_selector_matches);
 }
 
 DISABLE_CFI_PERF
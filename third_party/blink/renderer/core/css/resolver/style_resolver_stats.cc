@@ -42,6 +42,8 @@ void StyleResolverStats::Reset() {
   rules_fast_rejected = 0;
   rules_rejected = 0;
   rules_matched = 0;
+  compiled_selector_matches = 0;
+  fallback_selector_matches = 0;
   styles_changed = 0;
   styles_unchanged = 0;
   styles_animated = 0;
@@ -64,6 +66,10 @@ std::unique_ptr<TracedValue> StyleResolverStats::ToTracedValue() const {
   traced_value->SetInteger("rulesRejected", rules_rejected);
   traced_value->SetInteger("rulesFastRejected", rules_fast_rejected);
   traced_value->SetInteger("rulesMatched", rules_matched);
+  traced_value->SetInteger("compiledSelectorMatches",
+                           compiled_selector_matches);
+  traced_value->SetInteger("fallbackSelectorMatches",
+                           fallback_selector_matches);
   traced_value->SetInteger("stylesChanged", styles_changed);
   traced_value->SetInteger("stylesUnchanged", styles_unchanged);
   traced_value->SetInteger("stylesAnimated", styles_animated);
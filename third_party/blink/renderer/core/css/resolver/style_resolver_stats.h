@@ -55,6 +55,10 @@ class StyleResolverStats {
   unsigned rules_fast_rejected;
   unsigned rules_rejected;
   unsigned rules_matched;
+  // Selectors matched with a CompiledSelector, and with the recursive
+  // SelectorChecker matching.
+  unsigned compiled_selector_matches;
+  unsigned fallback_selector_matches;
   unsigned styles_changed;
   unsigned styles_unchanged;
   unsigned styles_animated;
@@ -127,7 +127,8 @@ RuleData::RuleData(Type type,
           static_cast<std::underlying_type_t<ValidPropertyFilter>>(
               DetermineValidPropertyFilter(add_rule_flags, Selector()))),
       type_(static_cast<unsigned>(type)),
-      descendant_selector_identifier_hashes_() {
+      descendant_selector_identifier_hashes_(),
+      compiled_selector_(CompiledSelector::Compile(Selector())) {
   SelectorFilter::CollectIdentifierHashes(
       Selector(), descendant_selector_identifier_hashes_,
       kMaximumIdentifierCount);
@@ -653,6 +654,7 @@ void RuleData::Trace(Visitor* visitor) const {
 
 void RuleData::TraceAfterDispatch(blink::Visitor* visitor) const {
   visitor->Trace(rule_);
+  visitor->Trace(compiled_selector_);
 }
 
 ExtendedRuleData::ExtendedRuleData(base::PassKey<RuleData>,
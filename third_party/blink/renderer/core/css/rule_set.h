@@ -26,6 +26,7 @@
 #include "base/types/pass_key.h"
 #include "third_party/blink/renderer/core/core_export.h"
 #include "third_party/blink/renderer/core/css/cascade_layer.h"
+#include "third_party/blink/renderer/core/css/compiled_selector.h"
 #include "third_party/blink/renderer/core/css/css_keyframes_rule.h"
 #include "third_party/blink/renderer/core/css/media_query_evaluator.h"
 #include "third_party/blink/renderer/core/css/resolver/media_query_result.h"
@@ -132,6 +133,10 @@ class CORE_EXPORT RuleData : public GarbageCollected<RuleData> {
   const unsigned* DescendantSelectorIdentifierHashes() const {
     return descendant_selector_identifier_hashes_;
   }
+  // Null if the selector can't be compiled. See CompiledSelector.
+  const CompiledSelector* GetCompiledSelector() const {
+    return compiled_selector_;
+  }
 
   void Trace(Visitor*) const;
   void TraceAfterDispatch(blink::Visitor* visitor) const;
@@ -167,6 +172,7 @@ class CORE_EXPORT RuleData : public GarbageCollected<RuleData> {
   // 31 bits above
   // Use plain array instead of a Vector to minimize memory overhead.
   unsigned descendant_selector_identifier_hashes_[kMaximumIdentifierCount];
+  Member<const CompiledSelector> compiled_selector_;
 };
 
 // Big websites can have a large number of RuleData objects (30k+). This class
@@ -206,9 +212,13 @@ struct SameSizeAsRuleData {
   unsigned b;
   unsigned c;
   unsigned d[4];
+  Member<void*> e;
 };
 
 ASSERT_SIZE(RuleData, SameSizeAsRuleData);
+// There can be a lot of RuleData objects, they shouldn't need a finalizer.
+static_assert(std::is_trivially_destructible<RuleData>::value,
+              "RuleData should be trivially destructible");
 
 // Holds RuleData objects. It partitions them into various indexed groups,
 // e.g. it stores separately rules that match against id, class, tag, shadow
@@ -31,6 +31,7 @@
 
 #include "base/auto_reset.h"
 #include "third_party/blink/public/mojom/input/focus_type.mojom-blink.h"
+#include "third_party/blink/renderer/core/css/compiled_selector.h"
 #include "third_party/blink/renderer/core/css/css_selector_list.h"
 #include "third_party/blink/renderer/core/css/has_argument_match_context.h"
 #include "third_party/blink/renderer/core/css/has_matched_cache_scope.h"
@@ -212,6 +213,11 @@ bool SelectorChecker::Match(const SelectorCheckingContext& context,
   base::AutoReset<bool> reset_inside_match(&inside_match_, true);
 #endif  // DCHECK_IS_ON()
 
+  if (context.compiled_selector) {
+    DCHECK(CanUseCompiledSelector(context));
+    return MatchCompiledSelector(context, result);
+  }
+
   if (UNLIKELY(context.vtt_originating_element)) {
     // A kUAShadow combinator is required for VTT matching.
     if (context.selector->IsLastInTagHistory())
@@ -586,6 +592,127 @@ static bool AnyAttributeMatches(Element& element,
   return false;
 }
 
+bool SelectorChecker::CanUseCompiledSelector(
+    const SelectorCheckingContext& context) {
+  // Outside of shadow trees, ParentElement() is the parent element, the scope
+  // never limits the matching, and CheckOne() has no special case for shadow
+  // hosts.
+  return context.pseudo_id == kPseudoIdNone &&
+         !context.vtt_originating_element && !context.is_sub_selector &&
+         !context.in_nested_complex_selector &&
+         !context.relative_leftmost_element &&
+         !context.element->IsInShadowTree() &&
+         (!context.scope || !context.scope->IsInShadowTree());
+}
+
+bool SelectorChecker::MatchCompiledSelector(
+    const SelectorCheckingContext& context,
+    MatchResult& result) const {
+  using Opcode = CompiledSelector::Opcode;
+  base::span<const CompiledSelector::Instruction> instructions =
+      context.compiled_selector->Instructions();
+  Element* backtracking_elements[CompiledSelector::kMaxBacktrackingPoints];
+
+  Element* element = context.element;
+  wtf_size_t index = 0;
+  while (true) {
+    MatchStatus status = kSelectorMatches;
+    for (; index < instructions.size(); ++index) {
+      const CompiledSelector::Instruction& instruction = instructions[index];
+      const CSSSelector* selector = instruction.selector;
+      switch (instruction.opcode) {
+        case Opcode::kTag:
+          if (!MatchesTagName(*element, selector->TagQName()))
+            status = kSelectorFailsLocally;
+          break;
+        case Opcode::kClass:
+          if (!element->HasClass() ||
+              !element->ClassNames().Contains(selector->Value()))
+            status = kSelectorFailsLocally;
+          break;
+        case Opcode::kId:
+          if (!element->HasID() ||
+              element->IdForStyleResolution() != selector->Value())
+            status = kSelectorFailsLocally;
+          break;
+        case Opcode::kAttribute:
+          if (!AnyAttributeMatches(*element, selector->Match(), *selector))
+            status = kSelectorFailsLocally;
+          break;
+        case Opcode::kPseudoClass: {
+          SelectorCheckingContext sub_context(element);
+          sub_context.selector = selector;
+          sub_context.scope = context.scope;
+          if (!CheckPseudoClass(sub_context, result))
+            status = kSelectorFailsLocally;
+          break;
+        }
+        case Opcode::kDescendant:
+          element = element->parentElement();
+          if (!element)
+            status = kSelectorFailsCompletely;
+          else
+            backtracking_elements[instruction.slot] = element;
+          break;
+        case Opcode::kChild:
+          element = element->parentElement();
+          if (!element)
+            status = kSelectorFailsCompletely;
+          break;
+        case Opcode::kDirectAdjacent:
+        case Opcode::kIndirectAdjacent:
+          if (mode_ == kResolvingStyle) {
+            if (ContainerNode* parent = element->ParentElementOrShadowRoot()) {
+              if (instruction.opcode == Opcode::kDirectAdjacent)
+                parent->SetChildrenAffectedByDirectAdjacentRules();
+              else
+                parent->SetChildrenAffectedByIndirectAdjacentRules();
+            }
+          }
+          element = ElementTraversal::PreviousSibling(*element);
+          if (!element)
+            status = kSelectorFailsAllSiblings;
+          else if (instruction.opcode == Opcode::kIndirectAdjacent)
+            backtracking_elements[instruction.slot] = element;
+          break;
+      }
+      if (status != kSelectorMatches)
+        break;
+    }
+    if (status == kSelectorMatches)
+      return true;
+
+    // Find the innermost backtracking point which still has an element to
+    // try, in the same way MatchForRelation() propagates the status.
+    uint16_t point = instructions[index].backtracking_point;
+    while (true) {
+      if (point == CompiledSelector::kNoBacktrackingPoint)
+        return false;
+      const CompiledSelector::Instruction& combinator = instructions[point];
+      Element*& candidate = backtracking_elements[combinator.slot];
+      if (combinator.opcode == Opcode::kDescendant) {
+        if (status != kSelectorFailsCompletely) {
+          candidate = candidate->parentElement();
+          if (candidate)
+            break;
+          status = kSelectorFailsCompletely;
+        }
+      } else {
+        DCHECK_EQ(combinator.opcode, Opcode::kIndirectAdjacent);
+        if (status == kSelectorFailsLocally) {
+          candidate = ElementTraversal::PreviousSibling(*candidate);
+          if (candidate)
+            break;
+          status = kSelectorFailsAllSiblings;
+        }
+      }
+      point = combinator.backtracking_point;
+    }
+    element = backtracking_elements[instructions[point].slot];
+    index = point + 1;
+  }
+}
+
 bool SelectorChecker::CheckOne(const SelectorCheckingContext& context,
                                MatchResult& result) const {
   DCHECK(context.element);
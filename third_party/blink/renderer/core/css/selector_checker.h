@@ -39,6 +39,7 @@
 namespace blink {
 
 class CSSSelector;
+class CompiledSelector;
 class ContainerNode;
 class CustomScrollbar;
 class ComputedStyle;
@@ -122,6 +123,9 @@ class CORE_EXPORT SelectorChecker {
     bool in_nested_complex_selector = false;
     bool is_inside_visited_link = false;
     const ContainerNode* relative_leftmost_element = nullptr;
+    // If set, |selector| is matched by running this compiled version of it.
+    // Only set when CanUseCompiledSelector() returns true for the context.
+    const CompiledSelector* compiled_selector = nullptr;
   };
 
   struct MatchResult {
@@ -193,6 +197,11 @@ class CORE_EXPORT SelectorChecker {
     return Match(context, ignore_result);
   }
 
+  // Returns true if compiled selectors can be matched in |context|. The
+  // compiled matching doesn't handle pseudo-elements, VTT or shadow tree
+  // scoping, nor nested matching like :is() and :has() arguments.
+  static bool CanUseCompiledSelector(const SelectorCheckingContext& context);
+
   static bool MatchesFocusPseudoClass(const Element&);
   static bool MatchesFocusVisiblePseudoClass(const Element&);
   static bool MatchesSpatialNavigationInterestPseudoClass(const Element&);
@@ -232,6 +241,10 @@ class CORE_EXPORT SelectorChecker {
                                   MatchResult&) const;
   MatchStatus MatchForRelation(const SelectorCheckingContext&,
                                MatchResult&) const;
+  // Non-recursive matching of context.compiled_selector. See
+  // CompiledSelector.
+  bool MatchCompiledSelector(const SelectorCheckingContext&,
+                             MatchResult&) const;
   MatchStatus MatchForPseudoContent(const SelectorCheckingContext&,
                                     const Element&,
                                     MatchResult&) const;
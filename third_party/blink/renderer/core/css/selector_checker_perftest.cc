@@ -0,0 +1,203 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/cxx17_backports.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/blink/renderer/core/css/compiled_selector.h"
+#include "third_party/blink/renderer/core/css/css_selector_list.h"
+#include "third_party/blink/renderer/core/css/css_test_helpers.h"
+#include "third_party/blink/renderer/core/css/parser/css_parser.h"
+#include "third_party/blink/renderer/core/css/parser/css_parser_context.h"
+#include "third_party/blink/renderer/core/css/rule_set.h"
+#include "third_party/blink/renderer/core/css/selector_checker.h"
+#include "third_party/blink/renderer/core/dom/element_traversal.h"
+#include "third_party/blink/renderer/core/testing/page_test_base.h"
+#include "third_party/blink/renderer/platform/heap/collection_support/heap_vector.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+#include "third_party/blink/renderer/platform/wtf/text/text_encoding.h"
+
+namespace blink {
+
+namespace {
+
+// Selectors typical of the rules matched during style recalc of large pages:
+// mostly short compounds with one or two combinators.
+const char* const kSelectors[] = {
+    ".nav .item",
+    ".nav > .item > a",
+    ".list li",
+    ".list > li:first-child",
+    ".list > li:nth-child(2n+1)",
+    "ul li a",
+    ".card .title",
+    ".card .body p",
+    ".card + .card",
+    ".item ~ .item",
+    "div.content span.label",
+    "[data-role=button]",
+    ".grid .row .cell",
+    ".grid > .row > .cell:last-child",
+    "#main .sidebar a",
+    "body .footer .item a",
+    "h2 + p",
+    ".content :empty",
+};
+
+constexpr int kNumRounds = 20;
+
+// Number of rules in the stylesheet of LargeStyleSheet, in the range of the
+// RuleData counts of big websites.
+constexpr int kNumLargeStyleSheetRules = 30000;
+
+constexpr char kMetricPrefix[] = "SelectorChecker.";
+constexpr char kMetricMatchTime[] = "match_time";
+constexpr char kMetricRuleSetTime[] = "rule_set_time";
+constexpr char kMetricCompiledRules[] = "compiled_rules";
+constexpr char kMetricCompiledBytesPerRule[] = "compiled_bytes_per_rule";
+
+}  // namespace
+
+class SelectorCheckerPerfTest : public PageTestBase {
+ protected:
+  void BuildDocument() {
+    StringBuilder html;
+    html.Append("<div id=main><div class=nav>");
+    for (int i = 0; i < 20; i++)
+      html.Append("<div class=item><a href=#>Link</a></div>");
+    html.Append("</div><div class=sidebar>");
+    for (int i = 0; i < 50; i++) {
+      html.Append("<ul class=list>");
+      for (int j = 0; j < 10; j++)
+        html.Append("<li><a href=#>Item</a> <span class=label></span></li>");
+      html.Append("</ul>");
+    }
+    html.Append("</div><div class=content>");
+    for (int i = 0; i < 100; i++) {
+      html.Append(
+          "<div class=card><h2 class=title>Title</h2><p>Body</p><div "
+          "class=body><p><span class=label>Label</span></p><button "
+          "data-role=button></button></div></div>");
+    }
+    html.Append("<div class=grid>");
+    for (int i = 0; i < 50; i++) {
+      html.Append("<div class=row>");
+      for (int j = 0; j < 8; j++)
+        html.Append("<div class=cell><span></span></div>");
+      html.Append("</div>");
+    }
+    html.Append("</div></div></div><div class=footer>");
+    for (int i = 0; i < 20; i++)
+      html.Append("<div class=item><a href=#>Footer</a></div>");
+    html.Append("</div>");
+    SetBodyInnerHTML(html.ToString());
+  }
+
+  // Matches every selector against every element, with the compiled
+  // selectors if |use_compiled_selectors| is true, and returns the number of
+  // matches.
+  unsigned MatchAll(const Vector<CSSSelectorList>& selector_lists,
+                    const HeapVector<Member<const CompiledSelector>>& compiled,
+                    bool use_compiled_selectors) {
+    SelectorChecker checker(SelectorChecker::kQueryingRules);
+    unsigned matches = 0;
+    for (Element& element : ElementTraversal::DescendantsOf(GetDocument())) {
+      SelectorChecker::SelectorCheckingContext context(&element);
+      context.scope = &GetDocument();
+      for (wtf_size_t i = 0; i < selector_lists.size(); i++) {
+        context.selector = selector_lists[i].First();
+        context.compiled_selector =
+            use_compiled_selectors ? compiled[i].Get() : nullptr;
+        matches += checker.Match(context);
+      }
+    }
+    return matches;
+  }
+};
+
+TEST_F(SelectorCheckerPerfTest, StyleRecalcSelectors) {
+  BuildDocument();
+
+  auto* parser_context = MakeGarbageCollected<CSSParserContext>(
+      GetDocument(), NullURL(), true /* origin_clean */, Referrer(),
+      WTF::TextEncoding(), CSSParserContext::kSnapshotProfile);
+  Vector<CSSSelectorList> selector_lists;
+  HeapVector<Member<const CompiledSelector>> compiled;
+  for (const char* selector_text : kSelectors) {
+    selector_lists.push_back(
+        CSSParser::ParseSelector(parser_context, nullptr, selector_text));
+    ASSERT_TRUE(selector_lists.back().First());
+    compiled.push_back(
+        CompiledSelector::Compile(*selector_lists.back().First()));
+    ASSERT_TRUE(compiled.back()) << selector_text;
+  }
+
+  const unsigned expected_matches =
+      MatchAll(selector_lists, compiled, false /* use_compiled_selectors */);
+  EXPECT_EQ(expected_matches, MatchAll(selector_lists, compiled,
+                                      true /* use_compiled_selectors */));
+
+  for (bool use_compiled_selectors : {false, true}) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int round = 0; round < kNumRounds; round++) {
+      EXPECT_EQ(expected_matches,
+                MatchAll(selector_lists, compiled, use_compiled_selectors));
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    perf_test::PerfResultReporter reporter(
+        kMetricPrefix, use_compiled_selectors ? "Compiled" : "Recursive");
+    reporter.RegisterImportantMetric(kMetricMatchTime, "ms");
+    reporter.AddResult(kMetricMatchTime,
+                       elapsed.InMillisecondsF() / kNumRounds);
+  }
+}
+
+// Builds the RuleSet of a stylesheet as big as the ones of large websites, and
+// reports how much memory the compiled selectors of its RuleData objects use.
+TEST_F(SelectorCheckerPerfTest, LargeStyleSheet) {
+  StringBuilder css;
+  for (int i = 0; i < kNumLargeStyleSheetRules; i++) {
+    css.Append(kSelectors[i % base::size(kSelectors)]);
+    css.Append(" .r");
+    css.AppendNumber(i);
+    css.Append(" { color: red }\n");
+  }
+
+  css_test_helpers::TestStyleSheet sheet;
+  base::TimeTicks start = base::TimeTicks::Now();
+  sheet.AddCSSRules(css.ToString());
+  const RuleSet& rule_set = sheet.GetRuleSet();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  ASSERT_EQ(static_cast<unsigned>(kNumLargeStyleSheetRules),
+            rule_set.RuleCount());
+
+  unsigned compiled_rules = 0;
+  size_t compiled_bytes = 0;
+  for (int i = 0; i < kNumLargeStyleSheetRules; i++) {
+    const HeapVector<Member<const RuleData>>* rules =
+        rule_set.ClassRules(AtomicString("r" + String::Number(i)));
+    ASSERT_TRUE(rules);
+    for (const RuleData* rule_data : *rules) {
+      if (const CompiledSelector* compiled_selector =
+              rule_data->GetCompiledSelector()) {
+        compiled_rules++;
+        compiled_bytes += compiled_selector->AllocationSize();
+      }
+    }
+  }
+  EXPECT_EQ(static_cast<unsigned>(kNumLargeStyleSheetRules), compiled_rules);
+
+  perf_test::PerfResultReporter reporter(kMetricPrefix, "LargeStyleSheet");
+  reporter.RegisterImportantMetric(kMetricRuleSetTime, "ms");
+  reporter.RegisterImportantMetric(kMetricCompiledRules, "count");
+  reporter.RegisterImportantMetric(kMetricCompiledBytesPerRule, "bytes");
+  reporter.AddResult(kMetricRuleSetTime, elapsed.InMillisecondsF());
+  reporter.AddResult(kMetricCompiledRules, compiled_rules);
+  reporter.AddResult(kMetricCompiledBytesPerRule,
+                     static_cast<double>(compiled_bytes) / compiled_rules);
+}
+
+}  // namespace blink
@@ -62,11 +62,13 @@ SelectorQuery::QueryStats SelectorQuery::LastQueryStats() {
 #define QUERY_STATS_INCREMENT(name) \
   (void)(CurrentQueryStats().total_count++, CurrentQueryStats().name++);
 #define QUERY_STATS_RESET() (void)(CurrentQueryStats() = {});
+#define QUERY_STATS_COUNT(name) (void)(CurrentQueryStats().name++);
 
 #else
 
 #define QUERY_STATS_INCREMENT(name)
 #define QUERY_STATS_RESET()
+#define QUERY_STATS_COUNT(name)
 
 #endif
 
@@ -96,12 +98,19 @@ struct AllElementsSelectorQueryTrait {
 };
 
 inline bool SelectorMatches(const CSSSelector& selector,
+                            const CompiledSelector* compiled_selector,
                             Element& element,
                             const ContainerNode& root_node,
                             const SelectorChecker& checker) {
   SelectorChecker::SelectorCheckingContext context(&element);
   context.selector = &selector;
   context.scope = &root_node;
+  if (compiled_selector && SelectorChecker::CanUseCompiledSelector(context)) {
+    context.compiled_selector = compiled_selector;
+    QUERY_STATS_COUNT(compiled_selector_matches);
+  } else {
+    QUERY_STATS_COUNT(fallback_selector_matches);
+  }
   return checker.Match(context);
 }
 
@@ -148,13 +157,15 @@ static void CollectElementsByClassName(
     ContainerNode& root_node,
     const AtomicString& class_name,
     const CSSSelector* selector,
+    const CompiledSelector* compiled_selector,
     typename SelectorQueryTrait::OutputType& output) {
   SelectorChecker checker(SelectorChecker::kQueryingRules);
   for (Element& element : ElementTraversal::DescendantsOf(root_node)) {
     QUERY_STATS_INCREMENT(fast_class);
     if (!element.HasClassName(class_name))
       continue;
-    if (selector && !SelectorMatches(*selector, element, root_node, checker))
+    if (selector && !SelectorMatches(*selector, compiled_selector, element,
+                                     root_node, checker))
       continue;
     SelectorQueryTrait::AppendElement(output, element);
     if (SelectorQueryTrait::kShouldOnlyMatchFirstElement)
@@ -225,7 +236,8 @@ void SelectorQuery::FindTraverseRootsAndExecute(
         selector->Match() == CSSSelector::kClass) {
       if (is_rightmost_selector) {
         CollectElementsByClassName<SelectorQueryTrait>(
-            root_node, selector->Value(), selectors_[0], output);
+            root_node, selector->Value(), selectors_[0],
+            compiled_selectors_->front(), output);
         return;
       }
       // Since there exists some ancestor element which has the class name, we
@@ -271,11 +283,13 @@ void SelectorQuery::ExecuteForTraverseRoot(
   DCHECK_EQ(selectors_.size(), 1u);
 
   const CSSSelector& selector = *selectors_[0];
+  const CompiledSelector* compiled_selector = compiled_selectors_->front();
   SelectorChecker checker(SelectorChecker::kQueryingRules);
 
   for (Element& element : ElementTraversal::DescendantsOf(traverse_root)) {
     QUERY_STATS_INCREMENT(fast_scan);
-    if (SelectorMatches(selector, element, root_node, checker)) {
+    if (SelectorMatches(selector, compiled_selector, element, root_node,
+                        checker)) {
       SelectorQueryTrait::AppendElement(output, element);
       if (SelectorQueryTrait::kShouldOnlyMatchFirstElement)
         return;
@@ -286,8 +300,9 @@ void SelectorQuery::ExecuteForTraverseRoot(
 bool SelectorQuery::SelectorListMatches(ContainerNode& root_node,
                                         Element& element) const {
   SelectorChecker checker(SelectorChecker::kQueryingRules);
-  for (auto* const selector : selectors_) {
-    if (SelectorMatches(*selector, element, root_node, checker))
+  for (wtf_size_t i = 0; i < selectors_.size(); ++i) {
+    if (SelectorMatches(*selectors_[i], compiled_selectors_->at(i), element,
+                        root_node, checker))
       return true;
   }
   return false;
@@ -315,6 +330,7 @@ void SelectorQuery::ExecuteWithId(
   DCHECK(!root_node.GetDocument().InQuirksMode());
 
   const CSSSelector& first_selector = *selectors_[0];
+  const CompiledSelector* compiled_selector = compiled_selectors_->front();
   const TreeScope& scope = root_node.ContainingTreeScope();
   SelectorChecker checker(SelectorChecker::kQueryingRules);
 
@@ -330,7 +346,8 @@ void SelectorQuery::ExecuteWithId(
       if (!element->IsDescendantOf(&root_node))
         continue;
       QUERY_STATS_INCREMENT(fast_id);
-      if (SelectorMatches(first_selector, *element, root_node, checker)) {
+      if (SelectorMatches(first_selector, compiled_selector, *element,
+                          root_node, checker)) {
         SelectorQueryTrait::AppendElement(output, *element);
         if (SelectorQueryTrait::kShouldOnlyMatchFirstElement)
           return;
@@ -346,7 +363,8 @@ void SelectorQuery::ExecuteWithId(
     if (!element->IsDescendantOf(&root_node))
       return;
     QUERY_STATS_INCREMENT(fast_id);
-    if (SelectorMatches(first_selector, *element, root_node, checker))
+    if (SelectorMatches(first_selector, compiled_selector, *element, root_node,
+                        checker))
       SelectorQueryTrait::AppendElement(output, *element);
     return;
   }
@@ -391,7 +409,7 @@ void SelectorQuery::Execute(
     switch (first_selector.Match()) {
       case CSSSelector::kClass:
         CollectElementsByClassName<SelectorQueryTrait>(
-            root_node, first_selector.Value(), nullptr, output);
+            root_node, first_selector.Value(), nullptr, nullptr, output);
         return;
       case CSSSelector::kTag:
         if (first_selector.TagQName().NamespaceURI() == g_star_atom) {
@@ -423,11 +441,15 @@ SelectorQuery::SelectorQuery(CSSSelectorList selector_list)
       selector_id_affected_by_sibling_combinator_(false),
       use_slow_scan_(true) {
   selectors_.ReserveInitialCapacity(selector_list_.ComputeLength());
+  compiled_selectors_ =
+      MakeGarbageCollected<HeapVector<Member<const CompiledSelector>>>();
+  compiled_selectors_->ReserveInitialCapacity(selector_list_.ComputeLength());
   for (const CSSSelector* selector = selector_list_.First(); selector;
        selector = CSSSelectorList::Next(*selector)) {
     if (selector->MatchesPseudoElement())
       continue;
     selectors_.UncheckedAppend(selector);
+    compiled_selectors_->UncheckedAppend(CompiledSelector::Compile(*selector));
   }
 
   if (selectors_.size() == 1) {
@@ -29,8 +29,11 @@
 
 #include <memory>
 
+#include "third_party/blink/renderer/core/css/compiled_selector.h"
 #include "third_party/blink/renderer/core/css/css_selector_list.h"
+#include "third_party/blink/renderer/platform/heap/collection_support/heap_vector.h"
 #include "third_party/blink/renderer/platform/heap/handle.h"
+#include "third_party/blink/renderer/platform/heap/persistent.h"
 #include "third_party/blink/renderer/platform/wtf/hash_map.h"
 #include "third_party/blink/renderer/platform/wtf/text/atomic_string_hash.h"
 #include "third_party/blink/renderer/platform/wtf/vector.h"
@@ -75,6 +78,10 @@ class CORE_EXPORT SelectorQuery {
     unsigned fast_scan;
     unsigned slow_scan;
     unsigned slow_traversing_shadow_tree_scan;
+    // Number of selector matches using a CompiledSelector, and using the
+    // recursive SelectorChecker matching. Not included in |total_count|.
+    unsigned compiled_selector_matches;
+    unsigned fallback_selector_matches;
   };
   // Used by unit tests to get information about what paths were taken during
   // the last query. Always reset between queries. This system is disabled in
@@ -110,6 +117,9 @@ class CORE_EXPORT SelectorQuery {
   // |selector_list_| will never be empty as SelectorQueryCache::add would have
   // thrown an exception.
   Vector<const CSSSelector*> selectors_;
+  // Compiled versions of |selectors_|, null for the ones which can't be
+  // compiled.
+  Persistent<HeapVector<Member<const CompiledSelector>>> compiled_selectors_;
   AtomicString selector_id_;
   bool selector_id_is_rightmost_ : 1;
   bool selector_id_affected_by_sibling_combinator_ : 1;
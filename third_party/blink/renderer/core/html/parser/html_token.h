@@ -34,6 +34,7 @@
 #include "third_party/blink/renderer/core/html/parser/html_parser_idioms.h"
 #include "third_party/blink/renderer/core/html/parser/literal_buffer.h"
 #include "third_party/blink/renderer/platform/wtf/forward.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_view.h"
 
 namespace blink {
 
@@ -129,6 +130,12 @@ class HTMLToken {
     String Value() const { return String(value_.data(), value_.size()); }
 
     void AppendToValue(UChar c) { value_.AddChar(c); }
+    void AppendToValue(const StringView& characters) {
+      if (characters.Is8Bit())
+        value_.Append(characters.Characters8(), characters.length());
+      else
+        value_.Append(characters.Characters16(), characters.length());
+    }
     void ClearValue() { value_.clear(); }
 
     const Range& NameRange() const { return name_range_; }
@@ -361,6 +368,12 @@ class HTMLToken {
     current_attribute_->AppendToValue(character);
   }
 
+  void AppendToAttributeValue(const StringView& characters) {
+    DCHECK(type_ == kStartTag || type_ == kEndTag);
+    current_attribute_->ValueRange().CheckValidStart();
+    current_attribute_->AppendToValue(characters);
+  }
+
   const AttributeList& Attributes() const {
     DCHECK(type_ == kStartTag || type_ == kEndTag);
     return attributes_;
@@ -404,6 +417,11 @@ class HTMLToken {
     data_.AppendLiteral(characters);
   }
 
+  void AppendToCharacter(const StringView& characters) {
+    DCHECK_EQ(type_, kCharacter);
+    AppendToData(characters);
+  }
+
   /* Comment Tokens */
 
   const DataVector& Comment() const {
@@ -423,7 +441,23 @@ class HTMLToken {
     or_all_data_ |= character;
   }
 
+  void AppendToComment(const StringView& characters) {
+    DCHECK_EQ(type_, kComment);
+    AppendToData(characters);
+  }
+
  private:
+  void AppendToData(const StringView& characters) {
+    if (characters.Is8Bit()) {
+      data_.Append(characters.Characters8(), characters.length());
+      return;
+    }
+    const UChar* chars = characters.Characters16();
+    data_.Append(chars, characters.length());
+    for (wtf_size_t i = 0; i < characters.length(); ++i)
+      or_all_data_ |= chars[i];
+  }
+
   TokenType type_;
   Attribute::Range range_;  // Always starts at zero.
   int base_offset_;
@@ -140,6 +140,8 @@ static inline bool VectorEqualsString(const LiteralBuffer<LChar, 32>& vector,
 #define HTML_CONSUME(stateName) CONSUME(HTMLTokenizer, stateName)
 #define HTML_CONSUME_NON_NEWLINE(stateName) \
   CONSUME_NON_NEWLINE(HTMLTokenizer, stateName)
+#define HTML_CONSUME_RUN(stateName, run) \
+  CONSUME_RUN(HTMLTokenizer, stateName, run)
 #define HTML_SWITCH_TO(stateName) SWITCH_TO(HTMLTokenizer, stateName)
 
 HTMLTokenizer::HTMLTokenizer(const HTMLParserOptions& options)
@@ -257,8 +259,16 @@ bool HTMLTokenizer::NextToken(SegmentedString& source, HTMLToken& token) {
 
     HTML_BEGIN_STATE(kRCDATAState) {
       while (!CheckScanFlag(cc, ScanFlags::kRCDATASpecial)) {
-        BufferCharacter(cc);
-        if (!input_stream_preprocessor_.Advance(source, cc))
+        StringView run = source.CurrentRun('&', '<');
+        if (run.IsEmpty()) {
+          // |cc| is a preprocessed '\r' or null character.
+          BufferCharacter(cc);
+          if (!input_stream_preprocessor_.Advance(source, cc))
+            return HaveBufferedCharacterToken();
+          continue;
+        }
+        BufferCharacters(run);
+        if (!input_stream_preprocessor_.AdvancePastRun(source, run, cc))
           return HaveBufferedCharacterToken();
       }
       if (cc == '&')
@@ -285,8 +295,13 @@ bool HTMLTokenizer::NextToken(SegmentedString& source, HTMLToken& token) {
       else if (cc == kEndOfFileMarker)
         return EmitEndOfFile(source);
       else {
-        BufferCharacter(cc);
-        HTML_CONSUME(kRAWTEXTState);
+        StringView run = source.CurrentRun('<');
+        if (run.IsEmpty()) {
+          BufferCharacter(cc);
+          HTML_CONSUME(kRAWTEXTState);
+        }
+        BufferCharacters(run);
+        HTML_CONSUME_RUN(kRAWTEXTState, run);
       }
     }
     END_STATE()
@@ -297,8 +312,13 @@ bool HTMLTokenizer::NextToken(SegmentedString& source, HTMLToken& token) {
       else if (cc == kEndOfFileMarker)
         return EmitEndOfFile(source);
       else {
-        BufferCharacter(cc);
-        HTML_CONSUME(kScriptDataState);
+        StringView run = source.CurrentRun('<');
+        if (run.IsEmpty()) {
+          BufferCharacter(cc);
+          HTML_CONSUME(kScriptDataState);
+        }
+        BufferCharacters(run);
+        HTML_CONSUME_RUN(kScriptDataState, run);
       }
     }
     END_STATE()
@@ -894,8 +914,13 @@ bool HTMLTokenizer::NextToken(SegmentedString& source, HTMLToken& token) {
         token_->EndAttributeValue(source.NumberOfCharactersConsumed());
         HTML_RECONSUME_IN(kDataState);
       } else {
-        token_->AppendToAttributeValue(cc);
-        HTML_CONSUME(kAttributeValueDoubleQuotedState);
+        StringView run = source.CurrentRun('"', '&');
+        if (run.IsEmpty()) {
+          token_->AppendToAttributeValue(cc);
+          HTML_CONSUME(kAttributeValueDoubleQuotedState);
+        }
+        token_->AppendToAttributeValue(run);
+        HTML_CONSUME_RUN(kAttributeValueDoubleQuotedState, run);
       }
     }
     END_STATE()
@@ -913,8 +938,13 @@ bool HTMLTokenizer::NextToken(SegmentedString& source, HTMLToken& token) {
         token_->EndAttributeValue(source.NumberOfCharactersConsumed());
         HTML_RECONSUME_IN(kDataState);
       } else {
-        token_->AppendToAttributeValue(cc);
-        HTML_CONSUME(kAttributeValueSingleQuotedState);
+        StringView run = source.CurrentRun('\'', '&');
+        if (run.IsEmpty()) {
+          token_->AppendToAttributeValue(cc);
+          HTML_CONSUME(kAttributeValueSingleQuotedState);
+        }
+        token_->AppendToAttributeValue(run);
+        HTML_CONSUME_RUN(kAttributeValueSingleQuotedState, run);
       }
     }
     END_STATE()
@@ -1095,8 +1125,13 @@ bool HTMLTokenizer::NextToken(SegmentedString& source, HTMLToken& token) {
         ParseError();
         return EmitAndReconsumeIn(source, HTMLTokenizer::kDataState);
       } else {
-        token_->AppendToComment(cc);
-        HTML_CONSUME(kCommentState);
+        StringView run = source.CurrentRun('-');
+        if (run.IsEmpty()) {
+          token_->AppendToComment(cc);
+          HTML_CONSUME(kCommentState);
+        }
+        token_->AppendToComment(run);
+        HTML_CONSUME_RUN(kCommentState, run);
       }
     }
     END_STATE()
@@ -1587,8 +1622,15 @@ bool HTMLTokenizer::EmitData(SegmentedString& source, UChar cc) {
     cc = source.CurrentChar();
   while (true) {
     while (!CheckScanFlag(cc, ScanFlags::kCharacterTokenSpecial)) {
-      token_->AppendToCharacter(cc);
-      cc = source.AdvancePastNonNewline();
+      StringView run = source.CurrentRun('&', '<');
+      if (run.IsEmpty()) {
+        // |cc| replaced a null character.
+        token_->AppendToCharacter(cc);
+        cc = source.AdvancePastNonNewline();
+        continue;
+      }
+      token_->AppendToCharacter(run);
+      cc = source.AdvancePastRun(run);
     }
     switch (cc) {
       case '&':
@@ -1631,8 +1673,15 @@ bool HTMLTokenizer::EmitPLAINTEXT(SegmentedString& source, UChar cc) {
     cc = source.CurrentChar();
   while (true) {
     while (!CheckScanFlag(cc, ScanFlags::kNullOrNewline)) {
-      token_->AppendToCharacter(cc);
-      cc = source.AdvancePastNonNewline();
+      StringView run = source.CurrentRun();
+      if (run.IsEmpty()) {
+        // |cc| replaced a null character.
+        token_->AppendToCharacter(cc);
+        cc = source.AdvancePastNonNewline();
+        continue;
+      }
+      token_->AppendToCharacter(run);
+      cc = source.AdvancePastRun(run);
     }
     switch (cc) {
       case '\n':
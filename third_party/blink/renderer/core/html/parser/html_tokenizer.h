@@ -209,6 +209,11 @@ class CORE_EXPORT HTMLTokenizer {
     token_->AppendToCharacter(character);
   }
 
+  inline void BufferCharacters(const StringView& characters) {
+    token_->EnsureIsCharacterToken();
+    token_->AppendToCharacter(characters);
+  }
+
   inline bool EmitAndResumeIn(SegmentedString& source, State state) {
     SaveEndTagNameIfNeeded();
     state_ = state;
@@ -0,0 +1,136 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/blink/renderer/core/html/parser/html_parser_options.h"
+#include "third_party/blink/renderer/core/html/parser/html_token.h"
+#include "third_party/blink/renderer/core/html/parser/html_tokenizer.h"
+#include "third_party/blink/renderer/platform/text/segmented_string.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+
+namespace blink {
+
+namespace {
+
+// Measures the tokenizing throughput of a generated page mixing the states
+// which consume runs of characters: text, quoted attribute values, comments
+// and scripts. The page is tokenized whole, and in chunks the way network
+// data is pumped through the tokenizer.
+
+constexpr char kMetricPrefix[] = "HTMLTokenizer.";
+constexpr char kMetricThroughput[] = "throughput";
+constexpr char kMetricThroughputChunked[] = "throughput_chunked";
+
+// Each measurement tokenizes about this many bytes.
+constexpr size_t kBytesPerMeasurement = 64 * 1024 * 1024;
+constexpr unsigned kChunkSize = 4096;
+
+String MakePage(int sections) {
+  StringBuilder builder;
+  builder.Append("<!DOCTYPE html>\n<html>\n<head>\n<title>Page</title>\n");
+  builder.Append(
+      "<script>\nfunction init(items) {\n  for (let i = 0; i < "
+      "items.length; ++i)\n    items[i].addEventListener('click', onClick);"
+      "\n}\n</script>\n</head>\n<body>\n");
+  for (int i = 0; i < sections; ++i) {
+    builder.Append("<!-- Section ");
+    builder.AppendNumber(i);
+    builder.Append(" of the generated page. -->\n<div class=\"section card\" ");
+    builder.Append("data-title=\"A descriptive title for section ");
+    builder.AppendNumber(i);
+    builder.Append(
+        "\">\n  <h2>Heading</h2>\n  <p>Lorem ipsum dolor sit amet, "
+        "consectetur adipiscing elit, sed do eiusmod tempor incididunt ut\n  "
+        "labore et dolore magna aliqua. Ut enim ad minim veniam, quis "
+        "nostrud exercitation &amp; ullamco\n  laboris nisi ut aliquip ex ea "
+        "commodo consequat.</p>\n  <a href='https://example.com/articles/");
+    builder.AppendNumber(i);
+    builder.Append(
+        "?utm_source=generated&amp;utm_medium=benchmark'>Read more</a>\n"
+        "</div>\n");
+  }
+  builder.Append("</body>\n</html>\n");
+  return builder.ToString();
+}
+
+// Returns the number of tokens in |source|.
+size_t Tokenize(SegmentedString& source,
+                HTMLTokenizer& tokenizer,
+                HTMLToken& token) {
+  size_t tokens = 0;
+  while (tokenizer.NextToken(source, token)) {
+    if (token.GetType() == HTMLToken::kStartTag)
+      tokenizer.UpdateStateFor(token.GetName().AsString());
+    token.Clear();
+    ++tokens;
+  }
+  return tokens;
+}
+
+size_t TokenizeWhole(const String& html) {
+  HTMLParserOptions options;
+  HTMLTokenizer tokenizer(options);
+  HTMLToken token;
+  SegmentedString source(html);
+  return Tokenize(source, tokenizer, token);
+}
+
+size_t TokenizeInChunks(const String& html) {
+  HTMLParserOptions options;
+  HTMLTokenizer tokenizer(options);
+  HTMLToken token;
+  SegmentedString source;
+  size_t tokens = 0;
+  for (unsigned offset = 0; offset < html.length(); offset += kChunkSize) {
+    source.Append(SegmentedString(html.Substring(offset, kChunkSize)));
+    tokens += Tokenize(source, tokenizer, token);
+  }
+  return tokens;
+}
+
+void RunTokenizerBenchmark(const std::string& story, const String& html) {
+  const size_t bytes = html.CharactersSizeInBytes();
+  const size_t rounds = std::max<size_t>(kBytesPerMeasurement / bytes, 1);
+
+  // Warm up the caches before timing.
+  const size_t expected_tokens = TokenizeWhole(html);
+  ASSERT_GT(expected_tokens, 0u);
+
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story);
+  reporter.RegisterImportantMetric(kMetricThroughput, "MB/s");
+  reporter.RegisterImportantMetric(kMetricThroughputChunked, "MB/s");
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (size_t round = 0; round < rounds; ++round)
+    ASSERT_EQ(expected_tokens, TokenizeWhole(html));
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  reporter.AddResult(kMetricThroughput,
+                     rounds * bytes / 1e6 / elapsed.InSecondsF());
+
+  start = base::TimeTicks::Now();
+  for (size_t round = 0; round < rounds; ++round)
+    ASSERT_GE(TokenizeInChunks(html), expected_tokens);
+  elapsed = base::TimeTicks::Now() - start;
+  reporter.AddResult(kMetricThroughputChunked,
+                     rounds * bytes / 1e6 / elapsed.InSecondsF());
+}
+
+}  // namespace
+
+TEST(HTMLTokenizerPerfTest, Page) {
+  // About 800 KB.
+  String html = MakePage(1500);
+  RunTokenizerBenchmark("page", html);
+
+  html.Ensure16Bit();
+  RunTokenizerBenchmark("page_16bit", html);
+}
+
+}  // namespace blink
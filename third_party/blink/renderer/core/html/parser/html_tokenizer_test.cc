@@ -29,4 +29,69 @@ TEST(HTMLTokenizerTest, ZeroOffsetAttributeNameRange) {
   EXPECT_FALSE(tokenizer->NextToken(input2, token));
 }
 
+// Character data, attribute values and comments are consumed in runs up to
+// the next character which needs a closer look.
+TEST(HTMLTokenizerTest, Runs) {
+  HTMLParserOptions options;
+  std::unique_ptr<HTMLTokenizer> tokenizer =
+      std::make_unique<HTMLTokenizer>(options);
+  HTMLToken token;
+
+  SegmentedString input(
+      "<p title=\"line 1\r\nline 2 &amp; more\" class='x'>Text long enough "
+      "to fill a vector register\r\nline 2</p><!-- comment longer than "
+      "sixteen characters -- still -->");
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kStartTag, token.GetType());
+  ASSERT_EQ(2u, token.Attributes().size());
+  EXPECT_EQ("line 1\nline 2 & more", token.Attributes()[0].Value());
+  EXPECT_EQ("x", token.Attributes()[1].Value());
+  token.Clear();
+
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kCharacter, token.GetType());
+  EXPECT_EQ("Text long enough to fill a vector register\nline 2",
+            token.Characters().AsString());
+  EXPECT_EQ(2, input.CurrentLine().ZeroBasedInt());
+  EXPECT_EQ(6, input.CurrentColumn().ZeroBasedInt());
+  token.Clear();
+
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kEndTag, token.GetType());
+  token.Clear();
+
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kComment, token.GetType());
+  EXPECT_EQ(" comment longer than sixteen characters -- still ",
+            token.Comment().AsString());
+}
+
+TEST(HTMLTokenizerTest, ScriptDataRunsAcrossSegments) {
+  HTMLParserOptions options;
+  std::unique_ptr<HTMLTokenizer> tokenizer =
+      std::make_unique<HTMLTokenizer>(options);
+  HTMLToken token;
+
+  SegmentedString input("<script>");
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kStartTag, token.GetType());
+  tokenizer->UpdateStateFor("script");
+  token.Clear();
+
+  input.Append(SegmentedString(u"var s = \"\u4E2D\u6587\";\r"));
+  input.Append(SegmentedString("\nf("));
+  input.Append(SegmentedString(String(u"\0", 1u)));
+  input.Append(SegmentedString(");</script>"));
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kCharacter, token.GetType());
+  EXPECT_EQ(String(u"var s = \"\u4E2D\u6587\";\nf(\uFFFD);"),
+            token.Characters().AsString());
+  EXPECT_FALSE(token.IsAll8BitData());
+  EXPECT_EQ(1, input.CurrentLine().ZeroBasedInt());
+  token.Clear();
+
+  EXPECT_TRUE(tokenizer->NextToken(input, token));
+  EXPECT_EQ(HTMLToken::kEndTag, token.GetType());
+}
+
 }  // namespace blink
@@ -69,6 +69,15 @@ class InputStreamPreprocessor {
     return ProcessNextInputCharacter(source, cc);
   }
 
+  // Consumes |run|, which SegmentedString::CurrentRun() returned. Only its
+  // newlines could need preprocessing, and none of them follows a '\r'.
+  ALWAYS_INLINE bool AdvancePastRun(SegmentedString& source,
+                                    const StringView& run,
+                                    UChar& cc) {
+    cc = source.AdvancePastRun(run);
+    return ProcessNextInputCharacter(source, cc);
+  }
+
   // WARNING: This does not process null characters.
   ALWAYS_INLINE bool AdvancePastCarriageReturn(SegmentedString& source,
                                                UChar& cc) {
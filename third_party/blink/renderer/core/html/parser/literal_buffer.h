@@ -102,13 +102,17 @@ class LiteralBuffer {
 
   template <typename OtherT, wtf_size_t kOtherSize>
   void AppendLiteral(const LiteralBuffer<OtherT, kOtherSize>& val) {
+    Append(val.data(), val.size());
+  }
+
+  template <typename OtherT>
+  void Append(const OtherT* characters, size_t count) {
     static_assert(sizeof(T) >= sizeof(OtherT),
                   "T is not big enough to contain OtherT");
-    size_t count = val.size();
     size_t new_size = size() + count;
     if (capacity() < new_size)
       Grow(new_size);
-    std::copy_n(val.data(), count, end_);
+    std::copy_n(characters, count, end_);
     end_ += count;
   }
 
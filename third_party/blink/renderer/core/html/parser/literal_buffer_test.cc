@@ -49,6 +49,16 @@ TEST(LiteralBufferTest, AppendLiteral) {
   EXPECT_EQ(memcmp(buf.data(), u"defabc", buf.size()), 0);
 }
 
+TEST(LiteralBufferTest, Append) {
+  LiteralBuffer<UChar, 4> buf;
+  buf.AddChar('a');
+  buf.Append(reinterpret_cast<const LChar*>("bcdef"), 5);
+  buf.Append(u"gh", 2);
+
+  EXPECT_EQ(8ul, buf.size());
+  EXPECT_EQ(memcmp(buf.data(), u"abcdefgh", buf.size()), 0);
+}
+
 TEST(LiteralBufferTest, Copy) {
   LiteralBuffer<LChar, 16> lit;
   lit.AddChar('a');
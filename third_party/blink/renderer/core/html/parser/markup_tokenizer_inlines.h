@@ -117,6 +117,16 @@ inline void AdvanceStringAndASSERT(SegmentedString& source,
     goto stateName;                                                    \
   } while (false)
 
+// Similar to CONSUME, but we use this macro to consume |run|, the characters
+// from the current one which SegmentedString::CurrentRun() returned.
+#define CONSUME_RUN(prefix, stateName, run)                          \
+  do {                                                               \
+    DCHECK_EQ(state_, prefix::stateName);                            \
+    if (!input_stream_preprocessor_.AdvancePastRun(source, run, cc)) \
+      return HaveBufferedCharacterToken();                           \
+    goto stateName;                                                  \
+  } while (false)
+
 // Sometimes there's more complicated logic in the spec that separates when
 // we consume the next input character and when we switch to a particular
 // state. We handle those cases by advancing the source directly and using
@@ -18,6 +18,7 @@
 #include "base/metrics/histogram_macros.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/process/memory.h"
+#include "base/strings/strcat.h"
 #include "base/task/single_thread_task_runner.h"
 #include "base/timer/elapsed_timer.h"
 #include "base/trace_event/typed_macros.h"
@@ -26,6 +27,7 @@
 #include "third_party/blink/renderer/platform/crypto.h"
 #include "third_party/blink/renderer/platform/disk_data_allocator.h"
 #include "third_party/blink/renderer/platform/instrumentation/tracing/web_process_memory_dump.h"
+#include "third_party/blink/renderer/platform/parking_codec.h"
 #include "third_party/blink/renderer/platform/scheduler/public/post_cross_thread_task.h"
 #include "third_party/blink/renderer/platform/scheduler/public/thread.h"
 #include "third_party/blink/renderer/platform/scheduler/public/worker_pool.h"
@@ -36,7 +38,6 @@
 #include "third_party/blink/renderer/platform/wtf/sanitizers.h"
 #include "third_party/blink/renderer/platform/wtf/thread_specific.h"
 #include "third_party/blink/renderer/platform/wtf/vector.h"
-#include "third_party/zlib/google/compression_utils.h"
 
 namespace blink {
 
@@ -96,6 +97,33 @@ void RecordStatistics(size_t size,
   base::UmaHistogramCounts1000(throughput_histogram, throughput_mb_s);
 }
 
+// Same as the compression and decompression histograms above, split by codec.
+void RecordCodecStatistics(size_t size,
+                           base::TimeDelta duration,
+                           ParkingAction action,
+                           parking_codec::Codec codec) {
+  DCHECK(action == ParkingAction::kParked ||
+         action == ParkingAction::kUnparked);
+  int throughput_mb_s =
+      base::ClampRound(size / duration.InSecondsF() / 1000000);
+  const char* prefix = action == ParkingAction::kParked
+                           ? "Memory.ParkableString.Compression."
+                           : "Memory.ParkableString.Decompression.";
+  const char* codec_name = parking_codec::GetName(codec);
+
+  base::UmaHistogramCustomMicrosecondsTimes(
+      base::StrCat({prefix, codec_name, ".Latency"}), duration,
+      base::Microseconds(500), base::Seconds(1), 100);
+  base::UmaHistogramCounts1000(
+      base::StrCat({prefix, codec_name, ".ThroughputMBps"}), throughput_mb_s);
+}
+
+parking_codec::Codec GetCompressionCodec() {
+  return base::FeatureList::IsEnabled(kParkableStringsUseSnappy)
+             ? parking_codec::Codec::kSnappy
+             : parking_codec::Codec::kZlib;
+}
+
 void AsanPoisonString(const String& string) {
 #if defined(ADDRESS_SANITIZER)
   if (string.IsNull())
@@ -159,11 +187,13 @@ struct BackgroundTaskParams final {
       scoped_refptr<ParkableStringImpl> string,
       const void* data,
       size_t size,
+      parking_codec::Codec codec,
       scoped_refptr<base::SingleThreadTaskRunner> callback_task_runner)
       : callback_task_runner(callback_task_runner),
         string(string),
         data(data),
-        size(size) {}
+        size(size),
+        codec(codec) {}
 
   BackgroundTaskParams(const BackgroundTaskParams&) = delete;
   BackgroundTaskParams& operator=(const BackgroundTaskParams&) = delete;
@@ -173,6 +203,7 @@ struct BackgroundTaskParams final {
   const scoped_refptr<ParkableStringImpl> string;
   const void* data;
   const size_t size;
+  const parking_codec::Codec codec;
 };
 
 // Valid transitions are:
@@ -224,6 +255,7 @@ ParkableStringImpl::ParkableMetadata::ParkableMetadata(
       lock_depth_(0),
       state_(State::kUnparked),
       background_task_in_progress_(false),
+      codec_(parking_codec::Codec::kZlib),
       compressed_(nullptr),
       digest_(*digest),
       age_(Age::kYoung),
@@ -308,6 +340,13 @@ void ParkableStringImpl::Lock() {
   // Make young as this is a strong (but not certain) indication that the string
   // will be accessed soon.
   MakeYoung();
+  // For the same reason, start reading the data if it is on disk, so that
+  // unparking doesn't block on the disk. State is only accessed on the main
+  // thread, and parkable strings are only created there.
+  if (IsMainThread() && is_on_disk()) {
+    ParkableStringManager::Instance().data_allocator().Prefetch(
+        *metadata_->on_disk_metadata_);
+  }
 }
 
 void ParkableStringImpl::Unlock() {
@@ -317,6 +356,13 @@ void ParkableStringImpl::Unlock() {
   MutexLocker locker(metadata_->mutex_);
   metadata_->lock_depth_ -= 1;
   CHECK_NE(metadata_->lock_depth_, std::numeric_limits<unsigned int>::max());
+  // The data prefetched by |Lock()| is not needed anymore if the string was
+  // not unparked while locked. As in |Lock()|, state is only accessed on the
+  // main thread.
+  if (metadata_->lock_depth_ == 0 && IsMainThread() && is_on_disk()) {
+    ParkableStringManager::Instance().data_allocator().CancelPrefetch(
+        *metadata_->on_disk_metadata_);
+  }
 
 #if defined(ADDRESS_SANITIZER) && DCHECK_IS_ON()
   // There are no external references to the data, nobody should touch the data.
@@ -582,45 +628,45 @@ String ParkableStringImpl::UnparkInternal() {
   }
 
   TRACE_EVENT("blink", "ParkableStringImpl::Decompress");
-  base::StringPiece compressed_string_piece(
-      reinterpret_cast<const char*>(metadata_->compressed_->data()),
-      metadata_->compressed_->size() * sizeof(uint8_t));
+  base::span<const uint8_t> compressed(*metadata_->compressed_);
   String uncompressed;
-  base::StringPiece uncompressed_string_piece;
+  base::span<uint8_t> uncompressed_span;
   size_t size = CharactersSizeInBytes();
   if (is_8bit()) {
     LChar* data;
     uncompressed = String::CreateUninitialized(length(), data);
-    uncompressed_string_piece =
-        base::StringPiece(reinterpret_cast<const char*>(data), size);
+    uncompressed_span =
+        base::make_span(reinterpret_cast<uint8_t*>(data), size);
   } else {
     UChar* data;
     uncompressed = String::CreateUninitialized(length(), data);
-    uncompressed_string_piece =
-        base::StringPiece(reinterpret_cast<const char*>(data), size);
+    uncompressed_span =
+        base::make_span(reinterpret_cast<uint8_t*>(data), size);
   }
 
   // If the buffer size is incorrect, then we have a corrupted data issue,
   // and in such case there is nothing else to do than crash.
-  CHECK_EQ(compression::GetUncompressedSize(compressed_string_piece),
-           uncompressed_string_piece.size());
+  CHECK_EQ(parking_codec::GetUncompressedSize(metadata_->codec_, compressed),
+           uncompressed_span.size());
   // If decompression fails, this is either because:
   // 1. Compressed data is corrupted
   // 2. Cannot allocate memory in zlib
   //
   // (1) is data corruption, and (2) is OOM. In all cases, we cannot
   // recover the string we need, nothing else to do than to abort.
-  if (!compression::GzipUncompress(compressed_string_piece,
-                                   uncompressed_string_piece)) {
+  if (!parking_codec::Decompress(metadata_->codec_, compressed,
+                                 uncompressed_span)) {
     // Since this is almost always OOM, report it as such. We don't have
     // certainty, but memory corruption should be much rarer, and could make us
     // crash anywhere else.
-    OOM_CRASH(uncompressed_string_piece.size());
+    OOM_CRASH(uncompressed_span.size());
   }
 
   base::TimeDelta elapsed = timer.Elapsed();
   manager.RecordUnparkingTime(elapsed);
   RecordStatistics(CharactersSizeInBytes(), elapsed, ParkingAction::kUnparked);
+  RecordCodecStatistics(CharactersSizeInBytes(), elapsed,
+                        ParkingAction::kUnparked, metadata_->codec_);
 
   return uncompressed;
 }
@@ -633,7 +679,7 @@ void ParkableStringImpl::PostBackgroundCompressionTask() {
   // |params| keeps |this| alive until |OnParkingCompleteOnMainThread()|.
   auto params = std::make_unique<BackgroundTaskParams>(
       this, string_.Bytes(), string_.CharactersSizeInBytes(),
-      Thread::Current()->GetTaskRunner());
+      GetCompressionCodec(), Thread::Current()->GetTaskRunner());
   worker_pool::PostTask(
       FROM_HERE, CrossThreadBindOnce(&ParkableStringImpl::CompressInBackground,
                                      std::move(params)));
@@ -664,8 +710,8 @@ void ParkableStringImpl::CompressInBackground(
   // Compression touches the string.
   AsanUnpoisonString(params->string->string_);
   bool ok;
-  base::StringPiece data(reinterpret_cast<const char*>(params->data),
-                         params->size);
+  base::span<const uint8_t> data(reinterpret_cast<const uint8_t*>(params->data),
+                                 params->size);
   std::unique_ptr<Vector<uint8_t>> compressed;
 
   // This runs in background, making CPU starvation likely, and not an issue.
@@ -677,8 +723,9 @@ void ParkableStringImpl::CompressInBackground(
     // discovered compressed size. This is done as a memory saving measure
     // because Vector::Shrink() does not resize the memory allocation.
     //
-    // The temporary buffer has the same size as the initial data. Compression
-    // will fail if this is not large enough.
+    // The temporary buffer has the same size as the initial data, or the
+    // worst-case compressed size for codecs that require it. Compression fails
+    // if the compressed data is not smaller than the initial data.
     //
     // This is not using:
     // - malloc() or any STL container: this is discouraged in blink, and there
@@ -686,18 +733,17 @@ void ParkableStringImpl::CompressInBackground(
     // - WTF::Vector<> as allocation failures result in an OOM crash, whereas
     //   we can fail gracefully. See crbug.com/905777 for an example of OOM
     //   triggered from there.
-    NullableCharBuffer buffer(params->size);
+    NullableCharBuffer buffer(
+        parking_codec::GetMaxCompressedSize(params->codec, params->size));
     ok = buffer.data();
     size_t compressed_size;
     if (ok) {
-      // Use partition alloc for zlib's temporary data. This is crucial to avoid
-      // leaking memory on Android, see the details in crbug.com/931553.
-      auto fast_malloc = [](size_t size) {
-        return WTF::Partitions::FastMalloc(size, "ZlibTemporaryData");
-      };
-      ok = compression::GzipCompress(data, buffer.data(), buffer.size(),
-                                     &compressed_size, fast_malloc,
-                                     WTF::Partitions::FastFree);
+      ok = parking_codec::Compress(
+          params->codec, data,
+          base::make_span(reinterpret_cast<uint8_t*>(buffer.data()),
+                          buffer.size()),
+          &compressed_size);
+      ok = ok && compressed_size < params->size;
     }
 
 #if defined(ADDRESS_SANITIZER)
@@ -716,6 +762,7 @@ void ParkableStringImpl::CompressInBackground(
 
   auto* task_runner = params->callback_task_runner.get();
   size_t size = params->size;
+  parking_codec::Codec codec = params->codec;
   PostCrossThreadTask(
       *task_runner, FROM_HERE,
       CrossThreadBindOnce(
@@ -727,7 +774,9 @@ void ParkableStringImpl::CompressInBackground(
                 std::move(params), std::move(compressed), parking_thread_time);
           },
           std::move(params), std::move(compressed), thread_elapsed));
-  RecordStatistics(size, timer.Elapsed(), ParkingAction::kParked);
+  base::TimeDelta elapsed = timer.Elapsed();
+  RecordStatistics(size, elapsed, ParkingAction::kParked);
+  RecordCodecStatistics(size, elapsed, ParkingAction::kParked, codec);
 }
 
 void ParkableStringImpl::OnParkingCompleteOnMainThread(
@@ -743,8 +792,10 @@ void ParkableStringImpl::OnParkingCompleteOnMainThread(
   // uncompressed representation cannot be discarded now, avoid compressing
   // multiple times. This will allow synchronous parking next time.
   DCHECK(!metadata_->compressed_);
-  if (compressed)
+  if (compressed) {
     metadata_->compressed_ = std::move(compressed);
+    metadata_->codec_ = params->codec;
+  }
 
   // Between |Park()| and now, things may have happened:
   // 1. |ToString()| or
@@ -772,38 +823,40 @@ void ParkableStringImpl::PostBackgroundWritingTask() {
     metadata_->background_task_in_progress_ = true;
     auto params = std::make_unique<BackgroundTaskParams>(
         this, metadata_->compressed_->data(), metadata_->compressed_->size(),
-        Thread::Current()->GetTaskRunner());
-    worker_pool::PostTask(
-        FROM_HERE, {base::MayBlock()},
-        CrossThreadBindOnce(&ParkableStringImpl::WriteToDiskInBackground,
-                            std::move(params),
-                            WTF::CrossThreadUnretained(&data_allocator)));
+        metadata_->codec_, Thread::Current()->GetTaskRunner());
+    // |params| keeps |this| and the compressed data alive until
+    // |OnWritingCompleteOnMainThread()|.
+    const void* data = params->data;
+    size_t size = params->size;
+    data_allocator.ScheduleWrite(
+        data, size,
+        CrossThreadBindOnce(
+            [](std::unique_ptr<BackgroundTaskParams> params,
+               std::unique_ptr<DiskDataMetadata> metadata,
+               base::TimeDelta elapsed) {
+              // Called on the thread which wrote the data. Failed writes don't
+              // have a meaningful duration.
+              if (metadata) {
+                RecordStatistics(params->size, elapsed,
+                                 ParkingAction::kWritten);
+              }
+              auto* task_runner = params->callback_task_runner.get();
+              PostCrossThreadTask(
+                  *task_runner, FROM_HERE,
+                  CrossThreadBindOnce(
+                      [](std::unique_ptr<BackgroundTaskParams> params,
+                         std::unique_ptr<DiskDataMetadata> metadata,
+                         base::TimeDelta elapsed) {
+                        auto* string = params->string.get();
+                        string->OnWritingCompleteOnMainThread(
+                            std::move(params), std::move(metadata), elapsed);
+                      },
+                      std::move(params), std::move(metadata), elapsed));
+            },
+            std::move(params)));
   }
 }
 
-// static
-void ParkableStringImpl::WriteToDiskInBackground(
-    std::unique_ptr<BackgroundTaskParams> params,
-    DiskDataAllocator* data_allocator) {
-  base::ElapsedTimer timer;
-  auto metadata = data_allocator->Write(params->data, params->size);
-  base::TimeDelta elapsed = timer.Elapsed();
-  RecordStatistics(params->size, elapsed, ParkingAction::kWritten);
-
-  auto* task_runner = params->callback_task_runner.get();
-  PostCrossThreadTask(
-      *task_runner, FROM_HERE,
-      CrossThreadBindOnce(
-          [](std::unique_ptr<BackgroundTaskParams> params,
-             std::unique_ptr<DiskDataMetadata> metadata,
-             base::TimeDelta elapsed) {
-            auto* string = params->string.get();
-            string->OnWritingCompleteOnMainThread(std::move(params),
-                                                  std::move(metadata), elapsed);
-          },
-          std::move(params), std::move(metadata), elapsed));
-}
-
 void ParkableStringImpl::OnWritingCompleteOnMainThread(
     std::unique_ptr<BackgroundTaskParams> params,
     std::unique_ptr<DiskDataMetadata> on_disk_metadata,
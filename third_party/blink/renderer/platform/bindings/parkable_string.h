@@ -37,6 +37,10 @@ class DiskDataAllocator;
 class WebProcessMemoryDump;
 struct BackgroundTaskParams;
 
+namespace parking_codec {
+enum class Codec : uint8_t;
+}
+
 // A parked string is parked by calling |Park()|, and unparked by calling
 // |ToString()| on a parked string.
 // |Lock()| does *not* unpark a string, and |ToString()| must be called on
@@ -207,9 +211,9 @@ class PLATFORM_EXPORT ParkableStringImpl final
       std::unique_ptr<Vector<uint8_t>> compressed,
       base::TimeDelta parking_thread_time);
 
+  // Schedules a write of the compressed data with the disk allocator, which
+  // batches it with the writes of other strings.
   void PostBackgroundWritingTask() EXCLUSIVE_LOCKS_REQUIRED(metadata_->mutex_);
-  static void WriteToDiskInBackground(std::unique_ptr<BackgroundTaskParams>,
-                                      DiskDataAllocator* data_allocator);
   // Called on the main thread after writing is done.
   // |params| is the same as the one passed to PostBackgroundWritingTask()|,
   // |metadata| is the on-disk metadata, nullptr if writing failed.
@@ -239,6 +243,8 @@ class PLATFORM_EXPORT ParkableStringImpl final
     // Main thread only.
     State state_;
     bool background_task_in_progress_;
+    // Codec used to compress |compressed_|, also used for the on-disk data.
+    parking_codec::Codec codec_;
     std::unique_ptr<Vector<uint8_t>> compressed_;
     std::unique_ptr<DiskDataMetadata> on_disk_metadata_;
     const SecureDigest digest_;
@@ -28,6 +28,9 @@
 
 namespace blink {
 
+const base::Feature kParkableStringsUseSnappy{"ParkableStringsUseSnappy",
+                                              base::FEATURE_DISABLED_BY_DEFAULT};
+
 struct ParkableStringManager::Statistics {
   size_t original_size;
   size_t uncompressed_size;
@@ -150,6 +153,8 @@ bool ParkableStringManager::OnMemoryDump(
                   data_allocator().disk_footprint());
   dump->AddScalar("on_disk_free_chunks", "bytes",
                   data_allocator().free_chunks_size());
+  dump->AddScalar("on_disk_prefetched_size", "bytes",
+                  data_allocator().prefetched_size());
 
   pmd->AddSuballocation(dump->guid(),
                         WTF::Partitions::kAllocatedObjectPoolName);
@@ -27,6 +27,10 @@ namespace blink {
 class DiskDataAllocator;
 class ParkableString;
 
+// Compresses parkable strings with Snappy rather than zlib. Parking and
+// unparking are several times faster, at the cost of a worse ratio.
+PLATFORM_EXPORT extern const base::Feature kParkableStringsUseSnappy;
+
 class PLATFORM_EXPORT ParkableStringManagerDumpProvider
     : public base::trace_event::MemoryDumpProvider {
   USING_FAST_MALLOC(ParkableStringManagerDumpProvider);
@@ -135,6 +135,22 @@ class ParkableStringTest : public ::testing::Test {
     ParkableStringManager::Instance().SetDataAllocatorForTesting(nullptr);
   }
 
+  InMemoryDataAllocator& data_allocator() {
+    return static_cast<InMemoryDataAllocator&>(
+        ParkableStringManager::Instance().data_allocator());
+  }
+
+  // Makes the parked |parkable| very old, and schedules writing it to disk
+  // without waiting for the write.
+  void ScheduleDiskWrite(const ParkableString& parkable) {
+    ParkableStringImpl* impl = parkable.Impl();
+    EXPECT_TRUE(impl->is_parked());
+    impl->MaybeAgeOrParkString();
+    EXPECT_EQ(ParkableStringImpl::Age::kVeryOld, impl->age_for_testing());
+    impl->MaybeAgeOrParkString();
+    EXPECT_TRUE(impl->background_task_in_progress_for_testing());
+  }
+
   base::test::TaskEnvironment task_environment_;
 };
 
@@ -763,6 +779,135 @@ TEST_F(ParkableStringTest, SynchronousToDisk) {
       "Memory.ParkableString.Read.SinceLastDiskWrite", 2);
 }
 
+TEST_F(ParkableStringTest, DiskWritesAreBatched) {
+  ParkableString parkable_a(MakeLargeString('a').ReleaseImpl());
+  ParkableString parkable_b(MakeLargeString('b').ReleaseImpl());
+  ParkableString parkable_c(MakeLargeString('c').ReleaseImpl());
+
+  EXPECT_TRUE(ParkAndWait(parkable_a));
+  EXPECT_TRUE(ParkAndWait(parkable_b));
+  EXPECT_TRUE(ParkAndWait(parkable_c));
+  ScheduleDiskWrite(parkable_a);
+  ScheduleDiskWrite(parkable_b);
+  ScheduleDiskWrite(parkable_c);
+  EXPECT_EQ(0, data_allocator().write_count());
+
+  RunPostedTasks();
+  EXPECT_TRUE(parkable_a.Impl()->is_on_disk());
+  EXPECT_TRUE(parkable_b.Impl()->is_on_disk());
+  EXPECT_TRUE(parkable_c.Impl()->is_on_disk());
+  // The three strings are contiguous on disk, and written at once.
+  EXPECT_EQ(1, data_allocator().write_count());
+
+  EXPECT_EQ(MakeLargeString('a'), parkable_a.ToString());
+  EXPECT_EQ(MakeLargeString('b'), parkable_b.ToString());
+  EXPECT_EQ(MakeLargeString('c'), parkable_c.ToString());
+}
+
+TEST_F(ParkableStringTest, LockPrefetchesFromDisk) {
+  ParkableString parkable(MakeLargeString('a').ReleaseImpl());
+  ParkableStringImpl* impl = parkable.Impl();
+  EXPECT_TRUE(ParkAndWait(parkable));
+  ScheduleDiskWrite(parkable);
+  RunPostedTasks();
+  ASSERT_TRUE(impl->is_on_disk());
+
+  // Locking hints that the string is about to be used, reading starts in the
+  // background.
+  parkable.Lock();
+  EXPECT_TRUE(impl->is_on_disk());
+  RunPostedTasks();
+  EXPECT_EQ(1, data_allocator().read_count());
+
+  // Unparking doesn't read from disk again.
+  EXPECT_EQ(MakeLargeString('a'), parkable.ToString());
+  EXPECT_FALSE(impl->is_on_disk());
+  EXPECT_EQ(1, data_allocator().read_count());
+  parkable.Unlock();
+}
+
+TEST_F(ParkableStringTest, UnlockDropsPrefetchedData) {
+  ParkableString parkable(MakeLargeString('a').ReleaseImpl());
+  ParkableStringImpl* impl = parkable.Impl();
+  EXPECT_TRUE(ParkAndWait(parkable));
+  ScheduleDiskWrite(parkable);
+  RunPostedTasks();
+  ASSERT_TRUE(impl->is_on_disk());
+
+  parkable.Lock();
+  RunPostedTasks();
+  EXPECT_EQ(1, data_allocator().read_count());
+  EXPECT_EQ(impl->on_disk_size(), data_allocator().prefetched_size());
+
+  // The string was not used while locked, its data is not kept in memory.
+  parkable.Unlock();
+  EXPECT_TRUE(impl->is_on_disk());
+  EXPECT_EQ(0u, data_allocator().prefetched_size());
+
+  EXPECT_EQ(MakeLargeString('a'), parkable.ToString());
+  EXPECT_EQ(2, data_allocator().read_count());
+}
+
+class ParkableStringSnappyTest : public ParkableStringTest {
+ public:
+  ParkableStringSnappyTest() {
+    features_.InitAndEnableFeature(kParkableStringsUseSnappy);
+  }
+
+ private:
+  base::test::ScopedFeatureList features_;
+};
+
+TEST_F(ParkableStringSnappyTest, ParkUnparkIdenticalContent) {
+  base::HistogramTester histogram_tester;
+
+  ParkableString parkable(MakeLargeString().ReleaseImpl());
+  EXPECT_TRUE(ParkAndWait(parkable));
+  EXPECT_TRUE(parkable.Impl()->is_parked());
+  EXPECT_LT(parkable.Impl()->compressed_size(), kSizeKb * 1000);
+
+  EXPECT_EQ(MakeLargeString(), parkable.ToString());
+
+  histogram_tester.ExpectTotalCount(
+      "Memory.ParkableString.Compression.Snappy.Latency", 1);
+  histogram_tester.ExpectTotalCount(
+      "Memory.ParkableString.Compression.Snappy.ThroughputMBps", 1);
+  histogram_tester.ExpectTotalCount(
+      "Memory.ParkableString.Decompression.Snappy.Latency", 1);
+  histogram_tester.ExpectTotalCount(
+      "Memory.ParkableString.Decompression.Snappy.ThroughputMBps", 1);
+  histogram_tester.ExpectTotalCount(
+      "Memory.ParkableString.Compression.Zlib.Latency", 0);
+  // The codec-independent histograms are still recorded.
+  histogram_tester.ExpectUniqueSample(
+      "Memory.ParkableString.Compression.SizeKb", kSizeKb, 1);
+}
+
+TEST_F(ParkableStringSnappyTest, DontCompressRandomString) {
+  Vector<unsigned char> data(kSizeKb * 1000);
+  base::RandBytes(data.data(), data.size());
+  ParkableString parkable(String(data.data(), data.size()).ReleaseImpl());
+
+  EXPECT_TRUE(
+      parkable.Impl()->Park(ParkableStringImpl::ParkingMode::kCompress));
+  RunPostedTasks();
+  // Not parked because the compressed data is larger than the string.
+  EXPECT_FALSE(parkable.Impl()->is_parked());
+}
+
+TEST_F(ParkableStringSnappyTest, ToAndFromDisk) {
+  ParkableString parkable(MakeLargeString('a').ReleaseImpl());
+  ParkableStringImpl* impl = parkable.Impl();
+  EXPECT_TRUE(ParkAndWait(parkable));
+  ScheduleDiskWrite(parkable);
+  RunPostedTasks();
+  EXPECT_TRUE(impl->is_on_disk());
+  EXPECT_LT(impl->on_disk_size(), kSizeKb * 1000);
+
+  EXPECT_EQ(MakeLargeString('a'), parkable.ToString());
+  EXPECT_FALSE(impl->is_on_disk());
+}
+
 TEST_F(ParkableStringTest, OnPurgeMemory) {
   ParkableString parkable1 = CreateAndParkAll();
   ParkableString parkable2(MakeLargeString('b').ReleaseImpl());
@@ -865,6 +1010,9 @@ TEST_F(ParkableStringTest, ReportMemoryDump) {
   MemoryAllocatorDump::Entry on_disk_free_chunks =
       MemoryAllocatorDump::Entry("on_disk_free_chunks", "bytes", 0);
   EXPECT_THAT(dump->entries(), Contains(Eq(ByRef(on_disk_free_chunks))));
+  MemoryAllocatorDump::Entry on_disk_prefetched_size =
+      MemoryAllocatorDump::Entry("on_disk_prefetched_size", "bytes", 0);
+  EXPECT_THAT(dump->entries(), Contains(Eq(ByRef(on_disk_prefetched_size))));
 
   // |parkable1| is compressed.
   compressed =
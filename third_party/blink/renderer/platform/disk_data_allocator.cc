@@ -4,12 +4,21 @@
 
 #include "third_party/blink/renderer/platform/disk_data_allocator.h"
 
+#include <string.h>
+
 #include <algorithm>
+#include <limits>
 #include <utility>
 
+#include "base/allocator/partition_allocator/partition_alloc.h"
 #include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/threading/thread_restrictions.h"
+#include "base/timer/elapsed_timer.h"
 #include "third_party/blink/renderer/platform/disk_data_metadata.h"
+#include "third_party/blink/renderer/platform/scheduler/public/worker_pool.h"
+#include "third_party/blink/renderer/platform/wtf/allocator/partitions.h"
+#include "third_party/blink/renderer/platform/wtf/cross_thread_functional.h"
 #include "third_party/blink/renderer/platform/wtf/std_lib_extras.h"
 #include "third_party/blink/renderer/platform/wtf/wtf.h"
 
@@ -30,32 +39,36 @@ void DiskDataAllocator::set_may_write_for_testing(bool may_write) {
   may_write_ = may_write;
 }
 
+void DiskDataAllocator::set_max_prefetched_size_for_testing(size_t size) {
+  MutexLocker locker(mutex_);
+  max_prefetched_size_ = size;
+}
+
 DiskDataMetadata DiskDataAllocator::FindChunk(size_t size) {
   // Try to reuse some space. Policy:
   // 1. Exact fit
   // 2. Worst fit
+  // Among chunks of the chosen size, the one with the lowest offset is picked.
   DiskDataMetadata chosen_chunk{-1, 0};
 
-  size_t worst_fit_size = 0;
-  for (const auto& chunk : free_chunks_) {
-    size_t chunk_size = chunk.second;
-    if (size == chunk_size) {
-      chosen_chunk = {chunk.first, chunk.second};
-      break;
-    } else if (chunk_size > size && chunk_size > worst_fit_size) {
-      chosen_chunk = {chunk.first, chunk.second};
-      worst_fit_size = chunk.second;
+  if (!free_chunks_by_size_.empty()) {
+    auto exact_fit = free_chunks_by_size_.lower_bound(
+        {size, std::numeric_limits<int64_t>::min()});
+    size_t chosen_size = free_chunks_by_size_.rbegin()->first;
+    if (exact_fit != free_chunks_by_size_.end() && exact_fit->first == size)
+      chosen_size = size;
+    if (chosen_size >= size) {
+      auto chosen = free_chunks_by_size_.lower_bound(
+          {chosen_size, std::numeric_limits<int64_t>::min()});
+      chosen_chunk = {chosen->second, chosen->first};
     }
   }
 
   if (chosen_chunk.start_offset() != -1) {
-    free_chunks_size_ -= size;
-    free_chunks_.erase(chosen_chunk.start_offset());
+    EraseFreeChunk(free_chunks_.find(chosen_chunk.start_offset()));
     if (chosen_chunk.size() > size) {
-      std::pair<int64_t, size_t> remainder_chunk = {
-          chosen_chunk.start_offset() + size, chosen_chunk.size() - size};
-      auto result = free_chunks_.insert(remainder_chunk);
-      DCHECK(result.second);
+      InsertFreeChunk(chosen_chunk.start_offset() + size,
+                      chosen_chunk.size() - size);
       chosen_chunk.size_ = size;
     }
   } else {
@@ -81,8 +94,7 @@ void DiskDataAllocator::ReleaseChunk(const DiskDataMetadata& metadata) {
     DCHECK_LE(left_chunk_end, chunk.start_offset());
     if (left_chunk_end == chunk.start_offset()) {
       chunk = {left->first, left->second + chunk.size()};
-      free_chunks_size_ -= left->second;
-      free_chunks_.erase(left);
+      EraseFreeChunk(left);
     }
   }
 
@@ -93,14 +105,28 @@ void DiskDataAllocator::ReleaseChunk(const DiskDataMetadata& metadata) {
     DCHECK_LE(chunk_end, right->first);
     if (right->first == chunk_end) {
       chunk = {chunk.start_offset(), chunk.size() + right->second};
-      free_chunks_size_ -= right->second;
-      free_chunks_.erase(right);
+      EraseFreeChunk(right);
     }
   }
 
-  auto result = free_chunks_.insert({chunk.start_offset(), chunk.size()});
+  InsertFreeChunk(chunk.start_offset(), chunk.size());
+}
+
+void DiskDataAllocator::InsertFreeChunk(int64_t start_offset, size_t size) {
+  auto result = free_chunks_.insert({start_offset, size});
   DCHECK(result.second);
-  free_chunks_size_ += chunk.size();
+  auto by_size_result = free_chunks_by_size_.insert({size, start_offset});
+  DCHECK(by_size_result.second);
+  free_chunks_size_ += size;
+}
+
+void DiskDataAllocator::EraseFreeChunk(
+    std::map<int64_t, size_t>::iterator it) {
+  DCHECK(it != free_chunks_.end());
+  size_t erased = free_chunks_by_size_.erase({it->second, it->first});
+  DCHECK_EQ(1u, erased);
+  free_chunks_size_ -= it->second;
+  free_chunks_.erase(it);
 }
 
 std::unique_ptr<DiskDataMetadata> DiskDataAllocator::Write(const void* data,
@@ -136,12 +162,164 @@ std::unique_ptr<DiskDataMetadata> DiskDataAllocator::Write(const void* data,
       new DiskDataMetadata(chosen_chunk.start_offset(), chosen_chunk.size()));
 }
 
+void DiskDataAllocator::BufferDeleter::operator()(char* buffer) const {
+  WTF::Partitions::BufferPartition()->Free(buffer);
+}
+
+// static
+DiskDataAllocator::Buffer DiskDataAllocator::AllocateBuffer(size_t size) {
+  return Buffer(
+      reinterpret_cast<char*>(WTF::Partitions::BufferPartition()->AllocFlags(
+          base::PartitionAllocReturnNull, size, "DiskDataAllocator")));
+}
+
+void DiskDataAllocator::ScheduleWrite(const void* data,
+                                      size_t size,
+                                      WriteCallback callback) {
+  {
+    MutexLocker locker(mutex_);
+    if (may_write_) {
+      // Only the first write of a batch posts a task, the others are picked
+      // up by it.
+      bool needs_flush = pending_writes_.IsEmpty();
+      pending_writes_.push_back(PendingWrite{
+          reinterpret_cast<const char*>(data), size, std::move(callback), -1});
+      if (needs_flush) {
+        worker_pool::PostTask(
+            FROM_HERE, {base::MayBlock()},
+            CrossThreadBindOnce(&DiskDataAllocator::FlushPendingWrites,
+                                WTF::CrossThreadUnretained(this)));
+      }
+      return;
+    }
+  }
+  std::move(callback).Run(nullptr, base::TimeDelta());
+}
+
+void DiskDataAllocator::FlushPendingWrites() {
+  Vector<PendingWrite> writes;
+  bool may_write;
+  {
+    MutexLocker locker(mutex_);
+    writes.swap(pending_writes_);
+    may_write = may_write_;
+    if (may_write) {
+      for (auto& write : writes)
+        write.start_offset = FindChunk(write.size).start_offset();
+    }
+  }
+
+  // A write failed since these were scheduled.
+  if (!may_write) {
+    for (auto& write : writes)
+      std::move(write.callback).Run(nullptr, base::TimeDelta());
+    return;
+  }
+
+  std::sort(writes.begin(), writes.end(),
+            [](const PendingWrite& a, const PendingWrite& b) {
+              return a.start_offset < b.start_offset;
+            });
+
+  // Cleared if a batch buffer cannot be allocated, in which case the remaining
+  // writes are done one by one.
+  bool may_batch = true;
+  for (wtf_size_t begin = 0; begin < writes.size();) {
+    // Find the run of writes starting at |begin| that are contiguous on disk.
+    wtf_size_t end = begin + 1;
+    size_t batch_size = writes[begin].size;
+    while (may_batch && end < writes.size() &&
+           writes[end].start_offset ==
+               writes[begin].start_offset +
+                   static_cast<int64_t>(batch_size) &&
+           batch_size + writes[end].size <= kMaxWriteBatchSize) {
+      batch_size += writes[end].size;
+      end++;
+    }
+
+    const char* data = writes[begin].data;
+    Buffer batch;
+    if (end - begin > 1) {
+      batch = AllocateBuffer(batch_size);
+      if (batch) {
+        char* batch_end = batch.get();
+        for (wtf_size_t i = begin; i < end; i++) {
+          memcpy(batch_end, writes[i].data, writes[i].size);
+          batch_end += writes[i].size;
+        }
+        data = batch.get();
+      } else {
+        may_batch = false;
+        end = begin + 1;
+        batch_size = writes[begin].size;
+      }
+    }
+
+    base::ElapsedTimer timer;
+    int size_int = base::checked_cast<int>(batch_size);
+    bool ok = DoWrite(writes[begin].start_offset, data, size_int) == size_int;
+    base::TimeDelta elapsed = timer.Elapsed();
+
+    {
+      MutexLocker locker(mutex_);
+      // Same as in |Write()|, assume that the error is not transient.
+      if (!ok)
+        may_write_ = false;
+#if DCHECK_IS_ON()
+      for (wtf_size_t i = begin; ok && i < end; i++)
+        allocated_chunks_.insert({writes[i].start_offset, writes[i].size});
+#endif
+    }
+
+    for (wtf_size_t i = begin; i < end; i++) {
+      std::unique_ptr<DiskDataMetadata> metadata;
+      if (ok) {
+        metadata = std::unique_ptr<DiskDataMetadata>(
+            new DiskDataMetadata(writes[i].start_offset, writes[i].size));
+      }
+      // Split the time according to the size of each write.
+      base::TimeDelta write_time =
+          batch_size ? elapsed * (static_cast<double>(writes[i].size) /
+                                  static_cast<double>(batch_size))
+                     : elapsed;
+      std::move(writes[i].callback).Run(std::move(metadata), write_time);
+    }
+
+    // The file is no longer written to, fail the remaining writes as
+    // |ScheduleWrite()| now does.
+    if (!ok) {
+      for (wtf_size_t i = end; i < writes.size(); i++)
+        std::move(writes[i].callback).Run(nullptr, base::TimeDelta());
+      return;
+    }
+    begin = end;
+  }
+}
+
 void DiskDataAllocator::Read(const DiskDataMetadata& metadata, void* data) {
-  // Doesn't need locking as files support concurrent access, and we don't
-  // update metadata.
   char* data_char = reinterpret_cast<char*>(data);
-  DoRead(metadata.start_offset(), data_char,
-         base::checked_cast<int>(metadata.size()));
+
+  Buffer prefetched;
+  {
+    MutexLocker locker(mutex_);
+    auto it = prefetched_chunks_.find(metadata.start_offset());
+    if (it != prefetched_chunks_.end()) {
+      // If the background read is still in progress, |data| is null, don't
+      // wait for it.
+      DCHECK_EQ(metadata.size(), it->second.size);
+      prefetched = std::move(it->second.data);
+      DropPrefetchedChunk(metadata.start_offset());
+    }
+  }
+
+  if (prefetched) {
+    memcpy(data_char, prefetched.get(), metadata.size());
+  } else {
+    // Doesn't need locking as files support concurrent access, and we don't
+    // update metadata.
+    DoRead(metadata.start_offset(), data_char,
+           base::checked_cast<int>(metadata.size()));
+  }
 
 #if DCHECK_IS_ON()
   {
@@ -153,6 +331,75 @@ void DiskDataAllocator::Read(const DiskDataMetadata& metadata, void* data) {
 #endif
 }
 
+void DiskDataAllocator::Prefetch(const DiskDataMetadata& metadata) {
+  MutexLocker locker(mutex_);
+  if (prefetched_chunks_.find(metadata.start_offset()) !=
+          prefetched_chunks_.end() ||
+      metadata.size() > max_prefetched_size_) {
+    return;
+  }
+
+  // Data which was prefetched and not read yet is less likely to be read than
+  // newly requested data.
+  while (prefetched_size_ + metadata.size() > max_prefetched_size_)
+    DropPrefetchedChunk(prefetch_order_.begin()->second);
+
+  uint64_t id = next_prefetch_id_++;
+  prefetched_chunks_.insert(
+      {metadata.start_offset(), PrefetchedChunk{id, metadata.size(), nullptr}});
+  prefetch_order_.insert({id, metadata.start_offset()});
+  prefetched_size_ += metadata.size();
+  worker_pool::PostTask(
+      FROM_HERE, {base::MayBlock()},
+      CrossThreadBindOnce(&DiskDataAllocator::PrefetchInBackground,
+                          WTF::CrossThreadUnretained(this),
+                          metadata.start_offset(), metadata.size(), id));
+}
+
+void DiskDataAllocator::PrefetchInBackground(int64_t start_offset,
+                                             size_t size,
+                                             uint64_t id) {
+  {
+    // The data may have been read or discarded in the meantime.
+    MutexLocker locker(mutex_);
+    auto it = prefetched_chunks_.find(start_offset);
+    if (it == prefetched_chunks_.end() || it->second.id != id)
+      return;
+  }
+
+  // Prefetching is only an optimization, |Read()| reads from the disk if the
+  // allocation fails.
+  Buffer data = AllocateBuffer(size);
+  if (!data) {
+    MutexLocker locker(mutex_);
+    auto it = prefetched_chunks_.find(start_offset);
+    if (it != prefetched_chunks_.end() && it->second.id == id)
+      DropPrefetchedChunk(start_offset);
+    return;
+  }
+  DoRead(start_offset, data.get(), base::checked_cast<int>(size));
+
+  MutexLocker locker(mutex_);
+  auto it = prefetched_chunks_.find(start_offset);
+  if (it == prefetched_chunks_.end() || it->second.id != id)
+    return;
+  it->second.data = std::move(data);
+}
+
+void DiskDataAllocator::CancelPrefetch(const DiskDataMetadata& metadata) {
+  MutexLocker locker(mutex_);
+  DropPrefetchedChunk(metadata.start_offset());
+}
+
+void DiskDataAllocator::DropPrefetchedChunk(int64_t start_offset) {
+  auto it = prefetched_chunks_.find(start_offset);
+  if (it == prefetched_chunks_.end())
+    return;
+  prefetched_size_ -= it->second.size;
+  prefetch_order_.erase(it->second.id);
+  prefetched_chunks_.erase(it);
+}
+
 void DiskDataAllocator::Discard(std::unique_ptr<DiskDataMetadata> metadata) {
   MutexLocker locker(mutex_);
   DCHECK(may_write_ || file_.IsValid());
@@ -164,6 +411,7 @@ void DiskDataAllocator::Discard(std::unique_ptr<DiskDataMetadata> metadata) {
   allocated_chunks_.erase(it);
 #endif
 
+  DropPrefetchedChunk(metadata->start_offset());
   ReleaseChunk(*metadata);
 }
 
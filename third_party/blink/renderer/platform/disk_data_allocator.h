@@ -7,16 +7,21 @@
 
 #include <map>
 #include <memory>
+#include <set>
+#include <utility>
 
 #include "base/dcheck_is_on.h"
 #include "base/files/file.h"
 #include "base/gtest_prod_util.h"
 #include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "mojo/public/cpp/bindings/receiver.h"
 #include "third_party/blink/public/mojom/disk_allocator.mojom-blink.h"
 #include "third_party/blink/renderer/platform/platform_export.h"
+#include "third_party/blink/renderer/platform/wtf/functional.h"
 #include "third_party/blink/renderer/platform/wtf/threading.h"
 #include "third_party/blink/renderer/platform/wtf/threading_primitives.h"
+#include "third_party/blink/renderer/platform/wtf/vector.h"
 
 namespace blink {
 
@@ -29,12 +34,27 @@ class DiskDataMetadata;
 // also become not usable later, for instance if disk space is no longer
 // available.
 //
+// Free space in the file is kept in a list of chunks, which are merged with
+// their neighbors when released, and indexed by size to find a chunk for a new
+// write in logarithmic time.
+//
 // Threading:
 // - Reads and writes can be done from any thread.
 // - public methods are thread-safe, and unless otherwise noted, can be called
 //   from any thread.
 class PLATFORM_EXPORT DiskDataAllocator : public mojom::blink::DiskAllocator {
  public:
+  // Called with the on-disk metadata, or nullptr in case of error, and the
+  // share of the disk write time spent on this data.
+  using WriteCallback =
+      CrossThreadOnceFunction<void(std::unique_ptr<DiskDataMetadata>,
+                                   base::TimeDelta)>;
+
+  // Largest amount of data written to disk at once by |ScheduleWrite()|.
+  static constexpr size_t kMaxWriteBatchSize = 1 << 20;
+  // Largest amount of data kept in memory by |Prefetch()|. Beyond it, the
+  // oldest prefetched data is dropped.
+  static constexpr size_t kMaxPrefetchedSize = 4 << 20;
 
   // Must be called on the main thread.
   void ProvideTemporaryFile(::base::File file) override;
@@ -47,6 +67,16 @@ class PLATFORM_EXPORT DiskDataAllocator : public mojom::blink::DiskAllocator {
   // Note that this performs a blocking disk write.
   std::unique_ptr<DiskDataMetadata> Write(const void* data, size_t size);
 
+  // Non-blocking version of |Write()|. The data is written on a background
+  // thread, and |callback| is then called on that thread. |data| must remain
+  // valid until then.
+  //
+  // Writes scheduled close together are batched: their data is allocated and
+  // written in the same background task, and data that ends up contiguous in
+  // the file is written with a single disk write.
+  void ScheduleWrite(const void* data, size_t size, WriteCallback callback)
+      LOCKS_EXCLUDED(mutex_);
+
   // Reads data. A read failure is fatal.
   // Caller must make sure that this is not called at the same time as
   // |Discard()|.
@@ -56,6 +86,16 @@ class PLATFORM_EXPORT DiskDataAllocator : public mojom::blink::DiskAllocator {
   // array. Note that this performs a blocking disk read.
   void Read(const DiskDataMetadata& metadata, void* data);
 
+  // Hints that the data pointed at by |metadata| will soon be |Read()|. It is
+  // then read on a background thread and kept in memory, so that the next
+  // |Read()| doesn't block on the disk. Older prefetched data is dropped to
+  // stay within |kMaxPrefetchedSize|.
+  void Prefetch(const DiskDataMetadata& metadata) LOCKS_EXCLUDED(mutex_);
+
+  // Drops the data prefetched for |metadata|, if any, when it is no longer
+  // expected to be |Read()|.
+  void CancelPrefetch(const DiskDataMetadata& metadata) LOCKS_EXCLUDED(mutex_);
+
   // Discards existing data pointed at by |metadata|. Caller must make sure this
   // is not called while the same file is being read.
   void Discard(std::unique_ptr<DiskDataMetadata> metadata);
@@ -74,15 +114,41 @@ class PLATFORM_EXPORT DiskDataAllocator : public mojom::blink::DiskAllocator {
     return free_chunks_size_;
   }
 
+  size_t prefetched_size() {
+    MutexLocker locker(mutex_);
+    return prefetched_size_;
+  }
+
  protected:
   // Protected methods for testing.
   DiskDataAllocator();
   void set_may_write_for_testing(bool may_write) LOCKS_EXCLUDED(mutex_);
+  void set_max_prefetched_size_for_testing(size_t size) LOCKS_EXCLUDED(mutex_);
 
  private:
   DiskDataMetadata FindChunk(size_t size) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void ReleaseChunk(const DiskDataMetadata& metadata)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void InsertFreeChunk(int64_t start_offset, size_t size)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void EraseFreeChunk(std::map<int64_t, size_t>::iterator it)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Buffer allocated with |AllocateBuffer()|.
+  struct BufferDeleter {
+    void operator()(char* buffer) const;
+  };
+  using Buffer = std::unique_ptr<char[], BufferDeleter>;
+  // Returns nullptr instead of crashing if the allocation fails, as large
+  // allocations are likely to fail under the memory pressure which makes data
+  // go to disk.
+  static Buffer AllocateBuffer(size_t size);
+
+  void FlushPendingWrites() LOCKS_EXCLUDED(mutex_);
+  void PrefetchInBackground(int64_t start_offset, size_t size, uint64_t id)
+      LOCKS_EXCLUDED(mutex_);
+  void DropPrefetchedChunk(int64_t start_offset)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   // Virtual for testing.
   virtual int DoWrite(int64_t offset, const char* data, int size)
@@ -100,7 +166,35 @@ class PLATFORM_EXPORT DiskDataAllocator : public mojom::blink::DiskAllocator {
   size_t free_chunks_size_ GUARDED_BY(mutex_);
 
  private:
+  // Same chunks as |free_chunks_|, as (size, start offset) pairs.
+  std::set<std::pair<size_t, int64_t>> free_chunks_by_size_ GUARDED_BY(mutex_);
   int64_t file_tail_ GUARDED_BY(mutex_);
+
+  struct PendingWrite {
+    const char* data;
+    size_t size;
+    WriteCallback callback;
+    int64_t start_offset;
+  };
+  Vector<PendingWrite> pending_writes_ GUARDED_BY(mutex_);
+
+  struct PrefetchedChunk {
+    // Identifies the prefetch, as the chunk may be discarded, then reused and
+    // prefetched again before the first background read completes.
+    uint64_t id;
+    size_t size;
+    // Null until the background read completes.
+    Buffer data;
+  };
+  // Keyed by start offset.
+  std::map<int64_t, PrefetchedChunk> prefetched_chunks_ GUARDED_BY(mutex_);
+  // Start offsets of |prefetched_chunks_|, from the oldest prefetch to the
+  // newest one.
+  std::map<uint64_t, int64_t> prefetch_order_ GUARDED_BY(mutex_);
+  size_t prefetched_size_ GUARDED_BY(mutex_) = 0;
+  size_t max_prefetched_size_ GUARDED_BY(mutex_) = kMaxPrefetchedSize;
+  uint64_t next_prefetch_id_ GUARDED_BY(mutex_) = 0;
+
   // Whether writing is possible now. This can be true if:
   // - |set_may_write_for_testing()| was called, or
   // - |file_.IsValid()| and no write error occurred (which would set
@@ -17,6 +17,7 @@
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/blink/renderer/platform/disk_data_allocator_test_utils.h"
 #include "third_party/blink/renderer/platform/disk_data_metadata.h"
+#include "third_party/blink/renderer/platform/wtf/cross_thread_functional.h"
 
 using ThreadPoolExecutionMode =
     base::test::TaskEnvironment::ThreadPoolExecutionMode;
@@ -235,6 +236,255 @@ TEST_F(DiskDataAllocatorTest, FreeChunksMerging) {
   EXPECT_EQ(1u, allocator->FreeChunks().size());
 }
 
+TEST_F(DiskDataAllocatorTest, ScheduleWriteBatchesWrites) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1000;
+  constexpr int kCount = 10;
+  std::vector<std::string> data_to_write;
+  std::vector<std::unique_ptr<DiskDataMetadata>> all_metadata(kCount);
+  for (int i = 0; i < kCount; i++) {
+    data_to_write.push_back(base::RandBytesAsString(kSize));
+    allocator.ScheduleWrite(
+        data_to_write.back().c_str(), kSize,
+        CrossThreadBindOnce(
+            [](std::unique_ptr<DiskDataMetadata>* result,
+               std::unique_ptr<DiskDataMetadata> metadata,
+               base::TimeDelta write_time) { *result = std::move(metadata); },
+            WTF::CrossThreadUnretained(&all_metadata[i])));
+  }
+  // Nothing is written synchronously.
+  EXPECT_EQ(0, allocator.write_count());
+
+  task_environment_.RunUntilIdle();
+  // The chunks are contiguous, so a single write is enough.
+  EXPECT_EQ(1, allocator.write_count());
+  EXPECT_EQ(static_cast<int64_t>(kCount * kSize), allocator.disk_footprint());
+
+  for (int i = 0; i < kCount; i++) {
+    ASSERT_TRUE(all_metadata[i]);
+    EXPECT_EQ(kSize, all_metadata[i]->size());
+    auto read_data = std::vector<char>(kSize);
+    allocator.Read(*all_metadata[i], &read_data[0]);
+    EXPECT_EQ(0, memcmp(&read_data[0], data_to_write[i].c_str(), kSize));
+  }
+
+  // Discarding the odd chunks creates holes, writes to which cannot be merged.
+  for (int i = 1; i < kCount; i += 2)
+    allocator.Discard(std::move(all_metadata[i]));
+  for (int i = 1; i < kCount; i += 2) {
+    allocator.ScheduleWrite(
+        data_to_write[i].c_str(), kSize,
+        CrossThreadBindOnce(
+            [](std::unique_ptr<DiskDataMetadata>* result,
+               std::unique_ptr<DiskDataMetadata> metadata,
+               base::TimeDelta write_time) { *result = std::move(metadata); },
+            WTF::CrossThreadUnretained(&all_metadata[i])));
+  }
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(1 + kCount / 2, allocator.write_count());
+  // The holes were reused.
+  EXPECT_EQ(static_cast<int64_t>(kCount * kSize), allocator.disk_footprint());
+  EXPECT_EQ(0u, allocator.free_chunks_size());
+}
+
+TEST_F(DiskDataAllocatorTest, ScheduleWriteEventuallyFail) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1 << 18;
+  std::string random_data = base::RandBytesAsString(kSize);
+
+  int successes = 0;
+  int failures = 0;
+  static_assert(4 * kSize == InMemoryDataAllocator::kMaxSize, "");
+  for (int i = 0; i < 5; i++) {
+    allocator.ScheduleWrite(
+        random_data.c_str(), random_data.size(),
+        CrossThreadBindOnce(
+            [](int* successes, int* failures,
+               std::unique_ptr<DiskDataMetadata> metadata,
+               base::TimeDelta write_time) {
+              (metadata ? *successes : *failures) += 1;
+            },
+            WTF::CrossThreadUnretained(&successes),
+            WTF::CrossThreadUnretained(&failures)));
+  }
+  task_environment_.RunUntilIdle();
+
+  // The batch is split in 1MiB writes, the last one doesn't fit.
+  EXPECT_EQ(4, successes);
+  EXPECT_EQ(1, failures);
+  EXPECT_FALSE(allocator.may_write());
+
+  // Later writes fail immediately.
+  allocator.ScheduleWrite(
+      random_data.c_str(), random_data.size(),
+      CrossThreadBindOnce(
+          [](int* failures, std::unique_ptr<DiskDataMetadata> metadata,
+             base::TimeDelta write_time) {
+            EXPECT_FALSE(metadata);
+            *failures += 1;
+          },
+          WTF::CrossThreadUnretained(&failures)));
+  EXPECT_EQ(2, failures);
+}
+
+TEST_F(DiskDataAllocatorTest, ScheduleWriteStopsAtFirstFailure) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1 << 18;
+  constexpr int kCount = 12;
+  std::string random_data = base::RandBytesAsString(kSize);
+
+  int successes = 0;
+  std::vector<int> failures;
+  static_assert(4 * kSize == InMemoryDataAllocator::kMaxSize, "");
+  static_assert(4 * kSize == DiskDataAllocator::kMaxWriteBatchSize, "");
+  for (int i = 0; i < kCount; i++) {
+    allocator.ScheduleWrite(
+        random_data.c_str(), random_data.size(),
+        CrossThreadBindOnce(
+            [](int index, int* successes, std::vector<int>* failures,
+               std::unique_ptr<DiskDataMetadata> metadata,
+               base::TimeDelta write_time) {
+              if (metadata)
+                *successes += 1;
+              else
+                failures->push_back(index);
+            },
+            i, WTF::CrossThreadUnretained(&successes),
+            WTF::CrossThreadUnretained(&failures)));
+  }
+  task_environment_.RunUntilIdle();
+
+  // The writes are split in three batches. The second one fails, and the third
+  // one is not attempted.
+  EXPECT_EQ(2, allocator.write_count());
+  EXPECT_FALSE(allocator.may_write());
+  EXPECT_EQ(4, successes);
+  ASSERT_EQ(static_cast<size_t>(kCount - 4), failures.size());
+  for (int i = 4; i < kCount; i++)
+    EXPECT_EQ(i, failures[i - 4]);
+}
+
+TEST_F(DiskDataAllocatorTest, Prefetch) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1000;
+  std::string random_data = base::RandBytesAsString(kSize);
+  auto metadata = allocator.Write(random_data.c_str(), random_data.size());
+  ASSERT_TRUE(metadata);
+
+  allocator.Prefetch(*metadata);
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(1, allocator.read_count());
+
+  // Served from memory.
+  auto read_data = std::vector<char>(kSize);
+  allocator.Read(*metadata, &read_data[0]);
+  EXPECT_EQ(1, allocator.read_count());
+  EXPECT_EQ(0, memcmp(&read_data[0], random_data.c_str(), kSize));
+
+  // Prefetched data is only used once.
+  allocator.Read(*metadata, &read_data[0]);
+  EXPECT_EQ(2, allocator.read_count());
+  EXPECT_EQ(0, memcmp(&read_data[0], random_data.c_str(), kSize));
+}
+
+TEST_F(DiskDataAllocatorTest, PrefetchThenDiscard) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1000;
+  std::string random_data = base::RandBytesAsString(kSize);
+  auto metadata = allocator.Write(random_data.c_str(), random_data.size());
+  ASSERT_TRUE(metadata);
+  int64_t start_offset = metadata->start_offset();
+
+  // Discarding before the prefetch completes cancels it.
+  allocator.Prefetch(*metadata);
+  allocator.Discard(std::move(metadata));
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(0, allocator.read_count());
+
+  // The chunk is reused, and reading it doesn't return stale data.
+  std::string new_data = base::RandBytesAsString(kSize);
+  metadata = allocator.Write(new_data.c_str(), new_data.size());
+  ASSERT_TRUE(metadata);
+  EXPECT_EQ(start_offset, metadata->start_offset());
+  auto read_data = std::vector<char>(kSize);
+  allocator.Read(*metadata, &read_data[0]);
+  EXPECT_EQ(0, memcmp(&read_data[0], new_data.c_str(), kSize));
+}
+
+TEST_F(DiskDataAllocatorTest, PrefetchTwice) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1000;
+  std::string random_data = base::RandBytesAsString(kSize);
+  auto metadata = allocator.Write(random_data.c_str(), random_data.size());
+  ASSERT_TRUE(metadata);
+
+  // Prefetching the same data twice only reads it once.
+  allocator.Prefetch(*metadata);
+  allocator.Prefetch(*metadata);
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(1, allocator.read_count());
+}
+
+TEST_F(DiskDataAllocatorTest, PrefetchDropsOldestData) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1000;
+  constexpr int kCount = 4;
+  allocator.set_max_prefetched_size_for_testing(kCount * kSize);
+  auto all_metadata = Allocate(&allocator, kSize, 2 * kCount);
+
+  // Fill the budget with data which is never read.
+  for (int i = 0; i < kCount; i++)
+    allocator.Prefetch(*all_metadata[i]);
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(kCount, allocator.read_count());
+  EXPECT_EQ(kCount * kSize, allocator.prefetched_size());
+
+  // Prefetching still works, and replaces the oldest data.
+  for (int i = kCount; i < 2 * kCount; i++)
+    allocator.Prefetch(*all_metadata[i]);
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(2 * kCount, allocator.read_count());
+  EXPECT_EQ(kCount * kSize, allocator.prefetched_size());
+
+  auto read_data = std::vector<char>(kSize);
+  for (int i = kCount; i < 2 * kCount; i++)
+    allocator.Read(*all_metadata[i], &read_data[0]);
+  EXPECT_EQ(2 * kCount, allocator.read_count());
+  EXPECT_EQ(0u, allocator.prefetched_size());
+
+  // The dropped data is read from disk.
+  allocator.Read(*all_metadata[0], &read_data[0]);
+  EXPECT_EQ(2 * kCount + 1, allocator.read_count());
+}
+
+TEST_F(DiskDataAllocatorTest, CancelPrefetch) {
+  InMemoryDataAllocator allocator;
+
+  constexpr size_t kSize = 1000;
+  std::string random_data = base::RandBytesAsString(kSize);
+  auto metadata = allocator.Write(random_data.c_str(), random_data.size());
+  ASSERT_TRUE(metadata);
+
+  allocator.Prefetch(*metadata);
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(1, allocator.read_count());
+  EXPECT_EQ(kSize, allocator.prefetched_size());
+
+  allocator.CancelPrefetch(*metadata);
+  EXPECT_EQ(0u, allocator.prefetched_size());
+  auto read_data = std::vector<char>(kSize);
+  allocator.Read(*metadata, &read_data[0]);
+  EXPECT_EQ(2, allocator.read_count());
+  EXPECT_EQ(0, memcmp(&read_data[0], random_data.c_str(), kSize));
+}
+
 TEST_F(DiskDataAllocatorTest, ProvideInvalidFile) {
   DiskDataAllocator allocator;
   EXPECT_FALSE(allocator.may_write());
@@ -8,6 +8,7 @@
 #include "third_party/blink/renderer/platform/disk_data_allocator.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <map>
@@ -26,6 +27,8 @@ class InMemoryDataAllocator : public DiskDataAllocator {
   }
   ~InMemoryDataAllocator() override = default;
 
+  using DiskDataAllocator::set_max_prefetched_size_for_testing;
+
   std::map<int64_t, size_t> FreeChunks() {
     MutexLocker locker(mutex_);
 
@@ -38,8 +41,13 @@ class InMemoryDataAllocator : public DiskDataAllocator {
     return free_chunks_;
   }
 
+  // Number of calls to |DoWrite()| and |DoRead()|, that is of disk accesses.
+  int write_count() const { return write_count_; }
+  int read_count() const { return read_count_; }
+
  private:
   int DoWrite(int64_t offset, const char* data, int size) override {
+    write_count_++;
     int64_t end_offset = offset + size;
     if (static_cast<size_t>(end_offset) > kMaxSize)
       return -1;
@@ -50,6 +58,7 @@ class InMemoryDataAllocator : public DiskDataAllocator {
   }
 
   void DoRead(int64_t offset, char* data, int size) override {
+    read_count_++;
     int64_t end_offset = offset + size;
     ASSERT_LE(end_offset, max_offset_);
 
@@ -59,6 +68,8 @@ class InMemoryDataAllocator : public DiskDataAllocator {
  private:
   int64_t max_offset_;
   std::vector<char> data_;
+  std::atomic<int> write_count_{0};
+  std::atomic<int> read_count_{0};
 };
 
 }  // namespace blink
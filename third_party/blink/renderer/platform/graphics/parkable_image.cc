@@ -9,11 +9,13 @@
 #include "base/memory/ref_counted.h"
 #include "base/metrics/histogram_functions.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/strings/strcat.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
 #include "base/trace_event/trace_event.h"
 #include "third_party/blink/renderer/platform/graphics/parkable_image_manager.h"
 #include "third_party/blink/renderer/platform/image-decoders/segment_reader.h"
+#include "third_party/blink/renderer/platform/parking_codec.h"
 #include "third_party/blink/renderer/platform/scheduler/public/post_cross_thread_task.h"
 #include "third_party/blink/renderer/platform/scheduler/public/thread.h"
 #include "third_party/blink/renderer/platform/scheduler/public/worker_pool.h"
@@ -26,8 +28,19 @@ namespace blink {
 const base::Feature kDelayParkingImages{"DelayParkingImages",
                                         base::FEATURE_DISABLED_BY_DEFAULT};
 
+const base::Feature kCompressParkableImages{"CompressParkableImages",
+                                            base::FEATURE_DISABLED_BY_DEFAULT};
+
 namespace {
 
+// Encoded images are mostly incompressible, so a fast codec is used, which
+// gives up quickly on such data.
+constexpr parking_codec::Codec kDiskCodec = parking_codec::Codec::kSnappy;
+
+// Compressed data is only kept if it is at least 1/8th smaller, as otherwise
+// the decompression cost on unparking isn't worth the disk space.
+constexpr size_t kMinCompressionSavingsDivisor = 8;
+
 void RecordReadStatistics(size_t size,
                           base::TimeDelta duration,
                           base::TimeDelta time_since_freeze) {
@@ -66,6 +79,70 @@ void RecordWriteStatistics(size_t size, base::TimeDelta duration) {
                                throughput_mb_s);
 }
 
+// |size| is the uncompressed size, and |compressed_size| is 0 when compression
+// failed or was not worth it.
+void RecordCompressionStatistics(size_t size,
+                                 size_t compressed_size,
+                                 base::TimeDelta duration) {
+  int throughput_mb_s =
+      static_cast<int>(size / duration.InSecondsF() / (1024 * 1024));
+  const char* codec_name = parking_codec::GetName(kDiskCodec);
+
+  base::UmaHistogramCustomMicrosecondsTimes(
+      base::StrCat({"Memory.ParkableImage.Compression.", codec_name,
+                    ".Latency"}),
+      duration, base::Microseconds(500), base::Seconds(1), 100);
+  base::UmaHistogramCounts1000(
+      base::StrCat({"Memory.ParkableImage.Compression.", codec_name,
+                    ".ThroughputMBps"}),
+      throughput_mb_s);
+  // Ratio of the compressed size over the original size, 100% if the data is
+  // not compressed.
+  base::UmaHistogramPercentage(
+      base::StrCat({"Memory.ParkableImage.Compression.", codec_name, ".Ratio"}),
+      compressed_size ? static_cast<int>(100 * compressed_size / size) : 100);
+}
+
+void RecordDecompressionStatistics(size_t size, base::TimeDelta duration) {
+  int throughput_mb_s =
+      static_cast<int>(size / duration.InSecondsF() / (1024 * 1024));
+  const char* codec_name = parking_codec::GetName(kDiskCodec);
+
+  base::UmaHistogramCustomMicrosecondsTimes(
+      base::StrCat({"Memory.ParkableImage.Decompression.", codec_name,
+                    ".Latency"}),
+      duration, base::Microseconds(500), base::Seconds(1), 100);
+  base::UmaHistogramCounts1000(
+      base::StrCat({"Memory.ParkableImage.Decompression.", codec_name,
+                    ".ThroughputMBps"}),
+      throughput_mb_s);
+}
+
+// Returns the compressed |data|, or nullptr if compressing it is not worth it.
+std::unique_ptr<Vector<char>> CompressForDisk(const Vector<char>& data) {
+  TRACE_EVENT1("blink", "ParkableImageImpl::CompressForDisk", "size",
+               data.size());
+  base::ElapsedTimer timer;
+  auto compressed = std::make_unique<Vector<char>>();
+  compressed->Grow(base::checked_cast<wtf_size_t>(
+      parking_codec::GetMaxCompressedSize(kDiskCodec, data.size())));
+  size_t compressed_size;
+  bool ok = parking_codec::Compress(
+      kDiskCodec, base::as_bytes(base::make_span(data.data(), data.size())),
+      base::as_writable_bytes(
+          base::make_span(compressed->data(), compressed->size())),
+      &compressed_size);
+  ok = ok && compressed_size <=
+                 data.size() - data.size() / kMinCompressionSavingsDivisor;
+  RecordCompressionStatistics(data.size(), ok ? compressed_size : 0,
+                              timer.Elapsed());
+  if (!ok)
+    return nullptr;
+
+  compressed->Shrink(base::checked_cast<wtf_size_t>(compressed_size));
+  return compressed;
+}
+
 void AsanPoisonBuffer(RWBuffer* rw_buffer) {
 #if defined(ADDRESS_SANITIZER)
   if (!rw_buffer || !rw_buffer->size())
@@ -219,39 +296,64 @@ void ParkableImageImpl::WriteToDiskInBackground(
     scoped_refptr<ParkableImageImpl> parkable_image,
     scoped_refptr<base::SingleThreadTaskRunner> callback_task_runner) {
   DCHECK(!IsMainThread());
-  MutexLocker lock(parkable_image->lock_);
-
   DCHECK(ParkableImageManager::IsParkableImagesToDiskEnabled());
   DCHECK(parkable_image);
-  DCHECK(!parkable_image->on_disk_metadata_);
 
-  AsanUnpoisonBuffer(parkable_image->rw_buffer_.get());
+  auto vector = std::make_unique<Vector<char>>();
+  {
+    MutexLocker lock(parkable_image->lock_);
+    DCHECK(!parkable_image->on_disk_metadata_);
 
-  scoped_refptr<ROBuffer> ro_buffer =
-      parkable_image->rw_buffer_->MakeROBufferSnapshot();
-  ROBuffer::Iter it(ro_buffer.get());
+    AsanUnpoisonBuffer(parkable_image->rw_buffer_.get());
 
-  Vector<char> vector;
-  vector.ReserveInitialCapacity(
-      base::checked_cast<wtf_size_t>(parkable_image->size()));
+    scoped_refptr<ROBuffer> ro_buffer =
+        parkable_image->rw_buffer_->MakeROBufferSnapshot();
+    ROBuffer::Iter it(ro_buffer.get());
 
-  do {
-    vector.Append(reinterpret_cast<const char*>(it.data()),
-                  base::checked_cast<wtf_size_t>(it.size()));
-  } while (it.Next());
+    vector->ReserveInitialCapacity(
+        base::checked_cast<wtf_size_t>(parkable_image->size()));
 
-  // Release the lock while writing, so we don't block for too long.
-  parkable_image->lock_.unlock();
+    do {
+      vector->Append(reinterpret_cast<const char*>(it.data()),
+                     base::checked_cast<wtf_size_t>(it.size()));
+    } while (it.Next());
+  }
 
-  base::ElapsedTimer timer;
-  auto metadata = ParkableImageManager::Instance().data_allocator().Write(
-      vector.data(), vector.size());
-  base::TimeDelta elapsed = timer.Elapsed();
+  // The lock is not held while compressing and writing, so we don't block for
+  // too long.
+  bool compressed = false;
+  if (base::FeatureList::IsEnabled(kCompressParkableImages)) {
+    std::unique_ptr<Vector<char>> compressed_vector = CompressForDisk(*vector);
+    if (compressed_vector) {
+      vector = std::move(compressed_vector);
+      compressed = true;
+    }
+  }
+
+  // |vector| is kept alive by the callback until the write is done.
+  const char* data = vector->data();
+  size_t size = vector->size();
+  ParkableImageManager::Instance().data_allocator().ScheduleWrite(
+      data, size,
+      CrossThreadBindOnce(&ParkableImageImpl::OnWrittenToDiskInBackground,
+                          std::move(parkable_image),
+                          std::move(callback_task_runner), std::move(vector),
+                          compressed));
+}
 
-  // Acquire the lock again after writing.
-  parkable_image->lock_.lock();
+// static
+void ParkableImageImpl::OnWrittenToDiskInBackground(
+    scoped_refptr<ParkableImageImpl> parkable_image,
+    scoped_refptr<base::SingleThreadTaskRunner> callback_task_runner,
+    std::unique_ptr<Vector<char>> data,
+    bool compressed,
+    std::unique_ptr<DiskDataMetadata> on_disk_metadata,
+    base::TimeDelta elapsed) {
+  DCHECK(!IsMainThread());
+  MutexLocker lock(parkable_image->lock_);
 
-  parkable_image->on_disk_metadata_ = std::move(metadata);
+  parkable_image->on_disk_metadata_ = std::move(on_disk_metadata);
+  parkable_image->on_disk_data_is_compressed_ = compressed;
 
   // Nothing to do if the write failed except return. Notably, we need to
   // keep around the data for the ParkableImageImpl in this case.
@@ -338,13 +440,31 @@ bool ParkableImageImpl::MaybePark() {
 // static
 size_t ParkableImageImpl::ReadFromDiskIntoBuffer(
     DiskDataMetadata* on_disk_metadata,
+    bool compressed,
     void* buffer,
     size_t capacity) {
   size_t size = on_disk_metadata->size();
-  DCHECK(size <= capacity);
-  ParkableImageManager::Instance().data_allocator().Read(*on_disk_metadata,
-                                                         buffer);
-  return size;
+  auto& data_allocator = ParkableImageManager::Instance().data_allocator();
+  if (!compressed) {
+    DCHECK(size <= capacity);
+    data_allocator.Read(*on_disk_metadata, buffer);
+    return size;
+  }
+
+  Vector<uint8_t> compressed_data(base::checked_cast<wtf_size_t>(size));
+  data_allocator.Read(*on_disk_metadata, compressed_data.data());
+
+  base::ElapsedTimer timer;
+  base::span<uint8_t> output =
+      base::make_span(static_cast<uint8_t*>(buffer), capacity);
+  // As for ParkableString, a size mismatch or a decompression failure means
+  // that the data is corrupted, or that we are out of memory. We cannot
+  // continue without the data in either case.
+  CHECK_EQ(parking_codec::GetUncompressedSize(kDiskCodec, compressed_data),
+           capacity);
+  CHECK(parking_codec::Decompress(kDiskCodec, compressed_data, output));
+  RecordDecompressionStatistics(capacity, timer.Elapsed());
+  return capacity;
 }
 
 void ParkableImageImpl::Unpark() {
@@ -368,7 +488,8 @@ void ParkableImageImpl::Unpark() {
   DCHECK(!rw_buffer_);
   rw_buffer_ = std::make_unique<RWBuffer>(
       base::BindOnce(&ParkableImageImpl::ReadFromDiskIntoBuffer,
-                     base::Unretained(on_disk_metadata_.get())),
+                     base::Unretained(on_disk_metadata_.get()),
+                     on_disk_data_is_compressed_),
       size());
 
   base::TimeDelta elapsed = timer.Elapsed();
@@ -22,6 +22,9 @@ class SegmentReader;
 class ParkableImageManager;
 
 PLATFORM_EXPORT extern const base::Feature kDelayParkingImages;
+// Compresses images with Snappy before writing them to disk, when this saves
+// enough space.
+PLATFORM_EXPORT extern const base::Feature kCompressParkableImages;
 
 // Implementation of ParkableImage. See ParkableImage below.
 // We split ParkableImage like this because we want to avoid destroying the
@@ -84,16 +87,29 @@ class PLATFORM_EXPORT ParkableImageImpl final
   // unparked it).
   void Unpark() EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
-  // Tries to write the data from |rw_buffer_| to disk. Then, if the data is
-  // successfully written to disk, posts a task to discard |rw_buffer_|.
+  // Copies the data from |rw_buffer_|, possibly compresses it, and schedules
+  // writing it to disk.
   static void WriteToDiskInBackground(
       scoped_refptr<ParkableImageImpl>,
       scoped_refptr<base::SingleThreadTaskRunner> callback_task_runner)
       LOCKS_EXCLUDED(lock_);
 
+  // Called on the background thread which wrote |data|, after writing is
+  // done. If the data was successfully written to disk, posts a task to
+  // discard |rw_buffer_|.
+  static void OnWrittenToDiskInBackground(
+      scoped_refptr<ParkableImageImpl>,
+      scoped_refptr<base::SingleThreadTaskRunner> callback_task_runner,
+      std::unique_ptr<Vector<char>> data,
+      bool compressed,
+      std::unique_ptr<DiskDataMetadata> on_disk_metadata,
+      base::TimeDelta elapsed) LOCKS_EXCLUDED(lock_);
+
   // Writes the data referred to by |on_disk_metadata| from disk into the
-  // provided |buffer|. |capacity| is the size of the provided buffer.
+  // provided |buffer|, decompressing it if |compressed| is true. |capacity| is
+  // the size of the provided buffer.
   static size_t ReadFromDiskIntoBuffer(DiskDataMetadata* on_disk_metadata,
+                                       bool compressed,
                                        void* buffer,
                                        size_t capacity);
 
@@ -127,6 +143,8 @@ class PLATFORM_EXPORT ParkableImageImpl final
 
   // Non-null iff we have the data from |rw_buffer_| saved to disk.
   std::unique_ptr<DiskDataMetadata> on_disk_metadata_ GUARDED_BY(lock_);
+  // Whether the data on disk is compressed, see |kCompressParkableImages|.
+  bool on_disk_data_is_compressed_ GUARDED_BY(lock_) = false;
   // |size_| is only modified on the main thread.
   size_t size_ = 0;
   // |frozen_time_| is only modified on the main thread. |frozen_time_| is the
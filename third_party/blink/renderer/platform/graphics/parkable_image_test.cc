@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "third_party/blink/renderer/platform/graphics/parkable_image.h"
+#include "base/rand_util.h"
 #include "base/test/bind.h"
 #include "base/test/metrics/histogram_tester.h"
 #include "base/test/scoped_feature_list.h"
@@ -198,6 +199,18 @@ class ParkableImageDelayedTest : public ParkableImageBaseTest {
   base::test::ScopedFeatureList fl_;
 };
 
+// Parking and compression of parked data are enabled for these tests.
+class ParkableImageCompressionTest : public ParkableImageBaseTest {
+ public:
+  ParkableImageCompressionTest() {
+    fl_.InitWithFeatures({kParkableImagesToDisk, kCompressParkableImages},
+                         {kDelayParkingImages});
+  }
+
+ private:
+  base::test::ScopedFeatureList fl_;
+};
+
 // Parking is disabled for these tests.
 class ParkableImageNoParkingTest : public ParkableImageBaseTest {
  public:
@@ -997,4 +1010,67 @@ TEST_F(ParkableImageDelayedTest, ParkAndUnpark) {
   EXPECT_TRUE(is_on_disk(pi));
 }
 
+// Tests that compressible data is compressed on disk, and is the same after
+// unparking.
+TEST_F(ParkableImageCompressionTest, ParkAndUnpark) {
+  const size_t kDataSize = 3.5 * 4096;
+  char data[kDataSize];
+  PrepareReferenceData(data, kDataSize);
+
+  auto pi = MakeParkableImageForTesting(data, kDataSize);
+  pi->Freeze();
+
+  EXPECT_TRUE(MaybePark(pi));
+  RunPostedTasks();
+  EXPECT_TRUE(is_on_disk(pi));
+
+  // The reference data is a repeated pattern, which compresses well.
+  histogram_tester_.ExpectTotalCount("Memory.ParkableImage.Write.Size", 1);
+  histogram_tester_.ExpectBucketCount("Memory.ParkableImage.Write.Size",
+                                      kDataSize / 1024, 0);
+  histogram_tester_.ExpectTotalCount(
+      "Memory.ParkableImage.Compression.Snappy.Latency", 1);
+  histogram_tester_.ExpectTotalCount(
+      "Memory.ParkableImage.Compression.Snappy.ThroughputMBps", 1);
+  histogram_tester_.ExpectTotalCount(
+      "Memory.ParkableImage.Compression.Snappy.Ratio", 1);
+  histogram_tester_.ExpectBucketCount(
+      "Memory.ParkableImage.Compression.Snappy.Ratio", 100, 0);
+
+  Unpark(pi);
+  EXPECT_FALSE(is_on_disk(pi));
+  EXPECT_TRUE(IsSameContent(pi, data, kDataSize));
+
+  histogram_tester_.ExpectTotalCount(
+      "Memory.ParkableImage.Decompression.Snappy.Latency", 1);
+  histogram_tester_.ExpectTotalCount(
+      "Memory.ParkableImage.Decompression.Snappy.ThroughputMBps", 1);
+  ExpectReadStatistics(0, 1);
+}
+
+// Tests that incompressible data is written as is.
+TEST_F(ParkableImageCompressionTest, ParkAndUnparkIncompressible) {
+  const size_t kDataSize = 3.5 * 4096;
+  char data[kDataSize];
+  base::RandBytes(data, kDataSize);
+
+  auto pi = MakeParkableImageForTesting(data, kDataSize);
+  pi->Freeze();
+
+  EXPECT_TRUE(MaybePark(pi));
+  RunPostedTasks();
+  EXPECT_TRUE(is_on_disk(pi));
+
+  ExpectWriteStatistics(kDataSize / 1024, 1);
+  histogram_tester_.ExpectUniqueSample(
+      "Memory.ParkableImage.Compression.Snappy.Ratio", 100, 1);
+
+  Unpark(pi);
+  EXPECT_FALSE(is_on_disk(pi));
+  EXPECT_TRUE(IsSameContent(pi, data, kDataSize));
+
+  histogram_tester_.ExpectTotalCount(
+      "Memory.ParkableImage.Decompression.Snappy.Latency", 0);
+}
+
 }  // namespace blink
@@ -58,6 +58,20 @@ using IntMap = blink::HeapHashMap<blink::Member<IntWrapper>, int>;
 // (i.e., for HeapHash*<T>.)
 WTF_ALLOW_CLEAR_UNUSED_SLOTS_WITH_MEM_FUNCTIONS(IntMap)
 
+template <typename T>
+struct GroupProbingHashTraits : WTF::HashTraits<T> {
+  static constexpr bool kUseGroupProbing = true;
+};
+using GroupProbingIntMap =
+    blink::HeapHashMap<blink::Member<IntWrapper>,
+                       int,
+                       WTF::DefaultHash<blink::Member<IntWrapper>>::Hash,
+                       GroupProbingHashTraits<blink::Member<IntWrapper>>>;
+using GroupProbingWeakSet =
+    blink::HeapHashSet<blink::WeakMember<IntWrapper>,
+                       WTF::DefaultHash<blink::WeakMember<IntWrapper>>::Hash,
+                       GroupProbingHashTraits<blink::WeakMember<IntWrapper>>>;
+
 namespace blink {
 
 class HeapCompactTest : public TestSupportingGC {
@@ -103,6 +117,71 @@ TEST_F(HeapCompactTest, CompactHashMap) {
     EXPECT_EQ(k.key->Value(), 100 - k.value);
 }
 
+TEST_F(HeapCompactTest, CompactGroupProbingHashMap) {
+  ClearOutOldGarbage();
+
+  Persistent<GroupProbingIntMap> int_map =
+      MakeGarbageCollected<GroupProbingIntMap>();
+  Persistent<IntVector> keys = MakeGarbageCollected<IntVector>();
+  for (wtf_size_t i = 0; i < 100; ++i) {
+    IntWrapper* val = IntWrapper::Create(i);
+    keys->push_back(val);
+    int_map->insert(val, 100 - i);
+  }
+  // Leave deleted buckets in the table.
+  for (wtf_size_t i = 0; i < 100; i += 3)
+    int_map->erase(keys->at(i));
+
+  PerformHeapCompaction();
+
+  // Both the buckets and their control bytes have moved, and lookups must
+  // still find every key.
+  EXPECT_EQ(66u, int_map->size());
+  for (wtf_size_t i = 0; i < 100; ++i) {
+    auto it = int_map->find(keys->at(i));
+    if (i % 3 == 0) {
+      EXPECT_EQ(int_map->end(), it);
+    } else {
+      ASSERT_NE(int_map->end(), it);
+      EXPECT_EQ(static_cast<int>(100 - i), it->value);
+    }
+  }
+  for (auto k : *int_map)
+    EXPECT_EQ(k.key->Value(), 100 - k.value);
+
+  for (wtf_size_t i = 0; i < 100; i += 3)
+    EXPECT_TRUE(int_map->insert(keys->at(i), 100 - i).is_new_entry);
+  EXPECT_EQ(100u, int_map->size());
+}
+
+TEST_F(HeapCompactTest, CompactGroupProbingWeakHashSet) {
+  ClearOutOldGarbage();
+
+  Persistent<GroupProbingWeakSet> set =
+      MakeGarbageCollected<GroupProbingWeakSet>();
+  Persistent<IntVector> keep_alive = MakeGarbageCollected<IntVector>();
+  for (wtf_size_t i = 0; i < 100; ++i) {
+    IntWrapper* val = IntWrapper::Create(i);
+    if (i % 2)
+      keep_alive->push_back(val);
+    set->insert(val);
+  }
+
+  // Weak processing and compaction happen in the same garbage collection.
+  PerformHeapCompaction();
+
+  EXPECT_EQ(50u, set->size());
+  for (IntWrapper* val : *keep_alive)
+    EXPECT_TRUE(set->Contains(val));
+  for (IntWrapper* val : *set)
+    EXPECT_EQ(1, val->Value() % 2);
+
+  PerformHeapCompaction();
+  EXPECT_EQ(50u, set->size());
+  for (IntWrapper* val : *keep_alive)
+    EXPECT_TRUE(set->Contains(val));
+}
+
 TEST_F(HeapCompactTest, CompactVectorPartHashMap) {
   ClearOutOldGarbage();
 
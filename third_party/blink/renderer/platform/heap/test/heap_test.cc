@@ -2058,6 +2058,102 @@ TEST_F(HeapTest, HeapWeakCollectionTypes) {
   }
 }
 
+namespace {
+template <typename T>
+struct GroupProbingHashTraits : HashTraits<T> {
+  static constexpr bool kUseGroupProbing = true;
+};
+}  // namespace
+
+TEST_F(HeapTest, HeapWeakCollectionGroupProbing) {
+  ClearOutOldGarbage();
+
+  using WeakSet = HeapHashSet<WeakMember<IntWrapper>,
+                              DefaultHash<WeakMember<IntWrapper>>::Hash,
+                              GroupProbingHashTraits<WeakMember<IntWrapper>>>;
+  using WeakStrong =
+      HeapHashMap<WeakMember<IntWrapper>, Member<IntWrapper>,
+                  DefaultHash<WeakMember<IntWrapper>>::Hash,
+                  GroupProbingHashTraits<WeakMember<IntWrapper>>>;
+
+  Persistent<HeapVector<Member<IntWrapper>>> keep_numbers_alive =
+      MakeGarbageCollected<HeapVector<Member<IntWrapper>>>();
+  Persistent<WeakSet> weak_set = MakeGarbageCollected<WeakSet>();
+  Persistent<WeakStrong> weak_strong = MakeGarbageCollected<WeakStrong>();
+  Persistent<IntWrapper> two = MakeGarbageCollected<IntWrapper>(2);
+
+  for (int i = 0; i < 128; ++i) {
+    IntWrapper* wrapper = MakeGarbageCollected<IntWrapper>(i);
+    keep_numbers_alive->push_back(wrapper);
+    weak_set->insert(wrapper);
+    weak_strong->insert(wrapper, two);
+  }
+  EXPECT_EQ(128u, weak_set->size());
+  EXPECT_EQ(128u, weak_strong->size());
+
+  for (int i = 0; i < 128; i += 2)
+    keep_numbers_alive->at(i) = nullptr;
+
+  {
+    // Iterators make the backings strong, so a garbage collection in the
+    // middle of the iteration keeps all entries.
+    WeakSet::iterator it1 = weak_set->begin();
+    WeakStrong::iterator it2 = weak_strong->begin();
+    for (int i = 0; i < 10; ++i) {
+      ++it1;
+      ++it2;
+    }
+    ConservativelyCollectGarbage();
+    EXPECT_EQ(128u, weak_set->size());
+    EXPECT_EQ(128u, weak_strong->size());
+    SetIteratorCheck(it1, weak_set->end(), 118);
+    MapIteratorCheck(it2, weak_strong->end(), 118);
+  }
+
+  // Weak processing removes the dead entries, which must be skipped by the
+  // lookups of the live ones.
+  PreciselyCollectGarbage();
+  EXPECT_EQ(64u, weak_set->size());
+  EXPECT_EQ(64u, weak_strong->size());
+  for (int i = 1; i < 128; i += 2) {
+    IntWrapper* wrapper = keep_numbers_alive->at(i);
+    EXPECT_TRUE(weak_set->Contains(wrapper));
+    EXPECT_EQ(two.Get(), weak_strong->at(wrapper));
+  }
+  int found = 0;
+  for (IntWrapper* wrapper : *weak_set) {
+    EXPECT_EQ(1, wrapper->Value() % 2);
+    ++found;
+  }
+  EXPECT_EQ(64, found);
+
+  // The deleted buckets left by weak processing are reused by insertions.
+  for (int i = 0; i < 128; i += 2) {
+    IntWrapper* wrapper = MakeGarbageCollected<IntWrapper>(i);
+    keep_numbers_alive->at(i) = wrapper;
+    EXPECT_TRUE(weak_set->insert(wrapper).is_new_entry);
+    EXPECT_TRUE(weak_strong->insert(wrapper, two).is_new_entry);
+  }
+  PreciselyCollectGarbage();
+  EXPECT_EQ(128u, weak_set->size());
+  EXPECT_EQ(128u, weak_strong->size());
+  for (IntWrapper* wrapper : *keep_numbers_alive) {
+    EXPECT_TRUE(weak_set->Contains(wrapper));
+    EXPECT_TRUE(weak_strong->Contains(wrapper));
+  }
+
+  // Dropping all the keys empties the tables, and shrinking them on the next
+  // removal rebuilds the control bytes.
+  keep_numbers_alive->clear();
+  PreciselyCollectGarbage();
+  EXPECT_EQ(0u, weak_set->size());
+  EXPECT_EQ(0u, weak_strong->size());
+  weak_set->insert(two);
+  weak_set->erase(two);
+  EXPECT_TRUE(weak_set->IsEmpty());
+  EXPECT_FALSE(weak_set->Contains(two));
+}
+
 TEST_F(HeapTest, HeapHashCountedSetToVector) {
   HeapHashCountedSet<Member<IntWrapper>> set;
   HeapVector<Member<IntWrapper>> vector;
@@ -31,6 +31,7 @@
 #include "third_party/blink/renderer/platform/image-decoders/bmp/bmp_image_reader.h"
 
 #include "third_party/blink/renderer/platform/image-decoders/jpeg/jpeg_image_decoder.h"
+#include "third_party/blink/renderer/platform/image-decoders/pixel_row_kernels.h"
 #include "third_party/blink/renderer/platform/image-decoders/png/png_image_decoder.h"
 
 namespace {
@@ -1004,6 +1005,22 @@ BMPImageReader::ProcessingResult BMPImageReader::ProcessNonRLEData(
           pixel_data <<= info_header_.bit_count;
         }
       }
+    } else if (info_header_.bit_count == 24 && bit_masks_[0] == 0xff0000 &&
+               bit_masks_[1] == 0xff00 && bit_masks_[2] == 0xff &&
+               !bit_masks_[3]) {
+      // Plain 24-bit BGR data, by far the most common RGB format, is opaque
+      // and can be converted a row at a time.
+      if (num_pixels) {
+        bgr_row_buffer_.resize(unpadded_num_bytes);
+        const char* row = fast_reader_.GetConsecutiveData(
+            decoded_offset_, unpadded_num_bytes, bgr_row_buffer_.data());
+        pixel_row_kernels::SetBGRRow(reinterpret_cast<const uint8_t*>(row),
+                                     num_pixels,
+                                     buffer_->GetAddr(coord_.x(), coord_.y()));
+        seen_non_zero_alpha_pixel_ = true;
+        coord_.Offset(num_pixels, 0);
+        decoded_offset_ += unpadded_num_bytes;
+      }
     } else {
       // RGB data.  Decode pixels one at a time, left to right.
       for (; coord_.x() < end_x; decoded_offset_ += bytes_per_pixel) {
@@ -378,6 +378,9 @@ class PLATFORM_EXPORT BMPImageReader final {
   // The color palette, for paletted formats.
   Vector<RGBTriple> color_table_;
 
+  // Holds a row of 24-bit pixels when it is split across data segments.
+  Vector<char> bgr_row_buffer_;
+
   // The coordinate to which we've decoded the image.
   gfx::Point coord_;
 
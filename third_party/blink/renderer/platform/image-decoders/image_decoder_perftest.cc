@@ -0,0 +1,137 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/blink/renderer/platform/image-decoders/image_decoder.h"
+#include "third_party/blink/renderer/platform/image-decoders/image_decoder_test_helpers.h"
+#include "third_party/blink/renderer/platform/image-decoders/pixel_row_kernels.h"
+#include "third_party/blink/renderer/platform/wtf/shared_buffer.h"
+#include "third_party/blink/renderer/platform/wtf/vector.h"
+
+namespace blink {
+
+namespace {
+
+// Measures the decode throughput of every frame of a small corpus per format,
+// once with the row kernels picked for this CPU and once with the scalar ones.
+
+struct CorpusFile {
+  const char* dir;
+  const char* name;
+};
+
+const char kWebTestsResourcesDir[] = "web_tests/images/resources";
+
+const CorpusFile kPNGCorpus[] = {
+    {kWebTestsResourcesDir, "png-simple.png"},
+    {kWebTestsResourcesDir, "gracehopper.png"},
+    {kWebTestsResourcesDir, "apng18.png"},
+};
+
+const CorpusFile kGIFCorpus[] = {
+    {kWebTestsResourcesDir, "animated.gif"},
+    {kWebTestsResourcesDir, "animated-10color.gif"},
+    {kWebTestsResourcesDir, "boston.gif"},
+    {kDecodersTestingDir, "radient.gif"},
+};
+
+const CorpusFile kBMPCorpus[] = {
+    {kWebTestsResourcesDir, "gracehopper.bmp"},
+};
+
+const CorpusFile kWebPCorpus[] = {
+    {kWebTestsResourcesDir, "webp-animated.webp"},
+    {kWebTestsResourcesDir, "webp-animated-large.webp"},
+    {kWebTestsResourcesDir, "webp-animated-semitransparent1.webp"},
+    {kWebTestsResourcesDir, "webp-color-profile-lossy.webp"},
+    {kWebTestsResourcesDir, "test.webp"},
+};
+
+constexpr int kNumRounds = 20;
+
+constexpr char kMetricPrefix[] = "ImageDecoder.";
+constexpr char kMetricThroughput[] = "throughput";
+
+// Decodes every frame of |data| and returns the number of decoded pixels.
+uint64_t DecodeAllFrames(scoped_refptr<SharedBuffer> data) {
+  std::unique_ptr<ImageDecoder> decoder = ImageDecoder::Create(
+      std::move(data), true /* data_complete */,
+      ImageDecoder::kAlphaPremultiplied, ImageDecoder::kDefaultBitDepth,
+      ColorBehavior::TransformToSRGB());
+  EXPECT_TRUE(decoder);
+  if (!decoder)
+    return 0;
+  uint64_t pixels = 0;
+  for (wtf_size_t i = 0; i < decoder->FrameCount(); ++i) {
+    ImageFrame* frame = decoder->DecodeFrameBufferAtIndex(i);
+    EXPECT_TRUE(frame);
+    EXPECT_EQ(ImageFrame::kFrameComplete, frame->GetStatus());
+    pixels += static_cast<uint64_t>(decoder->Size().width()) *
+              decoder->Size().height();
+  }
+  EXPECT_FALSE(decoder->Failed());
+  return pixels;
+}
+
+template <size_t N>
+void RunDecodeBenchmark(const std::string& format,
+                        const CorpusFile (&corpus)[N]) {
+  Vector<scoped_refptr<SharedBuffer>> files;
+  for (const CorpusFile& file : corpus) {
+    files.push_back(ReadFile(file.dir, file.name));
+    ASSERT_TRUE(files.back()) << file.name;
+  }
+
+  const pixel_row_kernels::InstructionSet default_instruction_set =
+      pixel_row_kernels::GetInstructionSet();
+  for (bool use_scalar_kernels : {false, true}) {
+    if (use_scalar_kernels) {
+      pixel_row_kernels::SetInstructionSetForTesting(
+          pixel_row_kernels::InstructionSet::kScalar);
+    }
+
+    // Warm up the caches before timing.
+    for (const auto& data : files)
+      DecodeAllFrames(data);
+
+    uint64_t pixels = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int round = 0; round < kNumRounds; round++) {
+      for (const auto& data : files)
+        pixels += DecodeAllFrames(data);
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    perf_test::PerfResultReporter reporter(
+        kMetricPrefix, use_scalar_kernels ? format + ".scalar" : format);
+    reporter.RegisterImportantMetric(kMetricThroughput, "MPix/s");
+    reporter.AddResult(kMetricThroughput, pixels / 1e6 / elapsed.InSecondsF());
+  }
+  pixel_row_kernels::SetInstructionSetForTesting(default_instruction_set);
+}
+
+}  // namespace
+
+TEST(ImageDecoderPerfTest, PNG) {
+  RunDecodeBenchmark("PNG", kPNGCorpus);
+}
+
+TEST(ImageDecoderPerfTest, GIF) {
+  RunDecodeBenchmark("GIF", kGIFCorpus);
+}
+
+TEST(ImageDecoderPerfTest, BMP) {
+  RunDecodeBenchmark("BMP", kBMPCorpus);
+}
+
+TEST(ImageDecoderPerfTest, WebP) {
+  RunDecodeBenchmark("WebP", kWebPCorpus);
+}
+
+}  // namespace blink
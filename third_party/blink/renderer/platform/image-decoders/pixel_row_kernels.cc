@@ -0,0 +1,946 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/platform/image-decoders/pixel_row_kernels.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/compiler_specific.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <immintrin.h>
+
+#include "base/cpu.h"
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
+namespace blink {
+
+namespace pixel_row_kernels {
+
+namespace {
+
+// The scalar kernels. The SIMD kernels below use them for the pixels left
+// over at the end of a row.
+
+void SetRGBAPremultiplyRowScalar(const uint8_t* src,
+                                 int pixel_count,
+                                 PixelData* dst,
+                                 unsigned* alpha_mask) {
+  for (int i = 0; i < pixel_count; ++i, src += 4) {
+    ImageFrame::SetRGBAPremultiply(dst + i, src[0], src[1], src[2], src[3]);
+    *alpha_mask &= src[3];
+  }
+}
+
+void SetRGBARawRowScalar(const uint8_t* src,
+                         int pixel_count,
+                         PixelData* dst,
+                         unsigned* alpha_mask) {
+  for (int i = 0; i < pixel_count; ++i, src += 4) {
+    ImageFrame::SetRGBARaw(dst + i, src[0], src[1], src[2], src[3]);
+    *alpha_mask &= src[3];
+  }
+}
+
+void SetRGBRowScalar(const uint8_t* src, int pixel_count, PixelData* dst) {
+  for (int i = 0; i < pixel_count; ++i, src += 3)
+    ImageFrame::SetRGBARaw(dst + i, src[0], src[1], src[2], 255);
+}
+
+void SetBGRRowScalar(const uint8_t* src, int pixel_count, PixelData* dst) {
+  for (int i = 0; i < pixel_count; ++i, src += 3)
+    ImageFrame::SetRGBARaw(dst + i, src[2], src[1], src[0], 255);
+}
+
+void BlendRGBAPremultipliedRowScalar(const uint8_t* src,
+                                     int pixel_count,
+                                     PixelData* dst,
+                                     unsigned* alpha_mask) {
+  for (int i = 0; i < pixel_count; ++i, src += 4) {
+    ImageFrame::BlendRGBAPremultiplied(dst + i, src[0], src[1], src[2],
+                                       src[3]);
+    *alpha_mask &= src[3];
+  }
+}
+
+void BlendRGBARawRowScalar(const uint8_t* src,
+                           int pixel_count,
+                           PixelData* dst,
+                           unsigned* alpha_mask) {
+  for (int i = 0; i < pixel_count; ++i, src += 4) {
+    ImageFrame::BlendRGBARaw(dst + i, src[0], src[1], src[2], src[3]);
+    *alpha_mask &= src[3];
+  }
+}
+
+void BlendSrcOverDstPremultipliedRowScalar(PixelData* src,
+                                           const PixelData* dst,
+                                           int pixel_count) {
+  for (int i = 0; i < pixel_count; ++i) {
+    if (SkGetPackedA32(src[i]) != 0xff)
+      ImageFrame::BlendSrcOverDstPremultiplied(src + i, dst[i]);
+  }
+}
+
+void BlendSrcOverDstRawRowScalar(PixelData* src,
+                                 const PixelData* dst,
+                                 int pixel_count) {
+  for (int i = 0; i < pixel_count; ++i) {
+    if (SkGetPackedA32(src[i]) != 0xff)
+      ImageFrame::BlendSrcOverDstRaw(src + i, dst[i]);
+  }
+}
+
+struct Kernels {
+  InstructionSet instruction_set;
+  void (*set_rgba_premultiply_row)(const uint8_t*, int, PixelData*, unsigned*);
+  void (*set_rgba_raw_row)(const uint8_t*, int, PixelData*, unsigned*);
+  void (*set_rgb_row)(const uint8_t*, int, PixelData*);
+  void (*set_bgr_row)(const uint8_t*, int, PixelData*);
+  void (*blend_rgba_premultiplied_row)(const uint8_t*,
+                                       int,
+                                       PixelData*,
+                                       unsigned*);
+  void (*blend_rgba_raw_row)(const uint8_t*, int, PixelData*, unsigned*);
+  void (*blend_src_over_dst_premultiplied_row)(PixelData*,
+                                               const PixelData*,
+                                               int);
+  void (*blend_src_over_dst_raw_row)(PixelData*, const PixelData*, int);
+};
+
+constexpr Kernels kScalarKernels = {
+    InstructionSet::kScalar,
+    SetRGBAPremultiplyRowScalar,
+    SetRGBARawRowScalar,
+    SetRGBRowScalar,
+    SetBGRRowScalar,
+    BlendRGBAPremultipliedRowScalar,
+    BlendRGBARawRowScalar,
+    BlendSrcOverDstPremultipliedRowScalar,
+    BlendSrcOverDstRawRowScalar,
+};
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+// SSE2 is part of the baseline of every x86 build. The SSSE3 and AVX2 kernels
+// are compiled for their instruction set with function attributes, and only
+// called after checking the CPU.
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+// Premultiplication computes c * a / 255 rounded to nearest, exactly like
+// ImageFrame::SetRGBAPremultiply(): with x = c * a + 128, the result is
+// (x + (x >> 8)) >> 8. Blending over the previous frame computes
+// src + dst * (256 - src_alpha) / 256, like SkPMSrcOver(). Both fit in 16-bit
+// lanes.
+
+// SSE2 helpers, processing 4 pixels.
+
+// Swaps the first and third bytes of each pixel, i.e. converts between RGBA
+// and BGRA.
+ALWAYS_INLINE __m128i SwapRB(__m128i pixels) {
+  const __m128i ga =
+      _mm_and_si128(pixels, _mm_set1_epi32(static_cast<int>(0xff00ff00)));
+  __m128i rb = _mm_and_si128(pixels, _mm_set1_epi32(0x00ff00ff));
+  rb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rb, 0xb1), 0xb1);
+  return _mm_or_si128(ga, rb);
+}
+
+// Reorders RGBA pixels to SkPMColor order.
+ALWAYS_INLINE __m128i RGBAToN32(__m128i rgba) {
+#if SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+  return SwapRB(rgba);
+#else
+  return rgba;
+#endif
+}
+
+ALWAYS_INLINE bool AllOpaque(__m128i pixels) {
+  const int mask =
+      _mm_movemask_epi8(_mm_cmpeq_epi8(pixels, _mm_set1_epi8(-1)));
+  return (mask & 0x8888) == 0x8888;
+}
+
+ALWAYS_INLINE bool AllTransparent(__m128i pixels) {
+  const int mask =
+      _mm_movemask_epi8(_mm_cmpeq_epi8(pixels, _mm_setzero_si128()));
+  return (mask & 0x8888) == 0x8888;
+}
+
+// Returns the AND of the alpha bytes of the pixels in |pixels|.
+ALWAYS_INLINE unsigned AndAlphas(__m128i pixels) {
+  pixels = _mm_and_si128(pixels, _mm_srli_si128(pixels, 8));
+  pixels = _mm_and_si128(pixels, _mm_srli_si128(pixels, 4));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(pixels)) >> 24;
+}
+
+// Spreads the alpha of each of the 2 pixels in |pixels|, unpacked to 16-bit
+// lanes, to all its lanes.
+ALWAYS_INLINE __m128i BroadcastAlpha(__m128i pixels) {
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xff), 0xff);
+}
+
+ALWAYS_INLINE __m128i Div255(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Premultiplies the color channels of 2 pixels unpacked to 16-bit lanes.
+ALWAYS_INLINE __m128i Premultiply(__m128i pixels) {
+  // Scaling the alpha lanes by 255 leaves them unchanged.
+  const __m128i scale = _mm_or_si128(
+      BroadcastAlpha(pixels), _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+  return Div255(_mm_mullo_epi16(pixels, scale));
+}
+
+ALWAYS_INLINE __m128i Premultiply4(__m128i pixels) {
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_packus_epi16(Premultiply(_mm_unpacklo_epi8(pixels, zero)),
+                          Premultiply(_mm_unpackhi_epi8(pixels, zero)));
+}
+
+// Returns |src| + |dst| * (256 - src alpha) / 256 for 4 premultiplied pixels.
+// The sums can't overflow for premultiplied |src|.
+ALWAYS_INLINE __m128i SrcOver4(__m128i src, __m128i dst) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i k256 = _mm_set1_epi16(256);
+  const __m128i scale_lo =
+      _mm_sub_epi16(k256, BroadcastAlpha(_mm_unpacklo_epi8(src, zero)));
+  const __m128i scale_hi =
+      _mm_sub_epi16(k256, BroadcastAlpha(_mm_unpackhi_epi8(src, zero)));
+  const __m128i dst_lo = _mm_srli_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), scale_lo), 8);
+  const __m128i dst_hi = _mm_srli_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), scale_hi), 8);
+  return _mm_add_epi8(src, _mm_packus_epi16(dst_lo, dst_hi));
+}
+
+ALWAYS_INLINE __m128i Load128(const void* src) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+ALWAYS_INLINE void Store128(void* dst, __m128i pixels) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), pixels);
+}
+
+void SetRGBAPremultiplyRowSSE2(const uint8_t* src,
+                               int pixel_count,
+                               PixelData* dst,
+                               unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 4;
+  __m128i alpha_and = _mm_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    __m128i rgba = Load128(src);
+    alpha_and = _mm_and_si128(alpha_and, rgba);
+    // If all of the pixels are opaque, no need to premultiply.
+    if (!AllOpaque(rgba))
+      rgba = Premultiply4(rgba);
+    Store128(dst + i, RGBAToN32(rgba));
+    src += kPixelsPerLoad * 4;
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  SetRGBAPremultiplyRowScalar(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+void SetRGBARawRowSSE2(const uint8_t* src,
+                       int pixel_count,
+                       PixelData* dst,
+                       unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 4;
+  __m128i alpha_and = _mm_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m128i rgba = Load128(src);
+    alpha_and = _mm_and_si128(alpha_and, rgba);
+    Store128(dst + i, RGBAToN32(rgba));
+    src += kPixelsPerLoad * 4;
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  SetRGBARawRowScalar(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+void BlendRGBAPremultipliedRowSSE2(const uint8_t* src,
+                                   int pixel_count,
+                                   PixelData* dst,
+                                   unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 4;
+  __m128i alpha_and = _mm_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m128i rgba = Load128(src);
+    alpha_and = _mm_and_si128(alpha_and, rgba);
+    src += kPixelsPerLoad * 4;
+    // Transparent pixels leave the previous frame unchanged, and opaque ones
+    // replace it.
+    if (AllTransparent(rgba))
+      continue;
+    if (AllOpaque(rgba)) {
+      Store128(dst + i, RGBAToN32(rgba));
+      continue;
+    }
+    Store128(dst + i,
+             SrcOver4(RGBAToN32(Premultiply4(rgba)), Load128(dst + i)));
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  BlendRGBAPremultipliedRowScalar(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+// Non-premultiplied blending divides by the blended alpha, so only the runs of
+// fully transparent pixels, which leave |dst| unchanged, are vectorized.
+void BlendRGBARawRowSSE2(const uint8_t* src,
+                         int pixel_count,
+                         PixelData* dst,
+                         unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 4;
+  __m128i alpha_and = _mm_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m128i rgba = Load128(src);
+    alpha_and = _mm_and_si128(alpha_and, rgba);
+    if (!AllTransparent(rgba))
+      BlendRGBARawRowScalar(src, kPixelsPerLoad, dst + i, alpha_mask);
+    src += kPixelsPerLoad * 4;
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  BlendRGBARawRowScalar(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+void BlendSrcOverDstPremultipliedRowSSE2(PixelData* src,
+                                         const PixelData* dst,
+                                         int pixel_count) {
+  constexpr int kPixelsPerLoad = 4;
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m128i pixels = Load128(src + i);
+    if (!AllOpaque(pixels))
+      Store128(src + i, SrcOver4(pixels, Load128(dst + i)));
+  }
+  BlendSrcOverDstPremultipliedRowScalar(src + i, dst + i, pixel_count - i);
+}
+
+void BlendSrcOverDstRawRowSSE2(PixelData* src,
+                               const PixelData* dst,
+                               int pixel_count) {
+  constexpr int kPixelsPerLoad = 4;
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m128i pixels = Load128(src + i);
+    if (AllOpaque(pixels))
+      continue;
+    if (AllTransparent(pixels))
+      Store128(src + i, Load128(dst + i));
+    else
+      BlendSrcOverDstRawRowScalar(src + i, dst + i, kPixelsPerLoad);
+  }
+  BlendSrcOverDstRawRowScalar(src + i, dst + i, pixel_count - i);
+}
+
+constexpr Kernels kSSE2Kernels = {
+    InstructionSet::kSSE2,
+    SetRGBAPremultiplyRowSSE2,
+    SetRGBARawRowSSE2,
+    SetRGBRowScalar,
+    SetBGRRowScalar,
+    BlendRGBAPremultipliedRowSSE2,
+    BlendRGBARawRowSSE2,
+    BlendSrcOverDstPremultipliedRowSSE2,
+    BlendSrcOverDstRawRowSSE2,
+};
+
+// SSSE3 adds byte shuffles, which expand 3-byte pixels.
+
+// Returns the shuffle expanding 4 packed 3-byte pixels to 4-byte pixels with
+// a zero fourth byte, reversing the order of the three bytes if |reverse|.
+ALWAYS_INLINE __m128i ExpandShuffle(bool reverse) {
+  return reverse ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11,
+                                 10, 9, -1)
+                 : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10,
+                                 11, -1);
+}
+
+// Returns whether RGB (or, if |bgr|, BGR) bytes are reversed in SkPMColor
+// order.
+constexpr bool ReverseToN32(bool bgr) {
+#if SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+  return !bgr;
+#else
+  return bgr;
+#endif
+}
+
+template <bool kBGR>
+TARGET_SSSE3 void SetRGBRowSSSE3(const uint8_t* src,
+                                 int pixel_count,
+                                 PixelData* dst) {
+  constexpr int kPixelsPerLoad = 4;
+  const __m128i shuffle = ExpandShuffle(ReverseToN32(kBGR));
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xff000000));
+  int i = 0;
+  // Each load reads 16 bytes but only uses the first 12, so stop while there
+  // are at least 6 pixels left to stay within the row.
+  for (; i + 6 <= pixel_count; i += kPixelsPerLoad) {
+    const __m128i pixels = _mm_shuffle_epi8(Load128(src), shuffle);
+    Store128(dst + i, _mm_or_si128(pixels, opaque));
+    src += kPixelsPerLoad * 3;
+  }
+  if (kBGR)
+    SetBGRRowScalar(src, pixel_count - i, dst + i);
+  else
+    SetRGBRowScalar(src, pixel_count - i, dst + i);
+}
+
+constexpr Kernels kSSSE3Kernels = {
+    InstructionSet::kSSSE3,
+    SetRGBAPremultiplyRowSSE2,
+    SetRGBARawRowSSE2,
+    SetRGBRowSSSE3<false>,
+    SetRGBRowSSSE3<true>,
+    BlendRGBAPremultipliedRowSSE2,
+    BlendRGBARawRowSSE2,
+    BlendSrcOverDstPremultipliedRowSSE2,
+    BlendSrcOverDstRawRowSSE2,
+};
+
+// AVX2 helpers, processing 8 pixels. Unpacking, packing and 16-bit shuffles
+// work within each 128-bit half, so these mirror the SSE2 helpers.
+
+TARGET_AVX2 ALWAYS_INLINE __m256i SwapRB(__m256i pixels) {
+  const __m256i ga = _mm256_and_si256(
+      pixels, _mm256_set1_epi32(static_cast<int>(0xff00ff00)));
+  __m256i rb = _mm256_and_si256(pixels, _mm256_set1_epi32(0x00ff00ff));
+  rb = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(rb, 0xb1), 0xb1);
+  return _mm256_or_si256(ga, rb);
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i RGBAToN32(__m256i rgba) {
+#if SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+  return SwapRB(rgba);
+#else
+  return rgba;
+#endif
+}
+
+TARGET_AVX2 ALWAYS_INLINE bool AllOpaque(__m256i pixels) {
+  const uint32_t mask = static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(pixels, _mm256_set1_epi8(-1))));
+  return (mask & 0x88888888u) == 0x88888888u;
+}
+
+TARGET_AVX2 ALWAYS_INLINE bool AllTransparent(__m256i pixels) {
+  const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(pixels, _mm256_setzero_si256())));
+  return (mask & 0x88888888u) == 0x88888888u;
+}
+
+TARGET_AVX2 ALWAYS_INLINE unsigned AndAlphas(__m256i pixels) {
+  return AndAlphas(_mm_and_si128(_mm256_castsi256_si128(pixels),
+                                 _mm256_extracti128_si256(pixels, 1)));
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i BroadcastAlpha(__m256i pixels) {
+  return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, 0xff), 0xff);
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i Div255(__m256i x) {
+  x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i Premultiply(__m256i pixels) {
+  const __m256i scale =
+      _mm256_or_si256(BroadcastAlpha(pixels),
+                      _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0,
+                                       0, 255, 0, 0, 0));
+  return Div255(_mm256_mullo_epi16(pixels, scale));
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i Premultiply8(__m256i pixels) {
+  const __m256i zero = _mm256_setzero_si256();
+  return _mm256_packus_epi16(Premultiply(_mm256_unpacklo_epi8(pixels, zero)),
+                             Premultiply(_mm256_unpackhi_epi8(pixels, zero)));
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i SrcOver8(__m256i src, __m256i dst) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i k256 = _mm256_set1_epi16(256);
+  const __m256i scale_lo =
+      _mm256_sub_epi16(k256, BroadcastAlpha(_mm256_unpacklo_epi8(src, zero)));
+  const __m256i scale_hi =
+      _mm256_sub_epi16(k256, BroadcastAlpha(_mm256_unpackhi_epi8(src, zero)));
+  const __m256i dst_lo = _mm256_srli_epi16(
+      _mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), scale_lo), 8);
+  const __m256i dst_hi = _mm256_srli_epi16(
+      _mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), scale_hi), 8);
+  return _mm256_add_epi8(src, _mm256_packus_epi16(dst_lo, dst_hi));
+}
+
+TARGET_AVX2 ALWAYS_INLINE __m256i Load256(const void* src) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+}
+
+TARGET_AVX2 ALWAYS_INLINE void Store256(void* dst, __m256i pixels) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), pixels);
+}
+
+TARGET_AVX2 void SetRGBAPremultiplyRowAVX2(const uint8_t* src,
+                                           int pixel_count,
+                                           PixelData* dst,
+                                           unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 8;
+  __m256i alpha_and = _mm256_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    __m256i rgba = Load256(src);
+    alpha_and = _mm256_and_si256(alpha_and, rgba);
+    if (!AllOpaque(rgba))
+      rgba = Premultiply8(rgba);
+    Store256(dst + i, RGBAToN32(rgba));
+    src += kPixelsPerLoad * 4;
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  SetRGBAPremultiplyRowSSE2(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+TARGET_AVX2 void SetRGBARawRowAVX2(const uint8_t* src,
+                                   int pixel_count,
+                                   PixelData* dst,
+                                   unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 8;
+  __m256i alpha_and = _mm256_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m256i rgba = Load256(src);
+    alpha_and = _mm256_and_si256(alpha_and, rgba);
+    Store256(dst + i, RGBAToN32(rgba));
+    src += kPixelsPerLoad * 4;
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  SetRGBARawRowSSE2(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+template <bool kBGR>
+TARGET_AVX2 void SetRGBRowAVX2(const uint8_t* src,
+                               int pixel_count,
+                               PixelData* dst) {
+  constexpr int kPixelsPerLoad = 8;
+  const __m256i shuffle =
+      _mm256_broadcastsi128_si256(ExpandShuffle(ReverseToN32(kBGR)));
+  const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xff000000));
+  int i = 0;
+  // The second half is loaded from byte 12 and reads up to byte 28, so stop
+  // while there are at least 10 pixels left to stay within the row.
+  for (; i + 10 <= pixel_count; i += kPixelsPerLoad) {
+    const __m256i packed = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(Load128(src)), Load128(src + 12), 1);
+    Store256(dst + i,
+             _mm256_or_si256(_mm256_shuffle_epi8(packed, shuffle), opaque));
+    src += kPixelsPerLoad * 3;
+  }
+  SetRGBRowSSSE3<kBGR>(src, pixel_count - i, dst + i);
+}
+
+TARGET_AVX2 void BlendRGBAPremultipliedRowAVX2(const uint8_t* src,
+                                               int pixel_count,
+                                               PixelData* dst,
+                                               unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 8;
+  __m256i alpha_and = _mm256_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m256i rgba = Load256(src);
+    alpha_and = _mm256_and_si256(alpha_and, rgba);
+    src += kPixelsPerLoad * 4;
+    if (AllTransparent(rgba))
+      continue;
+    if (AllOpaque(rgba)) {
+      Store256(dst + i, RGBAToN32(rgba));
+      continue;
+    }
+    Store256(dst + i,
+             SrcOver8(RGBAToN32(Premultiply8(rgba)), Load256(dst + i)));
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  BlendRGBAPremultipliedRowSSE2(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+TARGET_AVX2 void BlendRGBARawRowAVX2(const uint8_t* src,
+                                     int pixel_count,
+                                     PixelData* dst,
+                                     unsigned* alpha_mask) {
+  constexpr int kPixelsPerLoad = 8;
+  __m256i alpha_and = _mm256_set1_epi8(-1);
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m256i rgba = Load256(src);
+    alpha_and = _mm256_and_si256(alpha_and, rgba);
+    if (!AllTransparent(rgba))
+      BlendRGBARawRowSSE2(src, kPixelsPerLoad, dst + i, alpha_mask);
+    src += kPixelsPerLoad * 4;
+  }
+  *alpha_mask &= AndAlphas(alpha_and);
+  BlendRGBARawRowSSE2(src, pixel_count - i, dst + i, alpha_mask);
+}
+
+TARGET_AVX2 void BlendSrcOverDstPremultipliedRowAVX2(PixelData* src,
+                                                     const PixelData* dst,
+                                                     int pixel_count) {
+  constexpr int kPixelsPerLoad = 8;
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m256i pixels = Load256(src + i);
+    if (!AllOpaque(pixels))
+      Store256(src + i, SrcOver8(pixels, Load256(dst + i)));
+  }
+  BlendSrcOverDstPremultipliedRowSSE2(src + i, dst + i, pixel_count - i);
+}
+
+TARGET_AVX2 void BlendSrcOverDstRawRowAVX2(PixelData* src,
+                                           const PixelData* dst,
+                                           int pixel_count) {
+  constexpr int kPixelsPerLoad = 8;
+  int i = 0;
+  for (; i + kPixelsPerLoad <= pixel_count; i += kPixelsPerLoad) {
+    const __m256i pixels = Load256(src + i);
+    if (AllOpaque(pixels))
+      continue;
+    if (AllTransparent(pixels))
+      Store256(src + i, Load256(dst + i));
+    else
+      BlendSrcOverDstRawRowSSE2(src + i, dst + i, kPixelsPerLoad);
+  }
+  BlendSrcOverDstRawRowSSE2(src + i, dst + i, pixel_count - i);
+}
+
+constexpr Kernels kAVX2Kernels = {
+    InstructionSet::kAVX2,
+    SetRGBAPremultiplyRowAVX2,
+    SetRGBARawRowAVX2,
+    SetRGBRowAVX2<false>,
+    SetRGBRowAVX2<true>,
+    BlendRGBAPremultipliedRowAVX2,
+    BlendRGBARawRowAVX2,
+    BlendSrcOverDstPremultipliedRowAVX2,
+    BlendSrcOverDstRawRowAVX2,
+};
+
+#undef TARGET_SSSE3
+#undef TARGET_AVX2
+
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+
+// Premultiply RGB color channels by alpha, swizzle RGBA to SkPMColor
+// order, and return the AND of all alpha channels.
+void SetRGBAPremultiplyRowNeon(const uint8_t* src_ptr,
+                               const int pixel_count,
+                               PixelData* dst_pixel,
+                               unsigned* const alpha_mask) {
+  DCHECK(dst_pixel);
+  DCHECK(alpha_mask);
+
+  constexpr int kPixelsPerLoad = 8;
+  // Input registers.
+  uint8x8x4_t rgba;
+  // Alpha mask.
+  uint8x8_t alpha_mask_vector = vdup_n_u8(255);
+
+  // Scale the color channel by alpha - the opacity coefficient.
+  auto premultiply = [](uint8x8_t c, uint8x8_t a) {
+    // First multiply the color by alpha, expanding to 16-bit (max 255*255).
+    uint16x8_t ca = vmull_u8(c, a);
+    // Now we need to round back down to 8-bit, returning (x+127)/255.
+    // (x+127)/255 == (x + ((x+128)>>8) + 128)>>8.  This form is well suited
+    // to NEON: vrshrq_n_u16(...,8) gives the inner (x+128)>>8, and
+    // vraddhn_u16() both the outer add-shift and our conversion back to 8-bit.
+    return vraddhn_u16(ca, vrshrq_n_u16(ca, 8));
+  };
+
+  int i = pixel_count;
+  for (; i >= kPixelsPerLoad; i -= kPixelsPerLoad) {
+    // Reads 8 pixels at once, each color channel in a different
+    // 64-bit register.
+    rgba = vld4_u8(src_ptr);
+    // AND pixel alpha values into the alpha detection mask.
+    alpha_mask_vector = vand_u8(alpha_mask_vector, rgba.val[3]);
+
+    uint64_t alphas_u64 = vget_lane_u64(vreinterpret_u64_u8(rgba.val[3]), 0);
+
+    // If all of the pixels are opaque, no need to premultiply.
+    if (~alphas_u64 == 0) {
+#if SK_PMCOLOR_BYTE_ORDER(R, G, B, A)
+      // Already in right order, write back (interleaved) results to memory.
+      vst4_u8(reinterpret_cast<uint8_t*>(dst_pixel), rgba);
+
+#elif SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+      // Re-order color channels for BGRA.
+      uint8x8x4_t bgra = {rgba.val[2], rgba.val[1], rgba.val[0], rgba.val[3]};
+      // Write back (interleaved) results to memory.
+      vst4_u8(reinterpret_cast<uint8_t*>(dst_pixel), bgra);
+
+#endif
+
+    } else {
+#if SK_PMCOLOR_BYTE_ORDER(R, G, B, A)
+      // Premultiply color channels, already in right order.
+      rgba.val[0] = premultiply(rgba.val[0], rgba.val[3]);
+      rgba.val[1] = premultiply(rgba.val[1], rgba.val[3]);
+      rgba.val[2] = premultiply(rgba.val[2], rgba.val[3]);
+      // Write back (interleaved) results to memory.
+      vst4_u8(reinterpret_cast<uint8_t*>(dst_pixel), rgba);
+
+#elif SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+      uint8x8x4_t bgra;
+      // Premultiply and re-order color channels for BGRA.
+      bgra.val[0] = premultiply(rgba.val[2], rgba.val[3]);
+      bgra.val[1] = premultiply(rgba.val[1], rgba.val[3]);
+      bgra.val[2] = premultiply(rgba.val[0], rgba.val[3]);
+      bgra.val[3] = rgba.val[3];
+      // Write back (interleaved) results to memory.
+      vst4_u8(reinterpret_cast<uint8_t*>(dst_pixel), bgra);
+
+#endif
+    }
+
+    // Advance to next elements.
+    src_ptr += kPixelsPerLoad * 4;
+    dst_pixel += kPixelsPerLoad;
+  }
+
+  // AND together the 8 alpha values in the alpha_mask_vector.
+  uint64_t alpha_mask_u64 =
+      vget_lane_u64(vreinterpret_u64_u8(alpha_mask_vector), 0);
+  alpha_mask_u64 &= (alpha_mask_u64 >> 32);
+  alpha_mask_u64 &= (alpha_mask_u64 >> 16);
+  alpha_mask_u64 &= (alpha_mask_u64 >> 8);
+  *alpha_mask &= alpha_mask_u64;
+
+  // Handle the tail elements.
+  SetRGBAPremultiplyRowScalar(src_ptr, i, dst_pixel, alpha_mask);
+}
+
+// Swizzle RGBA to SkPMColor order, and return the AND of all alpha channels.
+void SetRGBARawRowNeon(const uint8_t* src_ptr,
+                       const int pixel_count,
+                       PixelData* dst_pixel,
+                       unsigned* const alpha_mask) {
+  DCHECK(dst_pixel);
+  DCHECK(alpha_mask);
+
+  constexpr int kPixelsPerLoad = 16;
+  // Input registers.
+  uint8x16x4_t rgba;
+  // Alpha mask.
+  uint8x16_t alpha_mask_vector = vdupq_n_u8(255);
+
+  int i = pixel_count;
+  for (; i >= kPixelsPerLoad; i -= kPixelsPerLoad) {
+    // Reads 16 pixels at once, each color channel in a different
+    // 128-bit register.
+    rgba = vld4q_u8(src_ptr);
+    // AND pixel alpha values into the alpha detection mask.
+    alpha_mask_vector = vandq_u8(alpha_mask_vector, rgba.val[3]);
+
+#if SK_PMCOLOR_BYTE_ORDER(R, G, B, A)
+    // Already in right order, write back (interleaved) results to memory.
+    vst4q_u8(reinterpret_cast<uint8_t*>(dst_pixel), rgba);
+
+#elif SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+    // Re-order color channels for BGRA.
+    uint8x16x4_t bgra = {rgba.val[2], rgba.val[1], rgba.val[0], rgba.val[3]};
+    // Write back (interleaved) results to memory.
+    vst4q_u8(reinterpret_cast<uint8_t*>(dst_pixel), bgra);
+
+#endif
+
+    // Advance to next elements.
+    src_ptr += kPixelsPerLoad * 4;
+    dst_pixel += kPixelsPerLoad;
+  }
+
+  // AND together the 16 alpha values in the alpha_mask_vector.
+  uint64_t alpha_mask_u64 =
+      vget_lane_u64(vreinterpret_u64_u8(vget_low_u8(alpha_mask_vector)), 0);
+  alpha_mask_u64 &=
+      vget_lane_u64(vreinterpret_u64_u8(vget_high_u8(alpha_mask_vector)), 0);
+  alpha_mask_u64 &= (alpha_mask_u64 >> 32);
+  alpha_mask_u64 &= (alpha_mask_u64 >> 16);
+  alpha_mask_u64 &= (alpha_mask_u64 >> 8);
+  *alpha_mask &= alpha_mask_u64;
+
+  // Handle the tail elements.
+  SetRGBARawRowScalar(src_ptr, i, dst_pixel, alpha_mask);
+}
+
+// Swizzle RGB (or, if |kBGR|, BGR) to opaque SkPMColor order.
+template <bool kBGR>
+void SetRGBRowNeon(const uint8_t* src_ptr,
+                   const int pixel_count,
+                   PixelData* dst_pixel) {
+  DCHECK(dst_pixel);
+
+  constexpr int kPixelsPerLoad = 16;
+  // Input registers.
+  uint8x16x3_t rgb;
+
+  int i = pixel_count;
+  for (; i >= kPixelsPerLoad; i -= kPixelsPerLoad) {
+    // Reads 16 pixels at once, each color channel in a different
+    // 128-bit register.
+    rgb = vld3q_u8(src_ptr);
+    if (kBGR)
+      std::swap(rgb.val[0], rgb.val[2]);
+
+#if SK_PMCOLOR_BYTE_ORDER(R, G, B, A)
+    // RGB already in right order, add opaque alpha channel.
+    uint8x16x4_t rgba = {rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255)};
+    // Write back (interleaved) results to memory.
+    vst4q_u8(reinterpret_cast<uint8_t*>(dst_pixel), rgba);
+
+#elif SK_PMCOLOR_BYTE_ORDER(B, G, R, A)
+    // Re-order color channels for BGR, add opaque alpha channel.
+    uint8x16x4_t bgra = {rgb.val[2], rgb.val[1], rgb.val[0], vdupq_n_u8(255)};
+    // Write back (interleaved) results to memory.
+    vst4q_u8(reinterpret_cast<uint8_t*>(dst_pixel), bgra);
+
+#endif
+
+    // Advance to next elements.
+    src_ptr += kPixelsPerLoad * 3;
+    dst_pixel += kPixelsPerLoad;
+  }
+
+  // Handle the tail elements.
+  if (kBGR)
+    SetBGRRowScalar(src_ptr, i, dst_pixel);
+  else
+    SetRGBRowScalar(src_ptr, i, dst_pixel);
+}
+
+constexpr Kernels kNeonKernels = {
+    InstructionSet::kNEON,
+    SetRGBAPremultiplyRowNeon,
+    SetRGBARawRowNeon,
+    SetRGBRowNeon<false>,
+    SetRGBRowNeon<true>,
+    BlendRGBAPremultipliedRowScalar,
+    BlendRGBARawRowScalar,
+    BlendSrcOverDstPremultipliedRowScalar,
+    BlendSrcOverDstRawRowScalar,
+};
+
+#endif
+
+// Returns the kernels for |instruction_set|, or nullptr if this CPU doesn't
+// support it.
+const Kernels* KernelsFor(InstructionSet instruction_set) {
+  switch (instruction_set) {
+    case InstructionSet::kScalar:
+      return &kScalarKernels;
+#if defined(ARCH_CPU_X86_FAMILY)
+    case InstructionSet::kSSE2:
+      return &kSSE2Kernels;
+    case InstructionSet::kSSSE3:
+      return base::CPU().has_ssse3() ? &kSSSE3Kernels : nullptr;
+    case InstructionSet::kAVX2:
+      return base::CPU().has_avx2() ? &kAVX2Kernels : nullptr;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+    case InstructionSet::kNEON:
+      return &kNeonKernels;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+const Kernels& DefaultKernels() {
+  static const Kernels& kernels = []() -> const Kernels& {
+    for (InstructionSet instruction_set :
+         {InstructionSet::kAVX2, InstructionSet::kSSSE3, InstructionSet::kSSE2,
+          InstructionSet::kNEON}) {
+      if (const Kernels* kernels = KernelsFor(instruction_set))
+        return *kernels;
+    }
+    return kScalarKernels;
+  }();
+  return kernels;
+}
+
+const Kernels* g_kernels_for_testing = nullptr;
+
+ALWAYS_INLINE const Kernels& CurrentKernels() {
+  if (UNLIKELY(g_kernels_for_testing))
+    return *g_kernels_for_testing;
+  return DefaultKernels();
+}
+
+}  // namespace
+
+void SetRGBAPremultiplyRow(const uint8_t* src,
+                           int pixel_count,
+                           PixelData* dst,
+                           unsigned* alpha_mask) {
+  CurrentKernels().set_rgba_premultiply_row(src, pixel_count, dst, alpha_mask);
+}
+
+void SetRGBARawRow(const uint8_t* src,
+                   int pixel_count,
+                   PixelData* dst,
+                   unsigned* alpha_mask) {
+  CurrentKernels().set_rgba_raw_row(src, pixel_count, dst, alpha_mask);
+}
+
+void SetRGBRow(const uint8_t* src, int pixel_count, PixelData* dst) {
+  CurrentKernels().set_rgb_row(src, pixel_count, dst);
+}
+
+void SetBGRRow(const uint8_t* src, int pixel_count, PixelData* dst) {
+  CurrentKernels().set_bgr_row(src, pixel_count, dst);
+}
+
+void BlendRGBAPremultipliedRow(const uint8_t* src,
+                               int pixel_count,
+                               PixelData* dst,
+                               unsigned* alpha_mask) {
+  CurrentKernels().blend_rgba_premultiplied_row(src, pixel_count, dst,
+                                                alpha_mask);
+}
+
+void BlendRGBARawRow(const uint8_t* src,
+                     int pixel_count,
+                     PixelData* dst,
+                     unsigned* alpha_mask) {
+  CurrentKernels().blend_rgba_raw_row(src, pixel_count, dst, alpha_mask);
+}
+
+void BlendSrcOverDstPremultipliedRow(PixelData* src,
+                                     const PixelData* dst,
+                                     int pixel_count) {
+  CurrentKernels().blend_src_over_dst_premultiplied_row(src, dst, pixel_count);
+}
+
+void BlendSrcOverDstRawRow(PixelData* src,
+                           const PixelData* dst,
+                           int pixel_count) {
+  CurrentKernels().blend_src_over_dst_raw_row(src, dst, pixel_count);
+}
+
+InstructionSet GetInstructionSet() {
+  return CurrentKernels().instruction_set;
+}
+
+bool SetInstructionSetForTesting(InstructionSet instruction_set) {
+  const Kernels* kernels = KernelsFor(instruction_set);
+  if (!kernels)
+    return false;
+  g_kernels_for_testing = kernels;
+  return true;
+}
+
+}  // namespace pixel_row_kernels
+
+}  // namespace blink
@@ -0,0 +1,90 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef THIRD_PARTY_BLINK_RENDERER_PLATFORM_IMAGE_DECODERS_PIXEL_ROW_KERNELS_H_
+#define THIRD_PARTY_BLINK_RENDERER_PLATFORM_IMAGE_DECODERS_PIXEL_ROW_KERNELS_H_
+
+#include <stdint.h>
+
+#include "third_party/blink/renderer/platform/image-decoders/image_frame.h"
+#include "third_party/blink/renderer/platform/platform_export.h"
+
+namespace blink {
+
+// Row conversion kernels shared by the image decoders. Each kernel processes
+// |pixel_count| pixels of one row and writes N32 (SkPMColor order) pixels. The
+// results are bit-identical to the per-pixel ImageFrame helpers named in the
+// comments; only the speed depends on the instruction set.
+//
+// The implementation is picked once at runtime: AVX2, SSSE3 or SSE2 on x86
+// and NEON on ARM, falling back to portable C++ elsewhere.
+namespace pixel_row_kernels {
+
+using PixelData = ImageFrame::PixelData;
+
+// Converts RGBA bytes with ImageFrame::SetRGBAPremultiply(), and ANDs every
+// alpha value into |alpha_mask|. |src| may alias |dst|.
+PLATFORM_EXPORT void SetRGBAPremultiplyRow(const uint8_t* src,
+                                           int pixel_count,
+                                           PixelData* dst,
+                                           unsigned* alpha_mask);
+
+// Converts RGBA bytes with ImageFrame::SetRGBARaw(), and ANDs every alpha
+// value into |alpha_mask|. |src| may alias |dst|.
+PLATFORM_EXPORT void SetRGBARawRow(const uint8_t* src,
+                                   int pixel_count,
+                                   PixelData* dst,
+                                   unsigned* alpha_mask);
+
+// Converts RGB bytes to opaque pixels.
+PLATFORM_EXPORT void SetRGBRow(const uint8_t* src,
+                               int pixel_count,
+                               PixelData* dst);
+
+// Converts BGR bytes, e.g. 24-bit BMP rows, to opaque pixels.
+PLATFORM_EXPORT void SetBGRRow(const uint8_t* src,
+                               int pixel_count,
+                               PixelData* dst);
+
+// Blends RGBA bytes over |dst| with ImageFrame::BlendRGBAPremultiplied(), and
+// ANDs every alpha value into |alpha_mask|.
+PLATFORM_EXPORT void BlendRGBAPremultipliedRow(const uint8_t* src,
+                                               int pixel_count,
+                                               PixelData* dst,
+                                               unsigned* alpha_mask);
+
+// Blends RGBA bytes over |dst| with ImageFrame::BlendRGBARaw(), and ANDs every
+// alpha value into |alpha_mask|.
+PLATFORM_EXPORT void BlendRGBARawRow(const uint8_t* src,
+                                     int pixel_count,
+                                     PixelData* dst,
+                                     unsigned* alpha_mask);
+
+// Blends every non-opaque pixel of |src| over the pixel of the previous frame
+// in |dst|, like ImageFrame::BlendSrcOverDstPremultiplied(), writing the
+// result to |src|. Both rows must hold premultiplied pixels.
+PLATFORM_EXPORT void BlendSrcOverDstPremultipliedRow(PixelData* src,
+                                                     const PixelData* dst,
+                                                     int pixel_count);
+
+// Same as above with ImageFrame::BlendSrcOverDstRaw().
+PLATFORM_EXPORT void BlendSrcOverDstRawRow(PixelData* src,
+                                           const PixelData* dst,
+                                           int pixel_count);
+
+enum class InstructionSet { kScalar, kSSE2, kSSSE3, kAVX2, kNEON };
+
+// Returns the instruction set used by the functions above.
+PLATFORM_EXPORT InstructionSet GetInstructionSet();
+
+// Makes the functions above use |instruction_set|, so that tests can compare
+// every implementation with the scalar one. Returns false, and changes
+// nothing, if the CPU doesn't support |instruction_set|.
+PLATFORM_EXPORT bool SetInstructionSetForTesting(InstructionSet);
+
+}  // namespace pixel_row_kernels
+
+}  // namespace blink
+
+#endif  // THIRD_PARTY_BLINK_RENDERER_PLATFORM_IMAGE_DECODERS_PIXEL_ROW_KERNELS_H_
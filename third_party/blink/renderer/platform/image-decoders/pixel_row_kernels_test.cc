@@ -0,0 +1,191 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/platform/image-decoders/pixel_row_kernels.h"
+
+#include <string.h>
+
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/blink/renderer/platform/wtf/vector.h"
+
+namespace blink {
+
+namespace pixel_row_kernels {
+
+namespace {
+
+// Row lengths covering the empty row, rows shorter than one vector, and rows
+// with every possible tail length after the AVX2 and SSE2 loops.
+constexpr int kPixelCounts[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 67};
+
+// Returns an alpha value which is often 0 or 255, so that rows contain
+// transparent and opaque runs as well as translucent pixels.
+uint8_t RandomAlpha() {
+  switch (base::RandInt(0, 3)) {
+    case 0:
+      return 0;
+    case 1:
+      return 255;
+    default:
+      return base::RandInt(0, 255);
+  }
+}
+
+// RGBA bytes, with some rows having the same alpha for every pixel.
+Vector<uint8_t> RandomRGBA(int pixel_count) {
+  Vector<uint8_t> rgba(pixel_count * 4);
+  base::RandBytes(rgba.data(), rgba.size());
+  const bool uniform_alpha = base::RandInt(0, 1);
+  const uint8_t alpha = RandomAlpha();
+  for (int i = 0; i < pixel_count; ++i)
+    rgba[i * 4 + 3] = uniform_alpha ? alpha : RandomAlpha();
+  return rgba;
+}
+
+// Premultiplied pixels, like the previous frame of an animation.
+Vector<PixelData> RandomPremultipliedPixels(int pixel_count) {
+  Vector<PixelData> pixels(pixel_count);
+  for (PixelData& pixel : pixels) {
+    ImageFrame::SetRGBAPremultiply(&pixel, base::RandInt(0, 255),
+                                   base::RandInt(0, 255),
+                                   base::RandInt(0, 255), RandomAlpha());
+  }
+  return pixels;
+}
+
+class PixelRowKernelsTest : public testing::TestWithParam<InstructionSet> {
+ protected:
+  void SetUp() override {
+    original_instruction_set_ = GetInstructionSet();
+    if (!SetInstructionSetForTesting(GetParam()))
+      GTEST_SKIP() << "Instruction set not supported";
+  }
+
+  void TearDown() override {
+    SetInstructionSetForTesting(original_instruction_set_);
+  }
+
+  // Runs |kernel| with the scalar implementation and with the one under test,
+  // and checks that they give the same result.
+  template <typename Kernel>
+  void ExpectSameAsScalar(Kernel kernel) {
+    for (int round = 0; round < 20; ++round) {
+      for (int pixel_count : kPixelCounts) {
+        SCOPED_TRACE(pixel_count);
+        const Vector<uint8_t> src = RandomRGBA(pixel_count);
+        const Vector<PixelData> initial_dst =
+            RandomPremultipliedPixels(pixel_count);
+
+        Vector<PixelData> expected = initial_dst;
+        unsigned expected_alpha_mask = 255;
+        SetInstructionSetForTesting(InstructionSet::kScalar);
+        kernel(src, expected, &expected_alpha_mask);
+
+        Vector<PixelData> actual = initial_dst;
+        unsigned actual_alpha_mask = 255;
+        SetInstructionSetForTesting(GetParam());
+        kernel(src, actual, &actual_alpha_mask);
+
+        EXPECT_EQ(expected, actual);
+        EXPECT_EQ(expected_alpha_mask, actual_alpha_mask);
+      }
+    }
+  }
+
+ private:
+  InstructionSet original_instruction_set_;
+};
+
+TEST_P(PixelRowKernelsTest, SetRGBAPremultiplyRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned* alpha_mask) {
+    SetRGBAPremultiplyRow(src.data(), dst.size(), dst.data(), alpha_mask);
+  });
+}
+
+TEST_P(PixelRowKernelsTest, SetRGBAPremultiplyRowInPlace) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned* alpha_mask) {
+    memcpy(dst.data(), src.data(), src.size());
+    SetRGBAPremultiplyRow(reinterpret_cast<const uint8_t*>(dst.data()),
+                          dst.size(), dst.data(), alpha_mask);
+  });
+}
+
+TEST_P(PixelRowKernelsTest, SetRGBARawRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned* alpha_mask) {
+    SetRGBARawRow(src.data(), dst.size(), dst.data(), alpha_mask);
+  });
+}
+
+TEST_P(PixelRowKernelsTest, SetRGBRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned*) {
+    SetRGBRow(src.data(), dst.size(), dst.data());
+  });
+}
+
+TEST_P(PixelRowKernelsTest, SetBGRRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned*) {
+    SetBGRRow(src.data(), dst.size(), dst.data());
+  });
+}
+
+TEST_P(PixelRowKernelsTest, BlendRGBAPremultipliedRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned* alpha_mask) {
+    BlendRGBAPremultipliedRow(src.data(), dst.size(), dst.data(), alpha_mask);
+  });
+}
+
+TEST_P(PixelRowKernelsTest, BlendRGBARawRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned* alpha_mask) {
+    BlendRGBARawRow(src.data(), dst.size(), dst.data(), alpha_mask);
+  });
+}
+
+TEST_P(PixelRowKernelsTest, BlendSrcOverDstPremultipliedRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned*) {
+    // Blend the premultiplied source over the previous frame in |dst|, and
+    // write the result back to |dst|.
+    Vector<PixelData> current(dst.size());
+    for (wtf_size_t i = 0; i < dst.size(); ++i) {
+      ImageFrame::SetRGBAPremultiply(&current[i], src[i * 4], src[i * 4 + 1],
+                                     src[i * 4 + 2], src[i * 4 + 3]);
+    }
+    BlendSrcOverDstPremultipliedRow(current.data(), dst.data(), dst.size());
+    dst = current;
+  });
+}
+
+TEST_P(PixelRowKernelsTest, BlendSrcOverDstRawRow) {
+  ExpectSameAsScalar([](const Vector<uint8_t>& src, Vector<PixelData>& dst,
+                        unsigned*) {
+    Vector<PixelData> current(dst.size());
+    for (wtf_size_t i = 0; i < dst.size(); ++i) {
+      ImageFrame::SetRGBARaw(&current[i], src[i * 4], src[i * 4 + 1],
+                             src[i * 4 + 2], src[i * 4 + 3]);
+    }
+    BlendSrcOverDstRawRow(current.data(), dst.data(), dst.size());
+    dst = current;
+  });
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         PixelRowKernelsTest,
+                         testing::Values(InstructionSet::kSSE2,
+                                         InstructionSet::kSSSE3,
+                                         InstructionSet::kAVX2,
+                                         InstructionSet::kNEON));
+
+}  // namespace
+
+}  // namespace pixel_row_kernels
+
+}  // namespace blink
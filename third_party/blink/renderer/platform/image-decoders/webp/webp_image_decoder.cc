@@ -34,6 +34,7 @@
 #include "base/logging.h"
 #include "base/metrics/histogram_macros.h"
 #include "build/build_config.h"
+#include "third_party/blink/renderer/platform/image-decoders/pixel_row_kernels.h"
 #include "third_party/blink/renderer/platform/runtime_enabled_features.h"
 #include "third_party/blink/renderer/platform/wtf/wtf.h"
 #include "third_party/skia/include/core/SkData.h"
@@ -77,24 +78,15 @@ inline void findBlendRangeAtRow(const gfx::Rect& src,
   }
 }
 
-// alphaBlendPremultiplied and alphaBlendNonPremultiplied are separate methods,
-// even though they only differ by one line. This is done so that the compiler
-// can inline BlendSrcOverDstPremultiplied() and BlensSrcOverDstRaw() calls.
-// For GIF images, this optimization reduces decoding time by 15% for 3MB
-// images.
+// Blends the non-opaque pixels of |src| in [left, left + width) at row
+// |canvasY| over the pixels of |dst|.
 void alphaBlendPremultiplied(blink::ImageFrame& src,
                              blink::ImageFrame& dst,
                              int canvasY,
                              int left,
                              int width) {
-  for (int x = 0; x < width; ++x) {
-    int canvasX = left + x;
-    blink::ImageFrame::PixelData* pixel = src.GetAddr(canvasX, canvasY);
-    if (SkGetPackedA32(*pixel) != 0xff) {
-      blink::ImageFrame::PixelData prevPixel = *dst.GetAddr(canvasX, canvasY);
-      blink::ImageFrame::BlendSrcOverDstPremultiplied(pixel, prevPixel);
-    }
-  }
+  blink::pixel_row_kernels::BlendSrcOverDstPremultipliedRow(
+      src.GetAddr(left, canvasY), dst.GetAddr(left, canvasY), width);
 }
 
 void alphaBlendNonPremultiplied(blink::ImageFrame& src,
@@ -102,14 +94,8 @@ void alphaBlendNonPremultiplied(blink::ImageFrame& src,
                                 int canvasY,
                                 int left,
                                 int width) {
-  for (int x = 0; x < width; ++x) {
-    int canvasX = left + x;
-    blink::ImageFrame::PixelData* pixel = src.GetAddr(canvasX, canvasY);
-    if (SkGetPackedA32(*pixel) != 0xff) {
-      blink::ImageFrame::PixelData prevPixel = *dst.GetAddr(canvasX, canvasY);
-      blink::ImageFrame::BlendSrcOverDstRaw(pixel, prevPixel);
-    }
-  }
+  blink::pixel_row_kernels::BlendSrcOverDstRawRow(
+      src.GetAddr(left, canvasY), dst.GetAddr(left, canvasY), width);
 }
 
 // Do not rename entries nor reuse numeric values. See the following link for
@@ -557,11 +543,17 @@ void WEBPImageDecoder::ApplyPostProcessing(wtf_size_t frame_index) {
           row, kSrcFormat, alpha_format, xform->SrcProfile(), row, kDstFormat,
           alpha_format, xform->DstProfile(), width);
       DCHECK(color_conversion_successful);
-      uint8_t* pixel = row;
-      for (int x = 0; x < width; ++x, pixel += 4) {
-        const int canvas_x = left + x;
-        buffer.SetRGBA(canvas_x, canvas_y, pixel[0], pixel[1], pixel[2],
-                       pixel[3]);
+      // Premultiply and swizzle the transformed RGBA pixels in place. The
+      // kernels also report whether a pixel has alpha, which isn't needed:
+      // the frame's has-alpha is set from ALPHA_FLAG when it is complete.
+      ImageFrame::PixelData* const pixels = buffer.GetAddr(left, canvas_y);
+      unsigned unused_alpha_mask = 255;
+      if (buffer.PremultiplyAlpha()) {
+        pixel_row_kernels::SetRGBAPremultiplyRow(row, width, pixels,
+                                                 &unused_alpha_mask);
+      } else {
+        pixel_row_kernels::SetRGBARawRow(row, width, pixels,
+                                         &unused_alpha_mask);
       }
     }
   }
@@ -0,0 +1,190 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/platform/json/json_document.h"
+
+#include "base/notreached.h"
+#include "third_party/blink/renderer/platform/wtf/text/ascii_ctype.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+
+namespace blink {
+
+namespace {
+
+// Decodes the escape sequences of a string which the parser has validated.
+template <typename CharType>
+String DecodeString(const CharType* characters, wtf_size_t length) {
+  StringBuilder buffer;
+  buffer.ReserveCapacity(length);
+  const CharType* end = characters + length;
+  for (const CharType* pos = characters; pos < end;) {
+    UChar c = *pos++;
+    if ('\\' != c) {
+      buffer.Append(c);
+      continue;
+    }
+    c = *pos++;
+    switch (c) {
+      case '"':
+      case '/':
+      case '\\':
+        break;
+      case 'b':
+        c = '\b';
+        break;
+      case 'f':
+        c = '\f';
+        break;
+      case 'n':
+        c = '\n';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'v':
+        c = '\v';
+        break;
+      case 'u':
+        c = (ToASCIIHexValue(pos[0], pos[1]) << 8) |
+            ToASCIIHexValue(pos[2], pos[3]);
+        pos += 4;
+        break;
+      default:
+        NOTREACHED();
+    }
+    buffer.Append(c);
+  }
+  return buffer.ToString();
+}
+
+// Keeps the string 8-bit if it can be, as StringBuilder does.
+String MakeString(const UChar* characters, wtf_size_t length) {
+  for (wtf_size_t i = 0; i < length; ++i) {
+    if (characters[i] > 0xFF)
+      return String(characters, length);
+  }
+  return String::Make8BitFrom16BitSource(characters, length);
+}
+
+}  // namespace
+
+String JSONNode::SourceString::Decode() const {
+  if (is_8bit) {
+    const LChar* chars = static_cast<const LChar*>(characters);
+    return has_escapes ? DecodeString(chars, length) : String(chars, length);
+  }
+  const UChar* chars = static_cast<const UChar*>(characters);
+  return has_escapes ? DecodeString(chars, length) : MakeString(chars, length);
+}
+
+bool JSONNode::SourceString::Equals(const StringView& other) const {
+  if (has_escapes)
+    return Decode() == other;
+  if (length != other.length())
+    return false;
+  if (is_8bit)
+    return StringView(static_cast<const LChar*>(characters), length) == other;
+  return StringView(static_cast<const UChar*>(characters), length) == other;
+}
+
+bool JSONNode::AsBoolean(bool* output) const {
+  if (type_ != JSONValue::kTypeBoolean)
+    return false;
+  *output = bool_value_;
+  return true;
+}
+
+bool JSONNode::AsDouble(double* output) const {
+  if (type_ == JSONValue::kTypeDouble) {
+    *output = double_value_;
+    return true;
+  }
+  if (type_ == JSONValue::kTypeInteger) {
+    *output = integer_value_;
+    return true;
+  }
+  return false;
+}
+
+bool JSONNode::AsInteger(int* output) const {
+  if (type_ != JSONValue::kTypeInteger)
+    return false;
+  *output = integer_value_;
+  return true;
+}
+
+bool JSONNode::AsString(String* output) const {
+  if (type_ != JSONValue::kTypeString)
+    return false;
+  *output = string_value_.Decode();
+  return true;
+}
+
+const JSONNode* JSONNode::at(wtf_size_t index) const {
+  if (type_ != JSONValue::kTypeArray || index >= size_)
+    return nullptr;
+  const JSONNode* child = first_child_;
+  for (; index; --index)
+    child = child->next_sibling_;
+  return child;
+}
+
+const JSONNode* JSONNode::Get(const StringView& name) const {
+  if (type_ != JSONValue::kTypeObject)
+    return nullptr;
+  const JSONNode* result = nullptr;
+  for (const JSONNode* child = first_child_; child;
+       child = child->next_sibling_) {
+    if (child->key_.Equals(name))
+      result = child;
+  }
+  return result;
+}
+
+String JSONNode::Key() const {
+  if (!key_.characters)
+    return String();
+  return key_.Decode();
+}
+
+std::unique_ptr<JSONValue> JSONNode::ToJSONValue() const {
+  switch (type_) {
+    case JSONValue::kTypeNull:
+      return JSONValue::Null();
+    case JSONValue::kTypeBoolean:
+      return std::make_unique<JSONBasicValue>(bool_value_);
+    case JSONValue::kTypeInteger:
+      return std::make_unique<JSONBasicValue>(integer_value_);
+    case JSONValue::kTypeDouble:
+      return std::make_unique<JSONBasicValue>(double_value_);
+    case JSONValue::kTypeString:
+      return std::make_unique<JSONString>(string_value_.Decode());
+    case JSONValue::kTypeObject: {
+      auto object = std::make_unique<JSONObject>();
+      for (const JSONNode* child = first_child_; child;
+           child = child->next_sibling_) {
+        object->SetValue(child->key_.Decode(), child->ToJSONValue());
+      }
+      return object;
+    }
+    case JSONValue::kTypeArray: {
+      auto array = std::make_unique<JSONArray>();
+      for (const JSONNode* child = first_child_; child;
+           child = child->next_sibling_) {
+        array->PushValue(child->ToJSONValue());
+      }
+      return array;
+    }
+  }
+  NOTREACHED();
+  return nullptr;
+}
+
+JSONDocument::JSONDocument(const String& source)
+    : source_(source), arena_(WTF::PODArena::Create()) {}
+
+}  // namespace blink
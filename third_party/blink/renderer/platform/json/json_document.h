@@ -0,0 +1,128 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef THIRD_PARTY_BLINK_RENDERER_PLATFORM_JSON_JSON_DOCUMENT_H_
+#define THIRD_PARTY_BLINK_RENDERER_PLATFORM_JSON_JSON_DOCUMENT_H_
+
+#include <memory>
+
+#include "base/memory/scoped_refptr.h"
+#include "third_party/blink/renderer/platform/json/json_values.h"
+#include "third_party/blink/renderer/platform/platform_export.h"
+#include "third_party/blink/renderer/platform/wtf/allocator/allocator.h"
+#include "third_party/blink/renderer/platform/wtf/pod_arena.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_view.h"
+#include "third_party/blink/renderer/platform/wtf/text/wtf_string.h"
+
+namespace blink {
+
+class JSONDocumentBuilder;
+
+// A value of a JSONDocument. Nodes are allocated in the arena of their
+// document, and are only valid while the document is alive.
+//
+// Strings, including the names of object members, point into the parsed
+// source and are only decoded when asked for, so reading a few members of a
+// large document doesn't pay for the strings of the others.
+class PLATFORM_EXPORT JSONNode {
+  DISALLOW_NEW();
+
+ public:
+  JSONNode(const JSONNode&) = delete;
+  JSONNode& operator=(const JSONNode&) = delete;
+
+  JSONValue::ValueType GetType() const { return type_; }
+  bool IsNull() const { return type_ == JSONValue::kTypeNull; }
+
+  // Same as the JSONValue functions of the same name.
+  bool AsBoolean(bool* output) const;
+  bool AsDouble(double* output) const;
+  bool AsInteger(int* output) const;
+  bool AsString(String* output) const;
+
+  // Number of elements of an array or members of an object, 0 otherwise.
+  wtf_size_t size() const { return IsContainer() ? size_ : 0; }
+
+  // The first element of an array or member of an object, or nullptr.
+  const JSONNode* FirstChild() const {
+    return IsContainer() ? first_child_ : nullptr;
+  }
+  // The element or member following this one in its parent, or nullptr.
+  const JSONNode* NextSibling() const { return next_sibling_; }
+
+  // The element at |index| of an array, or nullptr. Linear in |index|.
+  const JSONNode* at(wtf_size_t index) const;
+
+  // The value of member |name| of an object, or nullptr. When a name appears
+  // more than once the last value wins, like in JSONObject. Names without
+  // escape sequences are compared in place.
+  const JSONNode* Get(const StringView& name) const;
+  // The name of this member, if the parent is an object.
+  String Key() const;
+
+  // Builds the equivalent JSONValue tree.
+  std::unique_ptr<JSONValue> ToJSONValue() const;
+
+ private:
+  friend class JSONDocumentBuilder;
+  friend class WTF::PODArena;
+
+  // A string token in the source, without its quotes.
+  struct SourceString {
+    const void* characters;
+    wtf_size_t length;
+    bool is_8bit;
+    bool has_escapes;
+
+    String Decode() const;
+    bool Equals(const StringView& other) const;
+  };
+
+  JSONNode() = default;
+
+  bool IsContainer() const {
+    return type_ == JSONValue::kTypeArray || type_ == JSONValue::kTypeObject;
+  }
+
+  JSONValue::ValueType type_ = JSONValue::kTypeNull;
+  wtf_size_t size_ = 0;
+  union {
+    bool bool_value_;
+    int integer_value_;
+    double double_value_;
+    SourceString string_value_;
+    JSONNode* first_child_;
+  };
+  // The last child while the node is built, so that children can be
+  // appended in constant time.
+  JSONNode* last_child_ = nullptr;
+  JSONNode* next_sibling_ = nullptr;
+  SourceString key_ = {nullptr, 0, true, false};
+};
+
+// A JSON value parsed by ParseJSONDocument(). The nodes of the document are
+// allocated from an arena, which is freed at once with the document.
+class PLATFORM_EXPORT JSONDocument {
+  USING_FAST_MALLOC(JSONDocument);
+
+ public:
+  JSONDocument(const JSONDocument&) = delete;
+  JSONDocument& operator=(const JSONDocument&) = delete;
+
+  const JSONNode* Root() const { return root_; }
+
+ private:
+  friend class JSONDocumentBuilder;
+
+  explicit JSONDocument(const String& source);
+
+  // Keeps the characters nodes point to alive.
+  String source_;
+  scoped_refptr<WTF::PODArena> arena_;
+  JSONNode* root_ = nullptr;
+};
+
+}  // namespace blink
+
+#endif  // THIRD_PARTY_BLINK_RENDERER_PLATFORM_JSON_JSON_DOCUMENT_H_
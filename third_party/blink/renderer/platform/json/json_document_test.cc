@@ -0,0 +1,143 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/platform/json/json_document.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/blink/renderer/platform/json/json_parser.h"
+
+namespace blink {
+
+TEST(JSONDocumentTest, Values) {
+  std::unique_ptr<JSONDocument> document = ParseJSONDocument(
+      "{\"null\": null, \"bool\": true, \"int\": 42, \"double\": 0.5,"
+      " \"string\": \"a\\u0062c\", \"array\": [1, \"two\", []], \"object\": {}}");
+  ASSERT_TRUE(document);
+  const JSONNode* root = document->Root();
+  ASSERT_TRUE(root);
+  EXPECT_EQ(JSONValue::kTypeObject, root->GetType());
+  EXPECT_EQ(7u, root->size());
+  EXPECT_TRUE(root->Key().IsNull());
+
+  bool bool_value = false;
+  int int_value = 0;
+  double double_value = 0;
+  String string_value;
+
+  EXPECT_TRUE(root->Get("null")->IsNull());
+  EXPECT_TRUE(root->Get("bool")->AsBoolean(&bool_value));
+  EXPECT_TRUE(bool_value);
+  EXPECT_TRUE(root->Get("int")->AsInteger(&int_value));
+  EXPECT_EQ(42, int_value);
+  EXPECT_TRUE(root->Get("int")->AsDouble(&double_value));
+  EXPECT_EQ(42, double_value);
+  EXPECT_FALSE(root->Get("double")->AsInteger(&int_value));
+  EXPECT_TRUE(root->Get("double")->AsDouble(&double_value));
+  EXPECT_EQ(0.5, double_value);
+  EXPECT_TRUE(root->Get("string")->AsString(&string_value));
+  EXPECT_EQ("abc", string_value);
+  EXPECT_FALSE(root->Get("missing"));
+  EXPECT_FALSE(root->at(0));
+
+  const JSONNode* array = root->Get("array");
+  EXPECT_EQ(JSONValue::kTypeArray, array->GetType());
+  EXPECT_EQ(3u, array->size());
+  EXPECT_TRUE(array->at(0)->AsInteger(&int_value));
+  EXPECT_EQ(1, int_value);
+  EXPECT_TRUE(array->at(1)->AsString(&string_value));
+  EXPECT_EQ("two", string_value);
+  EXPECT_EQ(0u, array->at(2)->size());
+  EXPECT_FALSE(array->at(2)->FirstChild());
+  EXPECT_FALSE(array->at(3));
+  EXPECT_FALSE(array->Get("array"));
+
+  const JSONNode* object = root->Get("object");
+  EXPECT_EQ(JSONValue::kTypeObject, object->GetType());
+  EXPECT_EQ(0u, object->size());
+
+  const char* const kKeys[] = {"null",   "bool",  "int",   "double",
+                               "string", "array", "object"};
+  const JSONNode* child = root->FirstChild();
+  for (const char* key : kKeys) {
+    ASSERT_TRUE(child);
+    EXPECT_EQ(key, child->Key());
+    child = child->NextSibling();
+  }
+  EXPECT_FALSE(child);
+}
+
+TEST(JSONDocumentTest, Keys) {
+  std::unique_ptr<JSONDocument> document =
+      ParseJSONDocument("{\"a\": 1, \"\\u0061\": 2, \"b\\n\": 3, \"\": 4}");
+  ASSERT_TRUE(document);
+  const JSONNode* root = document->Root();
+  EXPECT_EQ(4u, root->size());
+
+  // The last of duplicate keys wins, as in JSONObject.
+  int int_value = 0;
+  EXPECT_TRUE(root->Get("a")->AsInteger(&int_value));
+  EXPECT_EQ(2, int_value);
+  EXPECT_TRUE(root->Get("b\n")->AsInteger(&int_value));
+  EXPECT_EQ(3, int_value);
+  EXPECT_TRUE(root->Get("")->AsInteger(&int_value));
+  EXPECT_EQ(4, int_value);
+  EXPECT_FALSE(root->Get("b"));
+
+  // 16-bit sources and names.
+  String json = "{\"\\u00e9t\\u00e9\": 1, \"\xe9t\xe9\": 2}";
+  json.Ensure16Bit();
+  document = ParseJSONDocument(json);
+  ASSERT_TRUE(document);
+  root = document->Root();
+  EXPECT_TRUE(root->Get("\xe9t\xe9")->AsInteger(&int_value));
+  EXPECT_EQ(2, int_value);
+  String name = "\xe9t\xe9";
+  name.Ensure16Bit();
+  EXPECT_TRUE(root->Get(name)->AsInteger(&int_value));
+  EXPECT_EQ(2, int_value);
+  EXPECT_TRUE(root->FirstChild()->NextSibling()->Key().Is8Bit());
+}
+
+TEST(JSONDocumentTest, ToJSONValue) {
+  std::unique_ptr<JSONDocument> document =
+      ParseJSONDocument("{\"b\": [1, \"\\u0078\"], \"a\": 2.5, \"b\": 3}");
+  ASSERT_TRUE(document);
+  std::unique_ptr<JSONValue> value = document->Root()->ToJSONValue();
+  JSONObject* object = JSONObject::Cast(value.get());
+  ASSERT_TRUE(object);
+  EXPECT_EQ(2u, object->size());
+  EXPECT_EQ("b", object->at(0).first);
+  EXPECT_EQ("a", object->at(1).first);
+  int int_value = 0;
+  EXPECT_TRUE(object->GetInteger("b", &int_value));
+  EXPECT_EQ(3, int_value);
+  double double_value = 0;
+  EXPECT_TRUE(object->GetDouble("a", &double_value));
+  EXPECT_EQ(2.5, double_value);
+
+  value = document->Root()->FirstChild()->ToJSONValue();
+  JSONArray* array = JSONArray::Cast(value.get());
+  ASSERT_TRUE(array);
+  EXPECT_EQ(2u, array->size());
+  String string_value;
+  EXPECT_TRUE(array->at(1)->AsString(&string_value));
+  EXPECT_EQ("x", string_value);
+}
+
+TEST(JSONDocumentTest, Errors) {
+  const char* const kInvalidJson[] = {"", "[1,]", "{\"a\" 1}", "\"\\x41\"",
+                                      "[[1]]"};
+  for (const char* json : kInvalidJson) {
+    JSONParseError error;
+    bool has_comments = true;
+    EXPECT_FALSE(ParseJSONDocument(json, 2, &error, &has_comments));
+    JSONParseError expected_error;
+    EXPECT_FALSE(ParseJSON(json, 2, &expected_error));
+    EXPECT_EQ(expected_error.type, error.type);
+    EXPECT_EQ(expected_error.message, error.message);
+    EXPECT_FALSE(has_comments);
+  }
+}
+
+}  // namespace blink
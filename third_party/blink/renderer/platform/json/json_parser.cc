@@ -4,14 +4,97 @@
 
 #include "third_party/blink/renderer/platform/json/json_parser.h"
 
+#include <unicode/utf16.h>
+
+#include "base/bits.h"
+#include "base/memory/ptr_util.h"
 #include "base/notreached.h"
 #include "base/numerics/safe_conversions.h"
+#include "build/build_config.h"
+#include "third_party/blink/renderer/platform/json/json_document.h"
 #include "third_party/blink/renderer/platform/json/json_values.h"
-#include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+#include "third_party/blink/renderer/platform/wtf/text/ascii_ctype.h"
 #include "third_party/blink/renderer/platform/wtf/text/string_to_number.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 namespace blink {
 
+// Allocates the nodes of a JSONDocument while it is parsed.
+class JSONDocumentBuilder {
+  STACK_ALLOCATED();
+
+ public:
+  explicit JSONDocumentBuilder(const String& source)
+      : document_(base::WrapUnique(new JSONDocument(source))) {}
+
+  JSONNode* CreateNode(JSONValue::ValueType type) {
+    JSONNode* node = document_->arena_->AllocateObject<JSONNode>();
+    node->type_ = type;
+    if (node->IsContainer())
+      node->first_child_ = nullptr;
+    return node;
+  }
+
+  JSONNode* CreateBoolean(bool value) {
+    JSONNode* node = CreateNode(JSONValue::kTypeBoolean);
+    node->bool_value_ = value;
+    return node;
+  }
+
+  JSONNode* CreateNumber(double value) {
+    if (base::IsValueInRangeForNumericType<int>(value) &&
+        static_cast<int>(value) == value) {
+      JSONNode* node = CreateNode(JSONValue::kTypeInteger);
+      node->integer_value_ = static_cast<int>(value);
+      return node;
+    }
+    JSONNode* node = CreateNode(JSONValue::kTypeDouble);
+    node->double_value_ = value;
+    return node;
+  }
+
+  template <typename CharType>
+  JSONNode* CreateString(const CharType* characters,
+                         wtf_size_t length,
+                         bool has_escapes) {
+    JSONNode* node = CreateNode(JSONValue::kTypeString);
+    node->string_value_ = {characters, length, sizeof(CharType) == 1,
+                           has_escapes};
+    return node;
+  }
+
+  template <typename CharType>
+  void SetKey(JSONNode* node,
+              const CharType* characters,
+              wtf_size_t length,
+              bool has_escapes) {
+    node->key_ = {characters, length, sizeof(CharType) == 1, has_escapes};
+  }
+
+  void AppendChild(JSONNode* parent, JSONNode* child) {
+    DCHECK(parent->IsContainer());
+    if (parent->last_child_)
+      parent->last_child_->next_sibling_ = child;
+    else
+      parent->first_child_ = child;
+    parent->last_child_ = child;
+    ++parent->size_;
+  }
+
+  std::unique_ptr<JSONDocument> Finish(JSONNode* root) {
+    document_->root_ = root;
+    return std::move(document_);
+  }
+
+ private:
+  std::unique_ptr<JSONDocument> document_;
+};
+
 namespace {
 
 const int kMaxStackLimit = 1000;
@@ -76,6 +159,221 @@ enum Token {
   kObjectPairSeparator,
 };
 
+// What ParseStringToken() found out about a well-formed string token.
+template <typename CharType>
+struct StringTokenInfo {
+  bool has_escapes = false;
+  // An error in the contents of the string. It is only reported once the
+  // string is used as a value or a key, so that a nesting error found first
+  // takes precedence, as it did when strings were decoded in a second pass.
+  Error decode_error = Error::kNoError;
+  const CharType* decode_error_pos = nullptr;
+};
+
+// The scans of strings and whitespace below look at 16 bytes at a time. A
+// scan returns a mask with kMaskBitsPerChar bits set for each matching
+// character, in order, so that the first match is found by counting the
+// trailing zero bits.
+#if defined(ARCH_CPU_X86_FAMILY)
+
+#define JSON_PARSER_VECTOR_SCAN
+
+using VectorMask = uint32_t;
+constexpr VectorMask kFullMask = 0xFFFF;
+template <typename CharType>
+constexpr int kMaskBitsPerChar = sizeof(CharType);
+
+inline __m128i LoadVector(const void* pos) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+}
+
+inline VectorMask ToMask(__m128i matches) {
+  return static_cast<VectorMask>(_mm_movemask_epi8(matches));
+}
+
+inline VectorMask MatchStringSpecialCharacters(const LChar* pos) {
+  const __m128i v = LoadVector(pos);
+  const __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+  const __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+  const __m128i control =
+      _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v);
+  return ToMask(_mm_or_si128(_mm_or_si128(quote, backslash), control));
+}
+
+inline VectorMask MatchStringSpecialCharacters(const UChar* pos) {
+  const __m128i v = LoadVector(pos);
+  const __m128i quote = _mm_cmpeq_epi16(v, _mm_set1_epi16('"'));
+  const __m128i backslash = _mm_cmpeq_epi16(v, _mm_set1_epi16('\\'));
+  const __m128i control = _mm_cmpeq_epi16(
+      _mm_subs_epu16(v, _mm_set1_epi16(0x1F)), _mm_setzero_si128());
+  const __m128i surrogate = _mm_cmpeq_epi16(
+      _mm_and_si128(v, _mm_set1_epi16(static_cast<int16_t>(0xF800))),
+      _mm_set1_epi16(static_cast<int16_t>(0xD800)));
+  return ToMask(_mm_or_si128(_mm_or_si128(quote, backslash),
+                             _mm_or_si128(control, surrogate)));
+}
+
+inline VectorMask MatchWhitespace(const LChar* pos, VectorMask* newlines) {
+  const __m128i v = LoadVector(pos);
+  const __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  const __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  const __m128i tab = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+  const __m128i carriage_return = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+  *newlines = ToMask(newline);
+  return ToMask(_mm_or_si128(_mm_or_si128(newline, space),
+                             _mm_or_si128(tab, carriage_return)));
+}
+
+inline VectorMask MatchWhitespace(const UChar* pos, VectorMask* newlines) {
+  const __m128i v = LoadVector(pos);
+  const __m128i newline = _mm_cmpeq_epi16(v, _mm_set1_epi16('\n'));
+  const __m128i space = _mm_cmpeq_epi16(v, _mm_set1_epi16(' '));
+  const __m128i tab = _mm_cmpeq_epi16(v, _mm_set1_epi16('\t'));
+  const __m128i carriage_return = _mm_cmpeq_epi16(v, _mm_set1_epi16('\r'));
+  *newlines = ToMask(newline);
+  return ToMask(_mm_or_si128(_mm_or_si128(newline, space),
+                             _mm_or_si128(tab, carriage_return)));
+}
+
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+
+#define JSON_PARSER_VECTOR_SCAN
+
+using VectorMask = uint64_t;
+constexpr VectorMask kFullMask = ~VectorMask{0};
+template <typename CharType>
+constexpr int kMaskBitsPerChar = sizeof(CharType) * 4;
+
+// Narrows each 8-bit lane to 4 bits, there is no movemask on NEON.
+inline VectorMask ToMask(uint8x16_t matches) {
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+
+inline VectorMask ToMask(uint16x8_t matches) {
+  return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(matches)), 0);
+}
+
+inline uint16x8_t LoadVector(const UChar* pos) {
+  return vld1q_u16(reinterpret_cast<const uint16_t*>(pos));
+}
+
+inline VectorMask MatchStringSpecialCharacters(const LChar* pos) {
+  const uint8x16_t v = vld1q_u8(pos);
+  const uint8x16_t quote = vceqq_u8(v, vdupq_n_u8('"'));
+  const uint8x16_t backslash = vceqq_u8(v, vdupq_n_u8('\\'));
+  const uint8x16_t control = vcltq_u8(v, vdupq_n_u8(0x20));
+  return ToMask(vorrq_u8(vorrq_u8(quote, backslash), control));
+}
+
+inline VectorMask MatchStringSpecialCharacters(const UChar* pos) {
+  const uint16x8_t v = LoadVector(pos);
+  const uint16x8_t quote = vceqq_u16(v, vdupq_n_u16('"'));
+  const uint16x8_t backslash = vceqq_u16(v, vdupq_n_u16('\\'));
+  const uint16x8_t control = vcltq_u16(v, vdupq_n_u16(0x20));
+  const uint16x8_t surrogate =
+      vceqq_u16(vandq_u16(v, vdupq_n_u16(0xF800)), vdupq_n_u16(0xD800));
+  return ToMask(
+      vorrq_u16(vorrq_u16(quote, backslash), vorrq_u16(control, surrogate)));
+}
+
+inline VectorMask MatchWhitespace(const LChar* pos, VectorMask* newlines) {
+  const uint8x16_t v = vld1q_u8(pos);
+  const uint8x16_t newline = vceqq_u8(v, vdupq_n_u8('\n'));
+  const uint8x16_t space = vceqq_u8(v, vdupq_n_u8(' '));
+  const uint8x16_t tab = vceqq_u8(v, vdupq_n_u8('\t'));
+  const uint8x16_t carriage_return = vceqq_u8(v, vdupq_n_u8('\r'));
+  *newlines = ToMask(newline);
+  return ToMask(
+      vorrq_u8(vorrq_u8(newline, space), vorrq_u8(tab, carriage_return)));
+}
+
+inline VectorMask MatchWhitespace(const UChar* pos, VectorMask* newlines) {
+  const uint16x8_t v = LoadVector(pos);
+  const uint16x8_t newline = vceqq_u16(v, vdupq_n_u16('\n'));
+  const uint16x8_t space = vceqq_u16(v, vdupq_n_u16(' '));
+  const uint16x8_t tab = vceqq_u16(v, vdupq_n_u16('\t'));
+  const uint16x8_t carriage_return = vceqq_u16(v, vdupq_n_u16('\r'));
+  *newlines = ToMask(newline);
+  return ToMask(
+      vorrq_u16(vorrq_u16(newline, space), vorrq_u16(tab, carriage_return)));
+}
+
+#endif
+
+#if defined(JSON_PARSER_VECTOR_SCAN)
+template <typename CharType>
+constexpr ptrdiff_t kVectorChars = 16 / sizeof(CharType);
+#endif
+
+template <typename CharType>
+inline bool IsStringSpecialCharacter(CharType c) {
+  return c == '"' || c == '\\' || c < 0x20 ||
+         (sizeof(CharType) == 2 && U16_IS_SURROGATE(c));
+}
+
+// Returns the first character from |pos| which needs a closer look inside a
+// string: a quote, a backslash, a control character, or a surrogate, whose
+// pairing is checked. Returns |end| if there is none.
+template <typename CharType>
+const CharType* FindStringSpecialCharacter(const CharType* pos,
+                                           const CharType* end) {
+#if defined(JSON_PARSER_VECTOR_SCAN)
+  for (; end - pos >= kVectorChars<CharType>; pos += kVectorChars<CharType>) {
+    if (VectorMask matches = MatchStringSpecialCharacters(pos)) {
+      return pos + base::bits::CountTrailingZeroBits(matches) /
+                       kMaskBitsPerChar<CharType>;
+    }
+  }
+#endif
+  while (pos < end && !IsStringSpecialCharacter(*pos))
+    ++pos;
+  return pos;
+}
+
+template <typename CharType>
+void SkipWhitespace(Cursor<CharType>* cursor, const CharType* end) {
+#if defined(JSON_PARSER_VECTOR_SCAN)
+  constexpr int kBitsPerChar = kMaskBitsPerChar<CharType>;
+  while (end - cursor->pos >= kVectorChars<CharType>) {
+    VectorMask newlines;
+    const VectorMask whitespace = MatchWhitespace(cursor->pos, &newlines);
+    const ptrdiff_t run =
+        whitespace == kFullMask
+            ? kVectorChars<CharType>
+            : base::bits::CountTrailingZeroBits(~whitespace) / kBitsPerChar;
+    if (run < kVectorChars<CharType>)
+      newlines &= (VectorMask{1} << (run * kBitsPerChar)) - 1;
+    if (newlines) {
+      const int last_newline =
+          (sizeof(VectorMask) * 8 - 1 -
+           base::bits::CountLeadingZeroBits(newlines)) /
+          kBitsPerChar;
+      cursor->line_start = cursor->pos + last_newline + 1;
+      int newline_bits = 0;
+      for (; newlines; newlines &= newlines - 1)
+        ++newline_bits;
+      cursor->line += newline_bits / kBitsPerChar;
+    }
+    cursor->pos += run;
+    if (run < kVectorChars<CharType>)
+      return;
+  }
+#endif
+  while (cursor->pos < end) {
+    CharType c = *(cursor->pos);
+    if (c == '\n') {
+      cursor->line++;
+      ++(cursor->pos);
+      cursor->line_start = cursor->pos;
+    } else if (c == ' ' || c == '\r' || c == '\t') {
+      ++(cursor->pos);
+    } else {
+      break;
+    }
+  }
+}
+
 template <typename CharType>
 Error ParseConstToken(Cursor<CharType>* cursor,
                       const CharType* end,
@@ -175,31 +473,63 @@ Error ReadHexDigits(Cursor<CharType>* cursor, const CharType* end, int digits) {
   return Error::kNoError;
 }
 
+// Scans a string token, and checks that it decodes to valid UTF-16, without
+// decoding it: the string is only decoded if its value is asked for.
 template <typename CharType>
-Error ParseStringToken(Cursor<CharType>* cursor, const CharType* end) {
+Error ParseStringToken(Cursor<CharType>* cursor,
+                       const CharType* end,
+                       StringTokenInfo<CharType>* info) {
   if (cursor->pos == end)
     return Error::kSyntaxError;
   if (*(cursor->pos) != '"')
     return Error::kSyntaxError;
+  const CharType* string_start = cursor->pos;
   ++(cursor->pos);
-  while (cursor->pos < end) {
-    CharType c = *(cursor->pos)++;
+
+  // Whether the last decoded code unit is a lead surrogate, which the next
+  // one must pair with.
+  bool pending_lead = false;
+  bool unpaired_surrogate = false;
+  while (true) {
+    const CharType* run_end = FindStringSpecialCharacter(cursor->pos, end);
+    if (run_end != cursor->pos) {
+      unpaired_surrogate |= pending_lead;
+      pending_lead = false;
+      cursor->pos = run_end;
+    }
+    if (cursor->pos == end)
+      return Error::kSyntaxError;
+
+    UChar c = *(cursor->pos)++;
+    if ('"' == c)
+      break;
+    if (c < 0x20)
+      return Error::kSyntaxError;
     if ('\\' == c) {
+      info->has_escapes = true;
       if (cursor->pos == end)
         return Error::kInvalidEscape;
       c = *(cursor->pos)++;
       // Make sure the escaped char is valid.
       switch (c) {
         case 'x': {
+          const CharType* digits = cursor->pos;
           Error error = ReadHexDigits(cursor, end, 2);
           if (error != Error::kNoError)
             return error;
+          // \x is not supported.
+          if (info->decode_error == Error::kNoError) {
+            info->decode_error = Error::kInvalidEscape;
+            info->decode_error_pos = digits;
+          }
           break;
         }
         case 'u': {
           Error error = ReadHexDigits(cursor, end, 4);
           if (error != Error::kNoError)
             return error;
+          c = (ToASCIIHexValue(*(cursor->pos - 4), *(cursor->pos - 3)) << 8) |
+              ToASCIIHexValue(*(cursor->pos - 2), *(cursor->pos - 1));
           break;
         }
         case '\\':
@@ -215,13 +545,24 @@ Error ParseStringToken(Cursor<CharType>* cursor, const CharType* end) {
         default:
           return Error::kInvalidEscape;
       }
-    } else if (c < 0x20) {
-      return Error::kSyntaxError;
-    } else if ('"' == c) {
-      return Error::kNoError;
+    }
+
+    if (U16_IS_TRAIL(c)) {
+      unpaired_surrogate |= !pending_lead;
+      pending_lead = false;
+    } else {
+      unpaired_surrogate |= pending_lead;
+      pending_lead = U16_IS_LEAD(c);
     }
   }
-  return Error::kSyntaxError;
+
+  // The string must be valid UTF-16.
+  if ((unpaired_surrogate || pending_lead) &&
+      info->decode_error == Error::kNoError) {
+    info->decode_error = Error::kUnsupportedEncoding;
+    info->decode_error_pos = string_start;
+  }
+  return Error::kNoError;
 }
 
 template <typename CharType>
@@ -273,24 +614,15 @@ template <typename CharType>
 Error SkipWhitespaceAndComments(Cursor<CharType>* cursor,
                                 const CharType* end,
                                 bool* has_comments) {
-  while (cursor->pos < end) {
-    CharType c = *(cursor->pos);
-    if (c == '\n') {
-      cursor->line++;
-      ++(cursor->pos);
-      cursor->line_start = cursor->pos;
-    } else if (c == ' ' || c == '\r' || c == '\t') {
-      ++(cursor->pos);
-    } else if (c == '/') {
-      *has_comments = true;
-      Error error = SkipComment(cursor, end);
-      if (error != Error::kNoError)
-        return error;
-    } else {
-      break;
-    }
+  while (true) {
+    SkipWhitespace(cursor, end);
+    if (cursor->pos == end || *(cursor->pos) != '/')
+      return Error::kNoError;
+    *has_comments = true;
+    Error error = SkipComment(cursor, end);
+    if (error != Error::kNoError)
+      return error;
   }
-  return Error::kNoError;
 }
 
 template <typename CharType>
@@ -298,6 +630,7 @@ Error ParseToken(Cursor<CharType>* cursor,
                  const CharType* end,
                  Token* token,
                  Cursor<CharType>* token_start,
+                 StringTokenInfo<CharType>* string_info,
                  bool* has_comments) {
   Error error = SkipWhitespaceAndComments(cursor, end, has_comments);
   if (error != Error::kNoError)
@@ -356,127 +689,42 @@ Error ParseToken(Cursor<CharType>* cursor,
       return ParseNumberToken(cursor, end);
     case '"':
       *token = kStringLiteral;
-      return ParseStringToken(cursor, end);
+      *string_info = StringTokenInfo<CharType>();
+      return ParseStringToken(cursor, end, string_info);
   }
 
   return Error::kSyntaxError;
 }
 
-template <typename CharType>
-inline int HexToInt(CharType c) {
-  if ('0' <= c && c <= '9')
-    return c - '0';
-  if ('A' <= c && c <= 'F')
-    return c - 'A' + 10;
-  if ('a' <= c && c <= 'f')
-    return c - 'a' + 10;
-  NOTREACHED();
-  return 0;
-}
-
-template <typename CharType>
-Error DecodeString(Cursor<CharType>* cursor,
-                   const CharType* end,
-                   String* output) {
-  if (cursor->pos + 1 > end - 1)
-    return Error::kSyntaxError;
-  if (cursor->pos + 1 == end - 1) {
-    *output = "";
-    return Error::kNoError;
-  }
-
-  const CharType* string_start = cursor->pos;
-  StringBuilder buffer;
-  buffer.ReserveCapacity(static_cast<wtf_size_t>(end - cursor->pos - 2));
-
-  cursor->pos++;
-  while (cursor->pos < end - 1) {
-    UChar c = *(cursor->pos)++;
-    if (c == '\n') {
-      cursor->line++;
-      cursor->line_start = cursor->pos;
-    }
-    if ('\\' != c) {
-      buffer.Append(c);
-      continue;
-    }
-    if (cursor->pos == end - 1)
-      return Error::kInvalidEscape;
-    c = *(cursor->pos)++;
-
-    if (c == 'x') {
-      // \x is not supported.
-      return Error::kInvalidEscape;
-    }
-
-    switch (c) {
-      case '"':
-      case '/':
-      case '\\':
-        break;
-      case 'b':
-        c = '\b';
-        break;
-      case 'f':
-        c = '\f';
-        break;
-      case 'n':
-        c = '\n';
-        break;
-      case 'r':
-        c = '\r';
-        break;
-      case 't':
-        c = '\t';
-        break;
-      case 'v':
-        c = '\v';
-        break;
-      case 'u':
-        c = (HexToInt(*(cursor->pos)) << 12) +
-            (HexToInt(*(cursor->pos + 1)) << 8) +
-            (HexToInt(*(cursor->pos + 2)) << 4) + HexToInt(*(cursor->pos + 3));
-        cursor->pos += 4;
-        break;
-      default:
-        return Error::kInvalidEscape;
-    }
-    buffer.Append(c);
-  }
-  *output = buffer.ToString();
-
-  // Validate constructed utf16 string.
-  if (output->Utf8(kStrictUTF8Conversion).empty()) {
-    cursor->pos = string_start;
-    return Error::kUnsupportedEncoding;
-  }
-  return Error::kNoError;
-}
-
 template <typename CharType>
 Error BuildValue(Cursor<CharType>* cursor,
                  const CharType* end,
                  int max_depth,
-                 std::unique_ptr<JSONValue>* result,
-                 bool* has_comments) {
-  if (max_depth == 0)
-    return Error::kTooMuchNesting;
-
-  Cursor<CharType> token_start;
-  Token token;
-  Error error = ParseToken(cursor, end, &token, &token_start, has_comments);
-  if (error != Error::kNoError)
-    return error;
+                 JSONDocumentBuilder* builder,
+                 JSONNode** result,
+                 bool* has_comments);
 
+// Builds the value starting with |token|, which ParseToken() has just read.
+template <typename CharType>
+Error BuildValueFromToken(Cursor<CharType>* cursor,
+                          const CharType* end,
+                          Token token,
+                          Cursor<CharType> token_start,
+                          const StringTokenInfo<CharType>& string_info,
+                          int max_depth,
+                          JSONDocumentBuilder* builder,
+                          JSONNode** result,
+                          bool* has_comments) {
+  Error error;
   switch (token) {
     case kNullToken:
-      *result = JSONValue::Null();
+      *result = builder->CreateNode(JSONValue::kTypeNull);
       break;
     case kBoolTrue:
-      *result = std::make_unique<JSONBasicValue>(true);
+      *result = builder->CreateBoolean(true);
       break;
     case kBoolFalse:
-      *result = std::make_unique<JSONBasicValue>(false);
+      *result = builder->CreateBoolean(false);
       break;
     case kNumber: {
       bool ok;
@@ -486,45 +734,53 @@ Error BuildValue(Cursor<CharType>* cursor,
         *cursor = token_start;
         return Error::kSyntaxError;
       }
-      if (base::IsValueInRangeForNumericType<int>(value) &&
-          static_cast<int>(value) == value)
-        *result = std::make_unique<JSONBasicValue>(static_cast<int>(value));
-      else
-        *result = std::make_unique<JSONBasicValue>(value);
+      *result = builder->CreateNumber(value);
       break;
     }
     case kStringLiteral: {
-      String value;
-      error = DecodeString(&token_start, cursor->pos, &value);
-      if (error != Error::kNoError) {
+      if (string_info.decode_error != Error::kNoError) {
         *cursor = token_start;
-        return error;
+        cursor->pos = string_info.decode_error_pos;
+        return string_info.decode_error;
       }
-      *result = std::make_unique<JSONString>(value);
+      *result = builder->CreateString(
+          token_start.pos + 1,
+          static_cast<wtf_size_t>(cursor->pos - token_start.pos - 2),
+          string_info.has_escapes);
       break;
     }
     case kArrayBegin: {
-      auto array = std::make_unique<JSONArray>();
+      JSONNode* array = builder->CreateNode(JSONValue::kTypeArray);
+      StringTokenInfo<CharType> element_info;
       Cursor<CharType> before_token = *cursor;
-      error = ParseToken(cursor, end, &token, &token_start, has_comments);
+      error = ParseToken(cursor, end, &token, &token_start, &element_info,
+                         has_comments);
       if (error != Error::kNoError)
         return error;
       while (token != kArrayEnd) {
-        *cursor = before_token;
-        std::unique_ptr<JSONValue> array_node;
-        error =
-            BuildValue(cursor, end, max_depth - 1, &array_node, has_comments);
+        // The element is built from the token read above, rather than read
+        // again by BuildValue().
+        if (max_depth == 1) {
+          *cursor = before_token;
+          return Error::kTooMuchNesting;
+        }
+        JSONNode* array_node;
+        error = BuildValueFromToken(cursor, end, token, token_start,
+                                    element_info, max_depth - 1, builder,
+                                    &array_node, has_comments);
         if (error != Error::kNoError)
           return error;
-        array->PushValue(std::move(array_node));
+        builder->AppendChild(array, array_node);
 
         // After a list value, we expect a comma or the end of the list.
-        error = ParseToken(cursor, end, &token, &token_start, has_comments);
+        error = ParseToken(cursor, end, &token, &token_start, &element_info,
+                           has_comments);
         if (error != Error::kNoError)
           return error;
         if (token == kListSeparator) {
           before_token = *cursor;
-          error = ParseToken(cursor, end, &token, &token_start, has_comments);
+          error = ParseToken(cursor, end, &token, &token_start, &element_info,
+                             has_comments);
           if (error != Error::kNoError)
             return error;
           if (token == kArrayEnd) {
@@ -537,16 +793,14 @@ Error BuildValue(Cursor<CharType>* cursor,
           return Error::kUnexpectedToken;
         }
       }
-      if (token != kArrayEnd) {
-        *cursor = token_start;
-        return Error::kUnexpectedToken;
-      }
-      *result = std::move(array);
+      *result = array;
       break;
     }
     case kObjectBegin: {
-      auto object = std::make_unique<JSONObject>();
-      error = ParseToken(cursor, end, &token, &token_start, has_comments);
+      JSONNode* object = builder->CreateNode(JSONValue::kTypeObject);
+      StringTokenInfo<CharType> key_info;
+      error = ParseToken(cursor, end, &token, &token_start, &key_info,
+                         has_comments);
       if (error != Error::kNoError)
         return error;
       while (token != kObjectEnd) {
@@ -554,32 +808,44 @@ Error BuildValue(Cursor<CharType>* cursor,
           *cursor = token_start;
           return Error::kUnexpectedToken;
         }
-        String key;
-        error = DecodeString(&token_start, cursor->pos, &key);
-        if (error != Error::kNoError) {
+        if (key_info.decode_error != Error::kNoError) {
           *cursor = token_start;
-          return error;
+          cursor->pos = key_info.decode_error_pos;
+          return key_info.decode_error;
         }
-
-        error = ParseToken(cursor, end, &token, &token_start, has_comments);
+        const CharType* key = token_start.pos + 1;
+        const wtf_size_t key_length =
+            static_cast<wtf_size_t>(cursor->pos - key - 1);
+        const bool key_has_escapes = key_info.has_escapes;
+        // A bad comment before the ':' is reported at the closing quote of
+        // the key, or at the opening quote of an empty key.
+        if (key_length)
+          token_start.pos = cursor->pos - 1;
+
+        error = ParseToken(cursor, end, &token, &token_start, &key_info,
+                           has_comments);
         if (token != kObjectPairSeparator) {
           *cursor = token_start;
           return Error::kUnexpectedToken;
         }
 
-        std::unique_ptr<JSONValue> value;
-        error = BuildValue(cursor, end, max_depth - 1, &value, has_comments);
+        JSONNode* value;
+        error = BuildValue(cursor, end, max_depth - 1, builder, &value,
+                           has_comments);
         if (error != Error::kNoError)
           return error;
-        object->SetValue(key, std::move(value));
+        builder->SetKey(value, key, key_length, key_has_escapes);
+        builder->AppendChild(object, value);
 
         // After a key/value pair, we expect a comma or the end of the
         // object.
-        error = ParseToken(cursor, end, &token, &token_start, has_comments);
+        error = ParseToken(cursor, end, &token, &token_start, &key_info,
+                           has_comments);
         if (error != Error::kNoError)
           return error;
         if (token == kListSeparator) {
-          error = ParseToken(cursor, end, &token, &token_start, has_comments);
+          error = ParseToken(cursor, end, &token, &token_start, &key_info,
+                             has_comments);
           if (error != Error::kNoError)
             return error;
           if (token == kObjectEnd) {
@@ -592,11 +858,7 @@ Error BuildValue(Cursor<CharType>* cursor,
           return Error::kUnexpectedToken;
         }
       }
-      if (token != kObjectEnd) {
-        *cursor = token_start;
-        return Error::kUnexpectedToken;
-      }
-      *result = std::move(object);
+      *result = object;
       break;
     }
 
@@ -609,11 +871,34 @@ Error BuildValue(Cursor<CharType>* cursor,
   return SkipWhitespaceAndComments(cursor, end, has_comments);
 }
 
+// Inlined so that each level of nesting takes a single stack frame.
+template <typename CharType>
+ALWAYS_INLINE Error BuildValue(Cursor<CharType>* cursor,
+                               const CharType* end,
+                               int max_depth,
+                               JSONDocumentBuilder* builder,
+                               JSONNode** result,
+                               bool* has_comments) {
+  if (max_depth == 0)
+    return Error::kTooMuchNesting;
+
+  Cursor<CharType> token_start;
+  Token token;
+  StringTokenInfo<CharType> string_info;
+  Error error = ParseToken(cursor, end, &token, &token_start, &string_info,
+                           has_comments);
+  if (error != Error::kNoError)
+    return error;
+  return BuildValueFromToken(cursor, end, token, token_start, string_info,
+                             max_depth, builder, result, has_comments);
+}
+
 template <typename CharType>
 JSONParseError ParseJSONInternal(const CharType* start_ptr,
                                  unsigned length,
                                  int max_depth,
-                                 std::unique_ptr<JSONValue>* result,
+                                 JSONDocumentBuilder* builder,
+                                 JSONNode** result,
                                  bool* has_comments) {
   Cursor<CharType> cursor;
   cursor.pos = start_ptr;
@@ -621,7 +906,8 @@ JSONParseError ParseJSONInternal(const CharType* start_ptr,
   cursor.line_start = start_ptr;
   const CharType* end = start_ptr + length;
   JSONParseError error;
-  error.type = BuildValue(&cursor, end, max_depth, result, has_comments);
+  error.type =
+      BuildValue(&cursor, end, max_depth, builder, result, has_comments);
   error.line = cursor.line;
   error.column = static_cast<int>(cursor.pos - cursor.line_start);
   if (error.type != Error::kNoError) {
@@ -635,22 +921,23 @@ JSONParseError ParseJSONInternal(const CharType* start_ptr,
 
 }  // anonymous namespace
 
-std::unique_ptr<JSONValue> ParseJSON(const String& json,
-                                     JSONParseError* opt_error,
-                                     bool* opt_has_comments) {
-  return ParseJSON(json, kMaxStackLimit, opt_error, opt_has_comments);
+std::unique_ptr<JSONDocument> ParseJSONDocument(const String& json,
+                                                JSONParseError* opt_error,
+                                                bool* opt_has_comments) {
+  return ParseJSONDocument(json, kMaxStackLimit, opt_error, opt_has_comments);
 }
 
-std::unique_ptr<JSONValue> ParseJSON(const String& json,
-                                     int max_depth,
-                                     JSONParseError* opt_error,
-                                     bool* opt_has_comments) {
+std::unique_ptr<JSONDocument> ParseJSONDocument(const String& json,
+                                                int max_depth,
+                                                JSONParseError* opt_error,
+                                                bool* opt_has_comments) {
   if (max_depth < 0)
     max_depth = 0;
   if (max_depth > kMaxStackLimit)
     max_depth = kMaxStackLimit;
 
-  std::unique_ptr<JSONValue> result;
+  JSONDocumentBuilder builder(json);
+  JSONNode* root = nullptr;
   JSONParseError error;
   bool has_comments = false;
 
@@ -660,10 +947,10 @@ std::unique_ptr<JSONValue> ParseJSON(const String& json,
     error.column = 0;
   } else if (json.Is8Bit()) {
     error = ParseJSONInternal(json.Characters8(), json.length(), max_depth,
-                              &result, &has_comments);
+                              &builder, &root, &has_comments);
   } else {
     error = ParseJSONInternal(json.Characters16(), json.length(), max_depth,
-                              &result, &has_comments);
+                              &builder, &root, &has_comments);
   }
 
   if (opt_error) {
@@ -675,7 +962,26 @@ std::unique_ptr<JSONValue> ParseJSON(const String& json,
   }
   if (opt_has_comments)
     *opt_has_comments = has_comments;
-  return result;
+  if (!root)
+    return nullptr;
+  return builder.Finish(root);
+}
+
+std::unique_ptr<JSONValue> ParseJSON(const String& json,
+                                     JSONParseError* opt_error,
+                                     bool* opt_has_comments) {
+  return ParseJSON(json, kMaxStackLimit, opt_error, opt_has_comments);
+}
+
+std::unique_ptr<JSONValue> ParseJSON(const String& json,
+                                     int max_depth,
+                                     JSONParseError* opt_error,
+                                     bool* opt_has_comments) {
+  std::unique_ptr<JSONDocument> document =
+      ParseJSONDocument(json, max_depth, opt_error, opt_has_comments);
+  if (!document)
+    return nullptr;
+  return document->Root()->ToJSONValue();
 }
 
 }  // namespace blink
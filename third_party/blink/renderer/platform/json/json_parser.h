@@ -12,6 +12,7 @@
 
 namespace blink {
 
+class JSONDocument;
 class JSONValue;
 
 enum class JSONParseErrorType {
@@ -47,6 +48,20 @@ PLATFORM_EXPORT std::unique_ptr<JSONValue> ParseJSON(
     int max_depth,
     JSONParseError* opt_error = nullptr,
     bool* opt_has_comments = nullptr);
+
+// Same as ParseJSON(), but returns a document whose values are allocated
+// together, and whose strings are only decoded when asked for. Cheaper than
+// ParseJSON() when only part of the value is used.
+PLATFORM_EXPORT std::unique_ptr<JSONDocument> ParseJSONDocument(
+    const String& json,
+    JSONParseError* opt_error = nullptr,
+    bool* opt_has_comments = nullptr);
+
+PLATFORM_EXPORT std::unique_ptr<JSONDocument> ParseJSONDocument(
+    const String& json,
+    int max_depth,
+    JSONParseError* opt_error = nullptr,
+    bool* opt_has_comments = nullptr);
 }  // namespace blink
 
 #endif  // THIRD_PARTY_BLINK_RENDERER_PLATFORM_JSON_JSON_PARSER_H_
@@ -0,0 +1,152 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/blink/renderer/platform/json/json_document.h"
+#include "third_party/blink/renderer/platform/json/json_parser.h"
+#include "third_party/blink/renderer/platform/json/json_values.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+
+namespace blink {
+
+namespace {
+
+// Measures the parsing throughput of generated payloads shaped like the JSON
+// Blink parses: an import map, and DevTools protocol messages, alone and in
+// batches. ParseJSON() builds a JSONValue tree, ParseJSONDocument() only the
+// document, and the lookup reads a member of each object without decoding
+// the other strings.
+
+constexpr char kMetricPrefix[] = "JSONParser.";
+constexpr char kMetricParseJSON[] = "ParseJSON";
+constexpr char kMetricParseJSONDocument[] = "ParseJSONDocument";
+constexpr char kMetricLookup[] = "ParseJSONDocument_lookup";
+
+// Each measurement parses about this many bytes.
+constexpr size_t kBytesPerMeasurement = 64 * 1024 * 1024;
+
+String MakeImportMap(int modules) {
+  StringBuilder builder;
+  builder.Append("{\n  \"imports\": {\n");
+  for (int i = 0; i < modules; ++i) {
+    builder.Append(i ? ",\n    \"module-" : "    \"module-");
+    builder.AppendNumber(i);
+    builder.Append("\": \"https://cdn.example.com/packages/module-");
+    builder.AppendNumber(i);
+    builder.Append("/dist/index.min.js\"");
+  }
+  builder.Append("\n  }\n}\n");
+  return builder.ToString();
+}
+
+String MakeProtocolMessages(int messages) {
+  StringBuilder builder;
+  builder.Append('[');
+  for (int i = 0; i < messages; ++i) {
+    if (i)
+      builder.Append(',');
+    builder.Append("{\"id\":");
+    builder.AppendNumber(i);
+    builder.Append(
+        ",\"method\":\"Network.requestWillBeSent\",\"params\":{\"requestId\":"
+        "\"1000.");
+    builder.AppendNumber(i);
+    builder.Append("\",\"documentURL\":\"https://example.com/index.html\","
+                   "\"request\":{\"url\":\"https://example.com/api/items?page=");
+    builder.AppendNumber(i);
+    builder.Append(
+        "\",\"method\":\"GET\",\"headers\":{\"Accept\":\"application/json\","
+        "\"User-Agent\":\"Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+        "(KHTML, like Gecko)\"},\"initialPriority\":\"High\"},\"timestamp\":"
+        "40321.523687,\"wallTime\":1618924123.456,\"initiator\":{\"type\":"
+        "\"script\",\"stack\":{\"callFrames\":[{\"functionName\":\"load\","
+        "\"url\":\"https://example.com/app.js\",\"lineNumber\":");
+    builder.AppendNumber(i % 500);
+    builder.Append(
+        ",\"columnNumber\":17}]}},\"hasUserGesture\":false,\"note\":\"line "
+        "one\\nline \\\"two\\\" \\u00e9\"}}");
+  }
+  builder.Append(']');
+  return builder.ToString();
+}
+
+// Reads one member of each element of |node|, or of |node| itself.
+bool LookUpMember(const JSONNode* node) {
+  if (node->GetType() == JSONValue::kTypeObject)
+    return node->Get("imports") || node->Get("id");
+  bool found = true;
+  for (const JSONNode* child = node->FirstChild(); child;
+       child = child->NextSibling()) {
+    int id;
+    found &= child->Get("id")->AsInteger(&id);
+  }
+  return found;
+}
+
+void RunParseBenchmark(const std::string& story, const String& json) {
+  const size_t bytes = json.CharactersSizeInBytes();
+  const size_t rounds = std::max<size_t>(kBytesPerMeasurement / bytes, 1);
+
+  // Warm up the caches before timing.
+  ASSERT_TRUE(ParseJSON(json));
+
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story);
+  reporter.RegisterImportantMetric(kMetricParseJSON, "MB/s");
+  reporter.RegisterImportantMetric(kMetricParseJSONDocument, "MB/s");
+  reporter.RegisterImportantMetric(kMetricLookup, "MB/s");
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (size_t round = 0; round < rounds; ++round)
+    ASSERT_TRUE(ParseJSON(json));
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  reporter.AddResult(kMetricParseJSON,
+                     rounds * bytes / 1e6 / elapsed.InSecondsF());
+
+  start = base::TimeTicks::Now();
+  for (size_t round = 0; round < rounds; ++round)
+    ASSERT_TRUE(ParseJSONDocument(json));
+  elapsed = base::TimeTicks::Now() - start;
+  reporter.AddResult(kMetricParseJSONDocument,
+                     rounds * bytes / 1e6 / elapsed.InSecondsF());
+
+  start = base::TimeTicks::Now();
+  for (size_t round = 0; round < rounds; ++round) {
+    std::unique_ptr<JSONDocument> document = ParseJSONDocument(json);
+    ASSERT_TRUE(document);
+    ASSERT_TRUE(LookUpMember(document->Root()));
+  }
+  elapsed = base::TimeTicks::Now() - start;
+  reporter.AddResult(kMetricLookup,
+                     rounds * bytes / 1e6 / elapsed.InSecondsF());
+}
+
+}  // namespace
+
+TEST(JSONParserPerfTest, ImportMap) {
+  // About 8 KB.
+  RunParseBenchmark("import_map", MakeImportMap(100));
+}
+
+TEST(JSONParserPerfTest, ProtocolMessage) {
+  // About 600 bytes.
+  RunParseBenchmark("protocol_message", MakeProtocolMessages(1));
+}
+
+TEST(JSONParserPerfTest, ProtocolMessages) {
+  // About 60 KB, and 1.5 MB.
+  RunParseBenchmark("protocol_messages_100", MakeProtocolMessages(100));
+  RunParseBenchmark("protocol_messages_2500", MakeProtocolMessages(2500));
+
+  String json = MakeProtocolMessages(2500);
+  json.Ensure16Bit();
+  RunParseBenchmark("protocol_messages_2500_16bit", json);
+}
+
+}  // namespace blink
@@ -725,4 +725,105 @@ TEST(JSONParserTest, LimitedDepth) {
   EXPECT_EQ("Line: 1, column: 1001, Too much nesting.", error.message);
 }
 
+// Strings and whitespace are scanned several characters at a time. Check that
+// what is found is the same wherever it is in a block.
+TEST(JSONParserTest, CharacterPositions) {
+  JSONParseError error;
+  String str_val;
+
+  for (wtf_size_t length = 1; length < 40; ++length) {
+    for (wtf_size_t i = 0; i < length; ++i) {
+      Vector<UChar> characters(length + 2, 'a');
+      characters.front() = '"';
+      characters.back() = '"';
+
+      // An escape sequence.
+      StringBuilder escaped;
+      escaped.Append(characters.data(), i + 1);
+      escaped.Append("\\n");
+      escaped.Append(characters.data() + i + 2, length - i);
+      std::unique_ptr<JSONValue> root = ParseJSON(escaped.ToString(), &error);
+      ASSERT_TRUE(root.get());
+      EXPECT_TRUE(root->AsString(&str_val));
+      EXPECT_EQ(length, str_val.length());
+      EXPECT_EQ('\n', str_val[i]);
+
+      // A control character.
+      characters[i + 1] = '\t';
+      root = ParseJSON(String::Make8BitFrom16BitSource(characters), &error);
+      EXPECT_FALSE(root.get());
+      EXPECT_EQ("Line: 1, column: " + String::Number(i + 3) + ", Syntax error.",
+                error.message);
+      root = ParseJSON(String(characters), &error);
+      EXPECT_FALSE(root.get());
+      EXPECT_EQ("Line: 1, column: " + String::Number(i + 3) + ", Syntax error.",
+                error.message);
+
+      // A lone surrogate.
+      characters[i + 1] = 0xdc00;
+      root = ParseJSON(String(characters), &error);
+      EXPECT_FALSE(root.get());
+      EXPECT_EQ(JSONParseErrorType::kUnsupportedEncoding, error.type);
+      EXPECT_EQ(1, error.column);
+
+      // A surrogate pair.
+      if (i + 1 < length) {
+        characters[i + 1] = 0xd83d;
+        characters[i + 2] = 0xdca9;
+        root = ParseJSON(String(characters), &error);
+        ASSERT_TRUE(root.get());
+        EXPECT_TRUE(root->AsString(&str_val));
+        EXPECT_EQ(String(characters.data() + 1, length), str_val);
+      }
+    }
+  }
+
+  for (wtf_size_t newlines = 0; newlines < 20; ++newlines) {
+    for (wtf_size_t spaces = 0; spaces < 40; ++spaces) {
+      StringBuilder builder;
+      builder.Append('[');
+      for (wtf_size_t i = 0; i < newlines; ++i)
+        builder.Append(i % 2 ? "\n" : "\r\n");
+      for (wtf_size_t i = 0; i < spaces; ++i)
+        builder.Append(i % 3 ? ' ' : '\t');
+      builder.Append("x]");
+      String json = builder.ToString();
+      String expected = "Line: " + String::Number(newlines + 1) +
+                        ", column: " +
+                        String::Number(spaces + (newlines ? 1 : 2)) +
+                        ", Syntax error.";
+
+      std::unique_ptr<JSONValue> root = ParseJSON(json, &error);
+      EXPECT_FALSE(root.get());
+      EXPECT_EQ(expected, error.message);
+      json.Ensure16Bit();
+      root = ParseJSON(json, &error);
+      EXPECT_FALSE(root.get());
+      EXPECT_EQ(expected, error.message);
+    }
+  }
+}
+
+TEST(JSONParserTest, InvalidStringContents) {
+  JSONParseError error;
+
+  // \x is reported before an invalid surrogate, wherever it is.
+  std::unique_ptr<JSONValue> root = ParseJSON("\"\\ud800 \\x41\"", &error);
+  EXPECT_FALSE(root.get());
+  EXPECT_EQ("Line: 1, column: 11, Invalid escape sequence.", error.message);
+
+  // An invalid key is reported like an invalid value.
+  root = ParseJSON("{\n \"\\udc00\": 1}", &error);
+  EXPECT_FALSE(root.get());
+  EXPECT_EQ(
+      "Line: 2, column: 2, Unsupported encoding. JSON and all string literals "
+      "must contain valid Unicode characters.",
+      error.message);
+
+  // Too much nesting is found before the contents of the string.
+  root = ParseJSON("[\"\\x41\"]", 1, &error);
+  EXPECT_FALSE(root.get());
+  EXPECT_EQ("Line: 1, column: 2, Too much nesting.", error.message);
+}
+
 }  // namespace blink
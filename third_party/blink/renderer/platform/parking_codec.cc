@@ -0,0 +1,115 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/platform/parking_codec.h"
+
+#include "base/check_op.h"
+#include "base/notreached.h"
+#include "third_party/blink/renderer/platform/wtf/allocator/partitions.h"
+#include "third_party/snappy/src/snappy.h"
+#include "third_party/zlib/google/compression_utils.h"
+
+namespace blink {
+
+namespace parking_codec {
+
+namespace {
+
+base::span<const char> AsChars(base::span<const uint8_t> data) {
+  return base::make_span(reinterpret_cast<const char*>(data.data()),
+                         data.size());
+}
+
+}  // namespace
+
+const char* GetName(Codec codec) {
+  switch (codec) {
+    case Codec::kZlib:
+      return "Zlib";
+    case Codec::kSnappy:
+      return "Snappy";
+  }
+  NOTREACHED();
+  return "";
+}
+
+size_t GetMaxCompressedSize(Codec codec, size_t input_size) {
+  switch (codec) {
+    case Codec::kZlib:
+      return input_size;
+    case Codec::kSnappy:
+      return snappy::MaxCompressedLength(input_size);
+  }
+  NOTREACHED();
+  return 0;
+}
+
+bool Compress(Codec codec,
+              base::span<const uint8_t> input,
+              base::span<uint8_t> output,
+              size_t* compressed_size) {
+  switch (codec) {
+    case Codec::kZlib: {
+      // Use partition alloc for zlib's temporary data. This is crucial to avoid
+      // leaking memory on Android, see the details in crbug.com/931553.
+      auto fast_malloc = [](size_t size) {
+        return WTF::Partitions::FastMalloc(size, "ZlibTemporaryData");
+      };
+      return compression::GzipCompress(
+          AsChars(input), reinterpret_cast<char*>(output.data()),
+          output.size(), compressed_size, fast_malloc,
+          WTF::Partitions::FastFree);
+    }
+    case Codec::kSnappy:
+      // Snappy writes up to MaxCompressedLength() bytes, and doesn't check the
+      // output size.
+      if (output.size() < snappy::MaxCompressedLength(input.size()))
+        return false;
+      snappy::RawCompress(reinterpret_cast<const char*>(input.data()),
+                          input.size(), reinterpret_cast<char*>(output.data()),
+                          compressed_size);
+      return true;
+  }
+  NOTREACHED();
+  return false;
+}
+
+size_t GetUncompressedSize(Codec codec, base::span<const uint8_t> compressed) {
+  switch (codec) {
+    case Codec::kZlib:
+      return compression::GetUncompressedSize(AsChars(compressed));
+    case Codec::kSnappy: {
+      size_t size;
+      if (!snappy::GetUncompressedLength(
+              reinterpret_cast<const char*>(compressed.data()),
+              compressed.size(), &size)) {
+        return 0;
+      }
+      return size;
+    }
+  }
+  NOTREACHED();
+  return 0;
+}
+
+bool Decompress(Codec codec,
+                base::span<const uint8_t> compressed,
+                base::span<uint8_t> output) {
+  DCHECK_EQ(GetUncompressedSize(codec, compressed), output.size());
+  switch (codec) {
+    case Codec::kZlib:
+      return compression::GzipUncompress(AsChars(compressed),
+                                         AsChars(output));
+    case Codec::kSnappy:
+      return snappy::RawUncompress(
+          reinterpret_cast<const char*>(compressed.data()), compressed.size(),
+          reinterpret_cast<char*>(output.data()));
+  }
+  NOTREACHED();
+  return false;
+}
+
+}  // namespace parking_codec
+
+}  // namespace blink
@@ -0,0 +1,62 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef THIRD_PARTY_BLINK_RENDERER_PLATFORM_PARKING_CODEC_H_
+#define THIRD_PARTY_BLINK_RENDERER_PLATFORM_PARKING_CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/containers/span.h"
+#include "third_party/blink/renderer/platform/platform_export.h"
+
+namespace blink {
+
+// Compression used for data that is parked, either in memory by
+// ParkableString, or before being written to disk by ParkableImage.
+//
+// Zlib gives the best ratio. Snappy is an LZ77-class codec which compresses
+// at several hundred MB/s and decompresses faster still, at the cost of a
+// worse ratio. The data is not self-describing, callers must remember which
+// codec compressed it.
+//
+// All functions are thread-safe.
+namespace parking_codec {
+
+enum class Codec : uint8_t { kZlib = 0, kSnappy = 1 };
+
+// Name of |codec|, used as a histogram suffix.
+PLATFORM_EXPORT const char* GetName(Codec codec);
+
+// Size of the output buffer to pass to |Compress()|. With Snappy, compression
+// into a buffer of this size cannot run out of space. Zlib has no useful
+// bound, so this is the input size for it: data which doesn't shrink is not
+// worth parking compressed anyway.
+PLATFORM_EXPORT size_t GetMaxCompressedSize(Codec codec, size_t input_size);
+
+// Compresses |input| into |output|. Returns false if compression failed,
+// including when the output doesn't fit in |output|. Temporary data is
+// allocated with PartitionAlloc.
+PLATFORM_EXPORT bool Compress(Codec codec,
+                              base::span<const uint8_t> input,
+                              base::span<uint8_t> output,
+                              size_t* compressed_size);
+
+// Returns the size of the data once uncompressed, or 0 if |compressed| is
+// corrupted.
+PLATFORM_EXPORT size_t GetUncompressedSize(Codec codec,
+                                           base::span<const uint8_t> compressed);
+
+// Decompresses |compressed| into |output|, which must be exactly
+// |GetUncompressedSize()| bytes long. Returns false if the data is corrupted
+// or memory allocation failed.
+PLATFORM_EXPORT bool Decompress(Codec codec,
+                                base::span<const uint8_t> compressed,
+                                base::span<uint8_t> output);
+
+}  // namespace parking_codec
+
+}  // namespace blink
+
+#endif  // THIRD_PARTY_BLINK_RENDERER_PLATFORM_PARKING_CODEC_H_
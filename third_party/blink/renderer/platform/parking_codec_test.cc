@@ -0,0 +1,82 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "third_party/blink/renderer/platform/parking_codec.h"
+
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/blink/renderer/platform/wtf/vector.h"
+
+namespace blink {
+
+namespace parking_codec {
+
+namespace {
+
+constexpr size_t kSize = 20000;
+
+Vector<uint8_t> MakeCompressibleData() {
+  Vector<uint8_t> data(kSize);
+  for (size_t i = 0; i < kSize; ++i)
+    data[i] = static_cast<uint8_t>(i % 61);
+  return data;
+}
+
+Vector<uint8_t> MakeRandomData() {
+  Vector<uint8_t> data(kSize);
+  base::RandBytes(data.data(), data.size());
+  return data;
+}
+
+class ParkingCodecTest : public testing::TestWithParam<Codec> {};
+
+TEST_P(ParkingCodecTest, RoundTrip) {
+  const Vector<uint8_t> data = MakeCompressibleData();
+
+  Vector<uint8_t> compressed(GetMaxCompressedSize(GetParam(), data.size()));
+  size_t compressed_size;
+  ASSERT_TRUE(Compress(GetParam(), data, compressed, &compressed_size));
+  EXPECT_LT(compressed_size, data.size());
+  compressed.Shrink(compressed_size);
+
+  EXPECT_EQ(data.size(), GetUncompressedSize(GetParam(), compressed));
+  Vector<uint8_t> uncompressed(data.size());
+  ASSERT_TRUE(Decompress(GetParam(), compressed, uncompressed));
+  EXPECT_EQ(data, uncompressed);
+}
+
+TEST_P(ParkingCodecTest, RandomData) {
+  const Vector<uint8_t> data = MakeRandomData();
+
+  Vector<uint8_t> compressed(GetMaxCompressedSize(GetParam(), data.size()));
+  size_t compressed_size;
+  if (!Compress(GetParam(), data, compressed, &compressed_size)) {
+    // Zlib runs out of space, as random data doesn't shrink.
+    EXPECT_EQ(Codec::kZlib, GetParam());
+    return;
+  }
+  compressed.Shrink(compressed_size);
+
+  Vector<uint8_t> uncompressed(data.size());
+  ASSERT_TRUE(Decompress(GetParam(), compressed, uncompressed));
+  EXPECT_EQ(data, uncompressed);
+}
+
+TEST_P(ParkingCodecTest, OutputTooSmall) {
+  const Vector<uint8_t> data = MakeCompressibleData();
+
+  Vector<uint8_t> compressed(10);
+  size_t compressed_size;
+  EXPECT_FALSE(Compress(GetParam(), data, compressed, &compressed_size));
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         ParkingCodecTest,
+                         testing::Values(Codec::kZlib, Codec::kSnappy));
+
+}  // namespace
+
+}  // namespace parking_codec
+
+}  // namespace blink
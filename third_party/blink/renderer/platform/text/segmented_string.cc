@@ -19,8 +19,196 @@
 
 #include "third_party/blink/renderer/platform/text/segmented_string.h"
 
+#include "base/bits.h"
+#include "build/build_config.h"
+#include "third_party/blink/renderer/platform/wtf/text/ascii_ctype.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 namespace blink {
 
+namespace {
+
+// The vector routines below return a mask with kMaskBitsPerChar bits set for
+// each matching character, in string order from the lowest bit.
+#if defined(ARCH_CPU_X86_FAMILY)
+
+#define SEGMENTED_STRING_VECTOR_SCAN
+
+using VectorMask = uint32_t;
+template <typename CharType>
+constexpr int kMaskBitsPerChar = sizeof(CharType);
+
+inline VectorMask ToMask(__m128i matches) {
+  return static_cast<VectorMask>(_mm_movemask_epi8(matches));
+}
+
+inline VectorMask MatchRunEnd(const LChar* pos, UChar stop1, UChar stop2) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+  const __m128i null = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+  const __m128i carriage_return = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+  const __m128i stop = _mm_or_si128(
+      _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(stop1))),
+      _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(stop2))));
+  return ToMask(_mm_or_si128(_mm_or_si128(null, carriage_return), stop));
+}
+
+inline VectorMask MatchRunEnd(const UChar* pos, UChar stop1, UChar stop2) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+  const __m128i null = _mm_cmpeq_epi16(v, _mm_setzero_si128());
+  const __m128i carriage_return = _mm_cmpeq_epi16(v, _mm_set1_epi16('\r'));
+  const __m128i stop =
+      _mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16(stop1)),
+                   _mm_cmpeq_epi16(v, _mm_set1_epi16(stop2)));
+  return ToMask(_mm_or_si128(_mm_or_si128(null, carriage_return), stop));
+}
+
+inline VectorMask MatchNewlines(const LChar* pos) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+  return ToMask(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+}
+
+inline VectorMask MatchNewlines(const UChar* pos) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+  return ToMask(_mm_cmpeq_epi16(v, _mm_set1_epi16('\n')));
+}
+
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+
+#define SEGMENTED_STRING_VECTOR_SCAN
+
+using VectorMask = uint64_t;
+template <typename CharType>
+constexpr int kMaskBitsPerChar = sizeof(CharType) * 4;
+
+// Narrows each 8-bit lane to 4 bits, there is no movemask on NEON.
+inline VectorMask ToMask(uint8x16_t matches) {
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+
+inline VectorMask ToMask(uint16x8_t matches) {
+  return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(matches)), 0);
+}
+
+inline uint16x8_t LoadVector(const UChar* pos) {
+  return vld1q_u16(reinterpret_cast<const uint16_t*>(pos));
+}
+
+inline VectorMask MatchRunEnd(const LChar* pos, UChar stop1, UChar stop2) {
+  const uint8x16_t v = vld1q_u8(pos);
+  const uint8x16_t null = vceqq_u8(v, vdupq_n_u8(0));
+  const uint8x16_t carriage_return = vceqq_u8(v, vdupq_n_u8('\r'));
+  const uint8x16_t stop =
+      vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(stop1))),
+               vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(stop2))));
+  return ToMask(vorrq_u8(vorrq_u8(null, carriage_return), stop));
+}
+
+inline VectorMask MatchRunEnd(const UChar* pos, UChar stop1, UChar stop2) {
+  const uint16x8_t v = LoadVector(pos);
+  const uint16x8_t null = vceqq_u16(v, vdupq_n_u16(0));
+  const uint16x8_t carriage_return = vceqq_u16(v, vdupq_n_u16('\r'));
+  const uint16x8_t stop = vorrq_u16(vceqq_u16(v, vdupq_n_u16(stop1)),
+                                    vceqq_u16(v, vdupq_n_u16(stop2)));
+  return ToMask(vorrq_u16(vorrq_u16(null, carriage_return), stop));
+}
+
+inline VectorMask MatchNewlines(const LChar* pos) {
+  return ToMask(vceqq_u8(vld1q_u8(pos), vdupq_n_u8('\n')));
+}
+
+inline VectorMask MatchNewlines(const UChar* pos) {
+  return ToMask(vceqq_u16(LoadVector(pos), vdupq_n_u16('\n')));
+}
+
+#endif
+
+#if defined(SEGMENTED_STRING_VECTOR_SCAN)
+template <typename CharType>
+constexpr int kVectorChars = 16 / sizeof(CharType);
+#endif
+
+template <typename CharType>
+inline bool IsRunEnd(CharType c, UChar stop1, UChar stop2) {
+  return c == '\0' || c == '\r' || c == stop1 || c == stop2;
+}
+
+template <typename CharType>
+wtf_size_t RunLength(const CharType* start,
+                     const CharType* end,
+                     UChar stop1,
+                     UChar stop2) {
+  const CharType* pos = start;
+#if defined(SEGMENTED_STRING_VECTOR_SCAN)
+  for (; end - pos >= kVectorChars<CharType>; pos += kVectorChars<CharType>) {
+    if (VectorMask matches = MatchRunEnd(pos, stop1, stop2)) {
+      pos += base::bits::CountTrailingZeroBits(matches) /
+             kMaskBitsPerChar<CharType>;
+      return static_cast<wtf_size_t>(pos - start);
+    }
+  }
+#endif
+  while (pos < end && !IsRunEnd(*pos, stop1, stop2))
+    ++pos;
+  return static_cast<wtf_size_t>(pos - start);
+}
+
+// Returns the number of newlines in |characters|, and sets |last_newline| to
+// the index of the last one if there are any.
+template <typename CharType>
+int CountNewlines(const CharType* characters,
+                  wtf_size_t length,
+                  wtf_size_t* last_newline) {
+  int newlines = 0;
+  wtf_size_t i = 0;
+#if defined(SEGMENTED_STRING_VECTOR_SCAN)
+  constexpr int kBitsPerChar = kMaskBitsPerChar<CharType>;
+  for (; length - i >= kVectorChars<CharType>; i += kVectorChars<CharType>) {
+    VectorMask matches = MatchNewlines(characters + i);
+    if (!matches)
+      continue;
+    *last_newline = i + (sizeof(VectorMask) * 8 - 1 -
+                         base::bits::CountLeadingZeroBits(matches)) /
+                            kBitsPerChar;
+    int bits = 0;
+    for (; matches; matches &= matches - 1)
+      ++bits;
+    newlines += bits / kBitsPerChar;
+  }
+#endif
+  for (; i < length; ++i) {
+    if (characters[i] == '\n') {
+      ++newlines;
+      *last_newline = i;
+    }
+  }
+  return newlines;
+}
+
+}  // namespace
+
+StringView SegmentedSubstring::CurrentRun(UChar stop1, UChar stop2) const {
+  DCHECK(IsASCII(stop1));
+  DCHECK(IsASCII(stop2));
+  if (!data_last_char_)
+    return StringView();
+  if (is_8bit_) {
+    const LChar* start = data_.string8_ptr;
+    return StringView(
+        start, RunLength(start, reinterpret_cast<const LChar*>(data_end()),
+                         stop1, stop2));
+  }
+  const UChar* start = data_.string16_ptr;
+  return StringView(
+      start, RunLength(start, reinterpret_cast<const UChar*>(data_end()),
+                       stop1, stop2));
+}
+
 unsigned SegmentedString::length() const {
   unsigned length = current_string_.length();
   if (IsComposite()) {
@@ -142,6 +330,25 @@ UChar SegmentedString::AdvanceSubstring() {
   }
 }
 
+UChar SegmentedString::AdvancePastRun(const StringView& run) {
+  DCHECK(!run.IsEmpty());
+  DCHECK_LE(run.length(), static_cast<unsigned>(current_string_.length()));
+  if (LIKELY(current_string_.DoNotExcludeLineNumbers())) {
+    wtf_size_t last_newline = 0;
+    int newlines =
+        run.Is8Bit()
+            ? CountNewlines(run.Characters8(), run.length(), &last_newline)
+            : CountNewlines(run.Characters16(), run.length(), &last_newline);
+    if (newlines) {
+      current_line_ += newlines;
+      number_of_characters_consumed_prior_to_current_line_ =
+          NumberOfCharactersConsumed() + last_newline + 1;
+    }
+  }
+  current_string_.AdvanceWithinSubstring(run.length() - 1);
+  return Advance();
+}
+
 String SegmentedString::ToString() const {
   StringBuilder result;
   current_string_.AppendTo(result);
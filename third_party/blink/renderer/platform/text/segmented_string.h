@@ -24,6 +24,7 @@
 #include "third_party/blink/renderer/platform/wtf/allocator/allocator.h"
 #include "third_party/blink/renderer/platform/wtf/deque.h"
 #include "third_party/blink/renderer/platform/wtf/text/string_builder.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_view.h"
 #include "third_party/blink/renderer/platform/wtf/text/text_position.h"
 #include "third_party/blink/renderer/platform/wtf/text/unicode.h"
 #include "third_party/blink/renderer/platform/wtf/text/wtf_string.h"
@@ -123,6 +124,15 @@ class PLATFORM_EXPORT SegmentedSubstring {
     return string_.Substring(offset(), len);
   }
 
+  // See SegmentedString::CurrentRun().
+  StringView CurrentRun(UChar stop1, UChar stop2) const;
+
+  // Moves |count| characters ahead without leaving the substring.
+  ALWAYS_INLINE void AdvanceWithinSubstring(int count) {
+    DCHECK_LT(count, length());
+    data_.string8_ptr += is_8bit_ ? count : count * sizeof(UChar);
+  }
+
   ALWAYS_INLINE int offset() const {
     DCHECK_LE(data_start_, data_.string8_ptr);
     return static_cast<int>(data_.string8_ptr - data_start_) >> !is_8bit_;
@@ -256,6 +266,20 @@ class PLATFORM_EXPORT SegmentedString {
     return Advance();
   }
 
+  // Returns the characters of the current substring from the current one up
+  // to, but not including, the first '\0', '\r', |stop1| or |stop2|, which
+  // the tokenizers can consume in bulk instead of one at a time. Newlines
+  // are part of the run. The characters stay valid until the run is
+  // consumed with AdvancePastRun().
+  StringView CurrentRun(UChar stop1 = '\0', UChar stop2 = '\0') const {
+    return current_string_.CurrentRun(stop1, stop2);
+  }
+
+  // Consumes |run|, which CurrentRun() returned and must not be empty,
+  // updates the line number for the newlines in it, and returns the
+  // character following it.
+  UChar AdvancePastRun(const StringView& run);
+
   // Writes the consumed characters into consumedCharacters, which must
   // have space for at least |count| characters.
   void Advance(unsigned count, UChar* consumed_characters);
@@ -104,4 +104,52 @@ TEST(SegmentedStringTest, AdvanceSubstringConsumesCharacters) {
   EXPECT_EQ(s1.NumberOfCharactersConsumed(), 3);
 }
 
+TEST(SegmentedStringTest, CurrentRun) {
+  SegmentedString s1("abcdefghijklmnopqrstuvwxyz <b>\r\n");
+  s1.Append(SegmentedString("0123"));
+
+  StringView run = s1.CurrentRun('<', '&');
+  EXPECT_EQ("abcdefghijklmnopqrstuvwxyz ", run.ToString());
+  EXPECT_EQ('<', s1.AdvancePastRun(run));
+  EXPECT_EQ(27, s1.NumberOfCharactersConsumed());
+  EXPECT_TRUE(s1.CurrentRun('<').IsEmpty());
+
+  s1.Advance();
+  run = s1.CurrentRun();
+  EXPECT_EQ("b>", run.ToString());
+  EXPECT_EQ('\r', s1.AdvancePastRun(run));
+  EXPECT_TRUE(s1.CurrentRun().IsEmpty());
+
+  // Runs end with their substring.
+  s1.Advance();
+  run = s1.CurrentRun();
+  EXPECT_EQ("\n", run.ToString());
+  EXPECT_EQ('0', s1.AdvancePastRun(run));
+  EXPECT_EQ("0123", s1.CurrentRun().ToString());
+}
+
+TEST(SegmentedStringTest, AdvancePastRunUpdatesLineNumber) {
+  String string = "line 1\nline 2\nline 3 is longer than sixteen characters\r";
+  for (bool is_8bit : {true, false}) {
+    if (!is_8bit)
+      string.Ensure16Bit();
+    SegmentedString s1(string);
+    s1.Append(SegmentedString("\nline 5"));
+
+    StringView run = s1.CurrentRun();
+    EXPECT_EQ(string.length() - 1, run.length());
+    EXPECT_EQ(is_8bit, run.Is8Bit());
+    EXPECT_EQ('\r', s1.AdvancePastRun(run));
+    EXPECT_EQ(2, s1.CurrentLine().ZeroBasedInt());
+    EXPECT_EQ(40, s1.CurrentColumn().ZeroBasedInt());
+
+    s1.Advance();
+    run = s1.CurrentRun();
+    EXPECT_EQ(0, s1.AdvancePastRun(run));
+    EXPECT_TRUE(s1.IsEmpty());
+    EXPECT_EQ(3, s1.CurrentLine().ZeroBasedInt());
+    EXPECT_EQ(6, s1.CurrentColumn().ZeroBasedInt());
+  }
+}
+
 }  // namespace blink
@@ -730,6 +730,43 @@ static_assert(
         unsigned>(),
     "hash map const value iterators should be over values");
 
+struct GroupProbingAtomicStringHashTraits : HashTraits<AtomicString> {
+  static constexpr bool kUseGroupProbing = true;
+};
+
+TEST(HashMapTest, GroupProbing) {
+  using Map = HashMap<AtomicString, int, AtomicStringHash,
+                      GroupProbingAtomicStringHashTraits>;
+  Map map;
+  const int kCount = 500;
+  for (int i = 0; i < kCount; ++i) {
+    AtomicString key = AtomicString::Number(i);
+    EXPECT_TRUE(map.insert(key, i).is_new_entry);
+    EXPECT_FALSE(map.insert(key, -1).is_new_entry);
+  }
+  EXPECT_EQ(static_cast<unsigned>(kCount), map.size());
+
+  for (int i = 0; i < kCount; ++i) {
+    auto it = map.find(AtomicString::Number(i));
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(i, it->value);
+  }
+  EXPECT_FALSE(map.Contains(AtomicString("missing")));
+
+  for (int i = 0; i < kCount; i += 3)
+    map.erase(AtomicString::Number(i));
+  for (int i = 0; i < kCount; ++i)
+    EXPECT_EQ(i % 3 != 0, map.Contains(AtomicString::Number(i)));
+
+  map.Set(AtomicString::Number(1), 42);
+  EXPECT_EQ(42, map.at(AtomicString::Number(1)));
+
+  Map copy = map;
+  EXPECT_EQ(map.size(), copy.size());
+  for (const auto& entry : map)
+    EXPECT_EQ(entry.value, copy.at(entry.key));
+}
+
 }  // anonymous namespace
 
 }  // namespace WTF
@@ -443,6 +443,113 @@ TEST(HashSetTest, HasTraitsForEnum) {
   set3.insert(std::make_pair(TestEnum::kItem0, TestEnumClass::kItem0));
 }
 
+struct GroupProbingIntHashTraits : HashTraits<int> {
+  static constexpr bool kUseGroupProbing = true;
+};
+
+using GroupProbingIntSet =
+    HashSet<int, DefaultHash<int>::Hash, GroupProbingIntHashTraits>;
+
+TEST(HashSetTest, GroupProbingInsertFindErase) {
+  GroupProbingIntSet set;
+  EXPECT_TRUE(set.IsEmpty());
+  EXPECT_FALSE(set.Contains(1));
+
+  const int kCount = 1000;
+  for (int i = 1; i <= kCount; ++i)
+    EXPECT_TRUE(set.insert(i).is_new_entry);
+  for (int i = 1; i <= kCount; ++i)
+    EXPECT_FALSE(set.insert(i).is_new_entry);
+  EXPECT_EQ(static_cast<unsigned>(kCount), set.size());
+  EXPECT_EQ(0u, set.Capacity() % HashTableGroup::kSize);
+
+  for (int i = 1; i <= kCount; ++i) {
+    EXPECT_TRUE(set.Contains(i));
+    auto it = set.find(i);
+    ASSERT_NE(it, set.end());
+    EXPECT_EQ(i, *it);
+  }
+  EXPECT_FALSE(set.Contains(kCount + 1));
+
+  // Erase every other element, and check the others are still found past the
+  // deleted buckets.
+  for (int i = 1; i <= kCount; i += 2)
+    set.erase(i);
+  EXPECT_EQ(static_cast<unsigned>(kCount / 2), set.size());
+  for (int i = 1; i <= kCount; ++i)
+    EXPECT_EQ(i % 2 == 0, set.Contains(i));
+
+  // Deleted buckets are reused.
+  for (int i = 1; i <= kCount; i += 2)
+    EXPECT_TRUE(set.insert(i).is_new_entry);
+  EXPECT_EQ(static_cast<unsigned>(kCount), set.size());
+  for (int i = 1; i <= kCount; ++i)
+    EXPECT_TRUE(set.Contains(i));
+
+  set.clear();
+  EXPECT_TRUE(set.IsEmpty());
+  EXPECT_FALSE(set.Contains(1));
+  EXPECT_TRUE(set.insert(1).is_new_entry);
+  EXPECT_TRUE(set.Contains(1));
+}
+
+TEST(HashSetTest, GroupProbingIteration) {
+  GroupProbingIntSet set;
+  for (int i = 1; i <= 100; ++i)
+    set.insert(i);
+
+  int sum = 0;
+  unsigned count = 0;
+  for (int value : set) {
+    sum += value;
+    ++count;
+  }
+  EXPECT_EQ(100u, count);
+  EXPECT_EQ(5050, sum);
+}
+
+TEST(HashSetTest, GroupProbingShrink) {
+  GroupProbingIntSet set;
+  for (int i = 1; i <= 1000; ++i)
+    set.insert(i);
+  const unsigned large_capacity = set.Capacity();
+
+  // Removing most elements shrinks the table, which rebuilds the control
+  // bytes.
+  for (int i = 11; i <= 1000; ++i)
+    set.erase(i);
+  EXPECT_LT(set.Capacity(), large_capacity);
+  EXPECT_EQ(10u, set.size());
+  for (int i = 1; i <= 1000; ++i)
+    EXPECT_EQ(i <= 10, set.Contains(i));
+}
+
+TEST(HashSetTest, GroupProbingCopyAndSwap) {
+  GroupProbingIntSet set1;
+  GroupProbingIntSet set2;
+  for (int i = 1; i <= 50; ++i)
+    set1.insert(i);
+  for (int i = 51; i <= 60; ++i)
+    set2.insert(i);
+
+  GroupProbingIntSet copy = set1;
+  EXPECT_EQ(set1.size(), copy.size());
+  for (int i = 1; i <= 50; ++i)
+    EXPECT_TRUE(copy.Contains(i));
+
+  set1.swap(set2);
+  EXPECT_EQ(10u, set1.size());
+  EXPECT_EQ(50u, set2.size());
+  EXPECT_TRUE(set1.Contains(55));
+  EXPECT_FALSE(set1.Contains(5));
+  EXPECT_TRUE(set2.Contains(5));
+  EXPECT_FALSE(set2.Contains(55));
+
+  GroupProbingIntSet moved = std::move(set2);
+  EXPECT_EQ(50u, moved.size());
+  EXPECT_TRUE(moved.Contains(50));
+}
+
 static_assert(!IsTraceable<HashSet<int>>::value,
               "HashSet<int, int> must not be traceable.");
 
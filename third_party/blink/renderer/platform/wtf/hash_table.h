@@ -33,6 +33,7 @@
 #include "third_party/blink/renderer/platform/wtf/assertions.h"
 #include "third_party/blink/renderer/platform/wtf/conditional_destructor.h"
 #include "third_party/blink/renderer/platform/wtf/construct_traits.h"
+#include "third_party/blink/renderer/platform/wtf/hash_table_group.h"
 #include "third_party/blink/renderer/platform/wtf/hash_traits.h"
 
 #if !defined(DUMP_HASHTABLE_STATS)
@@ -232,6 +233,15 @@ struct WeakProcessingHashTableHelper;
 
 typedef enum { kHashItemKnownGood } HashItemKnownGoodTag;
 
+// Whether hash tables with |KeyTraits| use group probing. Key traits not
+// deriving from GenericHashTraits keep the default layout.
+template <typename KeyTraits, typename = void>
+struct HashTableUsesGroupProbing : std::false_type {};
+template <typename KeyTraits>
+struct HashTableUsesGroupProbing<KeyTraits,
+                                 decltype(void(KeyTraits::kUseGroupProbing))>
+    : std::integral_constant<bool, KeyTraits::kUseGroupProbing> {};
+
 template <typename Key,
           typename Value,
           typename Extractor,
@@ -756,6 +766,10 @@ class HashTable final
     DeleteAllBucketsAndDeallocate(table_, table_size_);
     LeaveAccessForbiddenScope();
     table_ = nullptr;
+    if (kUseGroupProbing) {
+      FreeControlBytes(control_.get());
+      *control_.slot() = nullptr;
+    }
   }
 
   HashTable(const HashTable&);
@@ -901,7 +915,27 @@ class HashTable final
 
   void erase(const ValueType*);
 
+  // Group probing. See HashTraits::kUseGroupProbing.
+  static constexpr bool kUseGroupProbing =
+      HashTableUsesGroupProbing<KeyTraits>::value;
+  static uint8_t* AllocateControlBytes(unsigned size);
+  static void FreeControlBytes(uint8_t* control);
+  void SetControlByte(const ValueType* bucket, uint8_t control) {
+    DCHECK(kUseGroupProbing);
+    control_.get()[bucket - table_] = control;
+  }
+  template <typename HashTranslator, typename T>
+  const ValueType* GroupLookup(const T&) const;
+  template <typename HashTranslator, typename T>
+  LookupType GroupLookupForWriting(const T&,
+                                   unsigned hash,
+                                   bool can_reuse_deleted_entry);
+
   bool ShouldExpand() const {
+    if (kUseGroupProbing) {
+      return (key_count_ + deleted_count_) * kGroupMaxLoadDenominator >=
+             table_size_ * kGroupMaxLoadNumerator;
+    }
     return (key_count_ + deleted_count_) * kMaxLoad >= table_size_;
   }
   bool MustRehashInPlace() const {
@@ -911,7 +945,7 @@ class HashTable final
     // isAllocationAllowed check should be at the last because it's
     // expensive.
     return key_count_ * kMinLoad < table_size_ &&
-           table_size_ > KeyTraits::kMinimumTableSize &&
+           table_size_ > kMinimumTableSize &&
            Allocator::IsAllocationAllowed();
   }
   ValueType* Expand(ValueType* entry = nullptr);
@@ -956,6 +990,18 @@ class HashTable final
   static const unsigned kMaxLoad = 2;
   static const unsigned kMinLoad = 6;
 
+  // Maximum load factor with group probing. At least one bucket of the table
+  // is always empty, which terminates the probing.
+  static const unsigned kGroupMaxLoadNumerator = 7;
+  static const unsigned kGroupMaxLoadDenominator = 8;
+
+  // Groups of control bytes are aligned, so tables using group probing have
+  // at least one full group.
+  static constexpr unsigned kMinimumTableSize =
+      kUseGroupProbing && KeyTraits::kMinimumTableSize < HashTableGroup::kSize
+          ? HashTableGroup::kSize
+          : KeyTraits::kMinimumTableSize;
+
   unsigned TableSizeMask() const {
     unsigned mask = table_size_ - 1;
     DCHECK_EQ((mask & table_size_), 0u);
@@ -980,6 +1026,8 @@ class HashTable final
         modifications_(0)
 #endif
   {
+    if (kUseGroupProbing)
+      *control_.slot() = AllocateControlBytes(size);
   }
 
   ValueType* table_;
@@ -995,6 +1043,10 @@ class HashTable final
   unsigned queue_flag_ : 1;
 #endif
 
+  // Control bytes of the buckets of |table_|. Unless kUseGroupProbing, this is
+  // an empty object fitting in the padding of the fields above.
+  HashTableControlBytes<kUseGroupProbing> control_;
+
 #if DUMP_HASHTABLE_STATS_PER_TABLE
  public:
   mutable
@@ -1085,8 +1137,14 @@ void HashTable<Key,
                KeyTraits,
                Allocator>::ReserveCapacityForSize(unsigned new_size) {
   unsigned new_capacity = CalculateCapacity(new_size);
-  if (new_capacity < KeyTraits::kMinimumTableSize)
-    new_capacity = KeyTraits::kMinimumTableSize;
+  if (kUseGroupProbing) {
+    // Tables using group probing can be fuller, see ShouldExpand().
+    new_capacity = CalculateCapacity(static_cast<unsigned>(
+        static_cast<uint64_t>(new_size) * kGroupMaxLoadDenominator /
+        kGroupMaxLoadNumerator / 2));
+  }
+  if (new_capacity < kMinimumTableSize)
+    new_capacity = kMinimumTableSize;
 
   if (new_capacity > Capacity()) {
     CHECK(!static_cast<int>(
@@ -1131,6 +1189,9 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   if (!table)
     return nullptr;
 
+  if (kUseGroupProbing)
+    return GroupLookup<HashTranslator>(key);
+
   size_t k = 0;
   size_t size_mask = TableSizeMask();
   unsigned h = HashTranslator::GetHash(key);
@@ -1183,6 +1244,11 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   DCHECK(table_);
   RegisterModification();
 
+  if (kUseGroupProbing) {
+    return GroupLookupForWriting<HashTranslator>(
+        key, HashTranslator::GetHash(key), /*can_reuse_deleted_entry=*/true);
+  }
+
   ValueType* table = table_;
   size_t k = 0;
   size_t size_mask = TableSizeMask();
@@ -1239,6 +1305,13 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   DCHECK(table_);
   RegisterModification();
 
+  if (kUseGroupProbing) {
+    const unsigned h = HashTranslator::GetHash(key);
+    return FullLookupType(GroupLookupForWriting<HashTranslator>(
+                              key, h, /*can_reuse_deleted_entry=*/true),
+                          h);
+  }
+
   ValueType* table = table_;
   size_t k = 0;
   size_t size_mask = TableSizeMask();
@@ -1274,6 +1347,105 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   }
 }
 
+template <typename Key,
+          typename Value,
+          typename Extractor,
+          typename HashFunctions,
+          typename Traits,
+          typename KeyTraits,
+          typename Allocator>
+template <typename HashTranslator, typename T>
+inline const Value*
+HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
+    GroupLookup(const T& key) const {
+  DCHECK(kUseGroupProbing);
+  const ValueType* table = table_;
+  const uint8_t* control = control_.get();
+  const unsigned h = HashTranslator::GetHash(key);
+  const uint8_t tag = HashTableGroup::Tag(h);
+  const size_t group_mask = table_size_ / HashTableGroup::kSize - 1;
+  size_t group = HashTableGroup::FirstGroup(h) & group_mask;
+
+  UPDATE_ACCESS_COUNTS();
+
+  // Triangular probing of the groups visits all of them, since their number
+  // is a power of two.
+  for (size_t step = 1;; ++step) {
+    const size_t offset = group * HashTableGroup::kSize;
+    for (HashTableGroup::Mask mask =
+             HashTableGroup::Match(control + offset, tag);
+         mask; mask &= mask - 1) {
+      const ValueType* entry =
+          table + offset + HashTableGroup::LowestBucket(mask);
+      if (HashTranslator::Equal(Extractor::Extract(*entry), key))
+        return entry;
+    }
+    if (HashTableGroup::MatchEmpty(control + offset))
+      return nullptr;
+    UPDATE_PROBE_COUNTS();
+    group = (group + step) & group_mask;
+  }
+}
+
+template <typename Key,
+          typename Value,
+          typename Extractor,
+          typename HashFunctions,
+          typename Traits,
+          typename KeyTraits,
+          typename Allocator>
+template <typename HashTranslator, typename T>
+inline typename HashTable<Key,
+                          Value,
+                          Extractor,
+                          HashFunctions,
+                          Traits,
+                          KeyTraits,
+                          Allocator>::LookupType
+HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
+    GroupLookupForWriting(const T& key,
+                          unsigned h,
+                          bool can_reuse_deleted_entry) {
+  DCHECK(kUseGroupProbing);
+  ValueType* table = table_;
+  const uint8_t* control = control_.get();
+  const uint8_t tag = HashTableGroup::Tag(h);
+  const size_t group_mask = table_size_ / HashTableGroup::kSize - 1;
+  size_t group = HashTableGroup::FirstGroup(h) & group_mask;
+
+  UPDATE_ACCESS_COUNTS();
+
+  // First empty (or reusable deleted) bucket on the probe sequence.
+  ValueType* insert_entry = nullptr;
+
+  for (size_t step = 1;; ++step) {
+    const size_t offset = group * HashTableGroup::kSize;
+    for (HashTableGroup::Mask mask =
+             HashTableGroup::Match(control + offset, tag);
+         mask; mask &= mask - 1) {
+      ValueType* entry = table + offset + HashTableGroup::LowestBucket(mask);
+      if (HashTranslator::Equal(Extractor::Extract(*entry), key))
+        return LookupType(entry, true);
+    }
+    const HashTableGroup::Mask empty_mask =
+        HashTableGroup::MatchEmpty(control + offset);
+    if (!insert_entry) {
+      const HashTableGroup::Mask free_mask =
+          can_reuse_deleted_entry
+              ? HashTableGroup::MatchEmptyOrDeleted(control + offset)
+              : empty_mask;
+      if (free_mask)
+        insert_entry = table + offset + HashTableGroup::LowestBucket(free_mask);
+    }
+    if (empty_mask) {
+      DCHECK(insert_entry);
+      return LookupType(insert_entry, false);
+    }
+    UPDATE_PROBE_COUNTS();
+    group = (group + step) & group_mask;
+  }
+}
+
 template <bool emptyValueIsZero>
 struct HashTableBucketInitializer;
 
@@ -1374,41 +1546,52 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
 
   DCHECK(table_);
 
-  ValueType* table = table_;
-  size_t k = 0;
-  size_t size_mask = TableSizeMask();
   unsigned h = HashTranslator::GetHash(key);
-  size_t i = h & size_mask;
-
-  UPDATE_ACCESS_COUNTS();
 
   bool can_reuse_deleted_entry =
       Allocator::template CanReuseHashTableDeletedBucket<Traits>();
 
   ValueType* deleted_entry = nullptr;
   ValueType* entry;
-  while (1) {
-    entry = table + i;
+  if (kUseGroupProbing) {
+    LookupType lookup_result = GroupLookupForWriting<HashTranslator>(
+        key, h, can_reuse_deleted_entry);
+    entry = lookup_result.first;
+    if (lookup_result.second)
+      return AddResult(this, entry, false);
+    if (control_.get()[entry - table_] == HashTableGroup::kDeleted)
+      deleted_entry = entry;
+  } else {
+    ValueType* table = table_;
+    size_t k = 0;
+    size_t size_mask = TableSizeMask();
+    size_t i = h & size_mask;
 
-    if (IsEmptyBucket(*entry))
-      break;
+    UPDATE_ACCESS_COUNTS();
 
-    if (HashFunctions::safe_to_compare_to_empty_or_deleted) {
-      if (HashTranslator::Equal(Extractor::Extract(*entry), key))
-        return AddResult(this, entry, false);
+    while (1) {
+      entry = table + i;
 
-      if (IsDeletedBucket(*entry) && can_reuse_deleted_entry)
-        deleted_entry = entry;
-    } else {
-      if (IsDeletedBucket(*entry) && can_reuse_deleted_entry)
-        deleted_entry = entry;
-      else if (HashTranslator::Equal(Extractor::Extract(*entry), key))
-        return AddResult(this, entry, false);
+      if (IsEmptyBucket(*entry))
+        break;
+
+      if (HashFunctions::safe_to_compare_to_empty_or_deleted) {
+        if (HashTranslator::Equal(Extractor::Extract(*entry), key))
+          return AddResult(this, entry, false);
+
+        if (IsDeletedBucket(*entry) && can_reuse_deleted_entry)
+          deleted_entry = entry;
+      } else {
+        if (IsDeletedBucket(*entry) && can_reuse_deleted_entry)
+          deleted_entry = entry;
+        else if (HashTranslator::Equal(Extractor::Extract(*entry), key))
+          return AddResult(this, entry, false);
+      }
+      UPDATE_PROBE_COUNTS();
+      if (!k)
+        k = 1 | DoubleHash(h);
+      i = (i + k) & size_mask;
     }
-    UPDATE_PROBE_COUNTS();
-    if (!k)
-      k = 1 | DoubleHash(h);
-    i = (i + k) & size_mask;
   }
 
   RegisterModification();
@@ -1428,6 +1611,8 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   // Translate constructs an element so we need to notify using the trait. Avoid
   // doing that in the translator so that they can be easily customized.
   ConstructTraits<ValueType, Traits, Allocator>::NotifyNewElement(entry);
+  if (kUseGroupProbing)
+    SetControlByte(entry, HashTableGroup::Tag(h));
 
   ++key_count_;
 
@@ -1496,6 +1681,8 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   // Translate constructs an element so we need to notify using the trait. Avoid
   // doing that in the translator so that they can be easily customized.
   ConstructTraits<ValueType, Traits, Allocator>::NotifyNewElement(entry);
+  if (kUseGroupProbing)
+    SetControlByte(entry, HashTableGroup::Tag(h));
 
   ++key_count_;
   if (ShouldExpand())
@@ -1526,7 +1713,18 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
 #if DUMP_HASHTABLE_STATS_PER_TABLE
   stats_->numReinserts.fetch_add(1, std::memory_order_relaxed);
 #endif
-  Value* new_entry = LookupForWriting(Extractor::Extract(entry)).first;
+  Value* new_entry;
+  if (kUseGroupProbing) {
+    const unsigned h =
+        IdentityTranslatorType::GetHash(Extractor::Extract(entry));
+    new_entry = GroupLookupForWriting<IdentityTranslatorType>(
+                    Extractor::Extract(entry), h,
+                    /*can_reuse_deleted_entry=*/false)
+                    .first;
+    SetControlByte(new_entry, HashTableGroup::Tag(h));
+  } else {
+    new_entry = LookupForWriting(Extractor::Extract(entry)).first;
+  }
   Mover<ValueType, Allocator, Traits,
         Traits::template NeedsToForbidGCOnMove<>::value>::Move(std::move(entry),
                                                                *new_entry);
@@ -1625,6 +1823,8 @@ void HashTable<Key,
   EnterAccessForbiddenScope();
   DeleteBucket(*pos);
   LeaveAccessForbiddenScope();
+  if (kUseGroupProbing)
+    SetControlByte(pos, HashTableGroup::kDeleted);
   ++deleted_count_;
   --key_count_;
 
@@ -1763,6 +1963,43 @@ void HashTable<Key,
   Allocator::template FreeHashTableBacking<ValueType, HashTable>(table);
 }
 
+template <typename Key,
+          typename Value,
+          typename Extractor,
+          typename HashFunctions,
+          typename Traits,
+          typename KeyTraits,
+          typename Allocator>
+uint8_t*
+HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
+    AllocateControlBytes(unsigned size) {
+  DCHECK(kUseGroupProbing);
+  DCHECK_EQ(size % HashTableGroup::kSize, 0u);
+  // The control bytes hold no references, so they are allocated as a plain
+  // vector backing, even for garbage collected tables.
+  uint8_t* control = Allocator::template AllocateVectorBacking<uint8_t>(size);
+  memset(control, HashTableGroup::kEmpty, size);
+  return control;
+}
+
+template <typename Key,
+          typename Value,
+          typename Extractor,
+          typename HashFunctions,
+          typename Traits,
+          typename KeyTraits,
+          typename Allocator>
+void HashTable<Key,
+               Value,
+               Extractor,
+               HashFunctions,
+               Traits,
+               KeyTraits,
+               Allocator>::FreeControlBytes(uint8_t* control) {
+  if (control)
+    Allocator::FreeVectorBacking(control);
+}
+
 template <typename Key,
           typename Value,
           typename Extractor,
@@ -1775,7 +2012,7 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
     Expand(Value* entry) {
   unsigned new_size;
   if (!table_size_) {
-    new_size = KeyTraits::kMinimumTableSize;
+    new_size = kMinimumTableSize;
   } else if (MustRehashInPlace()) {
     new_size = table_size_;
   } else {
@@ -1893,6 +2130,14 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   new_hash_table.table_ = old_table;
   new_hash_table.table_size_ = old_table_size;
 
+  if (kUseGroupProbing) {
+    uint8_t* old_control = control_.get();
+    AsAtomicPtr(control_.slot())
+        ->store(new_hash_table.control_.get(), std::memory_order_relaxed);
+    Allocator::template BackingWriteBarrier(control_.slot());
+    *new_hash_table.control_.slot() = old_control;
+  }
+
   // Explicitly clear since garbage collected HashTables don't do this on
   // destruction.
   new_hash_table.clear();
@@ -1934,7 +2179,10 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
   // The Allocator::kIsGarbageCollected check is not needed.  The check is just
   // a static hint for a compiler to indicate that Base::expandBuffer returns
   // false if Allocator is a PartitionAllocator.
-  if (Allocator::kIsGarbageCollected && new_table_size > old_table_size) {
+  // The control bytes of tables using group probing are rebuilt on rehash, so
+  // the backing is not expanded in place.
+  if (Allocator::kIsGarbageCollected && !kUseGroupProbing &&
+      new_table_size > old_table_size) {
     bool success;
     Value* new_entry = ExpandBuffer(new_table_size, entry, success);
     if (success)
@@ -1971,6 +2219,10 @@ void HashTable<Key,
   AsAtomicPtr(&table_)->store(nullptr, std::memory_order_relaxed);
   table_size_ = 0;
   key_count_ = 0;
+  if (kUseGroupProbing) {
+    FreeControlBytes(control_.get());
+    AsAtomicPtr(control_.slot())->store(nullptr, std::memory_order_relaxed);
+  }
 }
 
 template <typename Key,
@@ -2057,6 +2309,11 @@ void HashTable<Key,
   AtomicWriteSwap(table_, other.table_);
   Allocator::template BackingWriteBarrier(&table_);
   Allocator::template BackingWriteBarrier(&other.table_);
+  if (kUseGroupProbing) {
+    AtomicWriteSwap(*control_.slot(), *other.control_.slot());
+    Allocator::template BackingWriteBarrier(control_.slot());
+    Allocator::template BackingWriteBarrier(other.control_.slot());
+  }
   if (IsWeak<ValueType>::value) {
     // Weak processing is omitted when no backing store is present. In case such
     // an empty table is later on used it needs to be strongified.
@@ -2170,6 +2427,8 @@ struct WeakProcessingHashTableHelper<kWeakHandling,
                 info, *element)) {
           table->RegisterModification();
           HashTableType::DeleteBucket(*element);  // Also calls the destructor.
+          if (HashTableType::kUseGroupProbing)
+            table->SetControlByte(element, HashTableGroup::kDeleted);
           table->deleted_count_++;
           table->key_count_--;
           // We don't rehash the backing until the next add or delete,
@@ -2195,6 +2454,11 @@ HashTable<Key, Value, Extractor, HashFunctions, Traits, KeyTraits, Allocator>::
                     IsTraceableInCollectionTrait<Traits>::value,
                 "Value should not be traced");
   TraceTable(visitor, AsAtomicPtr(&table_)->load(std::memory_order_relaxed));
+  if (kUseGroupProbing) {
+    Allocator::template TraceVectorBacking<uint8_t>(
+        visitor, AsAtomicPtr(control_.slot())->load(std::memory_order_relaxed),
+        control_.slot());
+  }
 }
 
 template <typename Key,
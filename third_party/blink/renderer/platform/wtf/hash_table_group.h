@@ -0,0 +1,126 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef THIRD_PARTY_BLINK_RENDERER_PLATFORM_WTF_HASH_TABLE_GROUP_H_
+#define THIRD_PARTY_BLINK_RENDERER_PLATFORM_WTF_HASH_TABLE_GROUP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/bits.h"
+#include "build/build_config.h"
+#include "third_party/blink/renderer/platform/wtf/allocator/allocator.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
+namespace WTF {
+
+// Control bytes of hash tables using group probing (see
+// HashTraits::kUseGroupProbing). Each bucket of the table has one control byte
+// which is either kEmpty, kDeleted, or the 7-bit tag of the hash of the key
+// stored in the bucket. Lookups compare the tag against a whole group of
+// control bytes at once, and only compare keys in the buckets whose tags
+// match.
+class HashTableGroup {
+  STATIC_ONLY(HashTableGroup);
+
+ public:
+  // Number of control bytes compared at once. Groups are aligned, so hash
+  // tables using group probing have at least kSize buckets.
+  static constexpr unsigned kSize = 16;
+
+  static constexpr uint8_t kEmpty = 0x80;
+  static constexpr uint8_t kDeleted = 0xfe;
+
+  // A bitmask with one bit per bucket of a group, the lowest bit being the
+  // first bucket.
+  using Mask = uint32_t;
+
+  // The tag of a full bucket, in the lowest 7 bits of the hash. The remaining
+  // bits select the first group to probe.
+  static uint8_t Tag(unsigned hash) { return hash & 0x7f; }
+  static unsigned FirstGroup(unsigned hash) { return hash >> 7; }
+
+  // Returns the index of the lowest bucket of a non-empty |mask|.
+  static unsigned LowestBucket(Mask mask) {
+    return base::bits::CountTrailingZeroBits(mask);
+  }
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  // Returns the buckets of the group starting at |control| whose control byte
+  // is |tag|.
+  static Mask Match(const uint8_t* control, uint8_t tag) {
+    const __m128i group = Load(control);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+  }
+
+  // Returns the empty buckets of the group starting at |control|.
+  static Mask MatchEmpty(const uint8_t* control) {
+    return Match(control, kEmpty);
+  }
+
+  // Returns the empty or deleted buckets of the group starting at |control|.
+  // These are the only control bytes with their highest bit set.
+  static Mask MatchEmptyOrDeleted(const uint8_t* control) {
+    return _mm_movemask_epi8(Load(control));
+  }
+
+ private:
+  static __m128i Load(const uint8_t* control) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+  }
+#else
+  static Mask Match(const uint8_t* control, uint8_t tag) {
+    Mask mask = 0;
+    for (unsigned i = 0; i < kSize; ++i)
+      mask |= static_cast<Mask>(control[i] == tag) << i;
+    return mask;
+  }
+
+  static Mask MatchEmpty(const uint8_t* control) {
+    return Match(control, kEmpty);
+  }
+
+  static Mask MatchEmptyOrDeleted(const uint8_t* control) {
+    Mask mask = 0;
+    for (unsigned i = 0; i < kSize; ++i)
+      mask |= static_cast<Mask>(control[i] >> 7) << i;
+    return mask;
+  }
+#endif
+};
+
+// Pointer to the control bytes of a hash table. Tables not using group probing
+// have no control bytes, and only pay for an empty object.
+template <bool has_control_bytes>
+class HashTableControlBytes;
+
+template <>
+class HashTableControlBytes<true> {
+  DISALLOW_NEW();
+
+ public:
+  uint8_t* get() const { return control_; }
+  uint8_t** slot() { return &control_; }
+  uint8_t* const* slot() const { return &control_; }
+
+ private:
+  uint8_t* control_ = nullptr;
+};
+
+template <>
+class HashTableControlBytes<false> {
+  DISALLOW_NEW();
+
+ public:
+  uint8_t* get() const { return nullptr; }
+  uint8_t** slot() { return nullptr; }
+  uint8_t* const* slot() const { return nullptr; }
+};
+
+}  // namespace WTF
+
+#endif  // THIRD_PARTY_BLINK_RENDERER_PLATFORM_WTF_HASH_TABLE_GROUP_H_
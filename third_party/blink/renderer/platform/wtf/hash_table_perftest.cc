@@ -0,0 +1,166 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/blink/renderer/platform/wtf/hash_map.h"
+#include "third_party/blink/renderer/platform/wtf/hash_set.h"
+#include "third_party/blink/renderer/platform/wtf/text/atomic_string.h"
+#include "third_party/blink/renderer/platform/wtf/text/atomic_string_hash.h"
+#include "third_party/blink/renderer/platform/wtf/text/string_hash.h"
+#include "third_party/blink/renderer/platform/wtf/vector.h"
+
+namespace WTF {
+
+namespace {
+
+// Compares the default double hashing layout of HashTable with the group
+// probing layout (HashTraits::kUseGroupProbing) on the same keys.
+
+template <typename T>
+struct GroupProbingHashTraits : HashTraits<T> {
+  static constexpr bool kUseGroupProbing = true;
+};
+
+constexpr wtf_size_t kNumKeys = 100000;
+constexpr int kNumRounds = 10;
+
+constexpr char kMetricPrefix[] = "HashTable.";
+constexpr char kMetricInsert[] = "insert";
+constexpr char kMetricFindHit[] = "find_hit";
+constexpr char kMetricFindMiss[] = "find_miss";
+constexpr char kMetricErase[] = "erase";
+
+template <typename Callback>
+base::TimeDelta TimedRun(Callback callback) {
+  const auto start = base::TimeTicks::Now();
+  callback();
+  return base::TimeTicks::Now() - start;
+}
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story_name);
+  reporter.RegisterImportantMetric(kMetricInsert, "ns/op");
+  reporter.RegisterImportantMetric(kMetricFindHit, "ns/op");
+  reporter.RegisterImportantMetric(kMetricFindMiss, "ns/op");
+  reporter.RegisterImportantMetric(kMetricErase, "ns/op");
+  return reporter;
+}
+
+double NanosecondsPerOperation(base::TimeDelta delta) {
+  return delta.InNanosecondsF() / (kNumKeys * kNumRounds);
+}
+
+// Runs insert, successful and unsuccessful find, and erase of |keys| on a
+// |Set|. |misses| are keys that are never in the set.
+template <typename Set, typename T>
+void RunSetBenchmark(const std::string& story_name,
+                     const Vector<T>& keys,
+                     const Vector<T>& misses) {
+  base::TimeDelta insert_time;
+  base::TimeDelta find_hit_time;
+  base::TimeDelta find_miss_time;
+  base::TimeDelta erase_time;
+  size_t found = 0;
+  for (int round = 0; round < kNumRounds; ++round) {
+    Set set;
+    insert_time += TimedRun([&]() {
+      for (const T& key : keys)
+        set.insert(key);
+    });
+    find_hit_time += TimedRun([&]() {
+      for (const T& key : keys)
+        found += set.Contains(key);
+    });
+    find_miss_time += TimedRun([&]() {
+      for (const T& key : misses)
+        found += set.Contains(key);
+    });
+    erase_time += TimedRun([&]() {
+      for (const T& key : keys)
+        set.erase(key);
+    });
+    EXPECT_TRUE(set.IsEmpty());
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumKeys) * kNumRounds, found);
+
+  auto reporter = SetUpReporter(story_name);
+  reporter.AddResult(kMetricInsert, NanosecondsPerOperation(insert_time));
+  reporter.AddResult(kMetricFindHit, NanosecondsPerOperation(find_hit_time));
+  reporter.AddResult(kMetricFindMiss, NanosecondsPerOperation(find_miss_time));
+  reporter.AddResult(kMetricErase, NanosecondsPerOperation(erase_time));
+}
+
+Vector<int> IntKeys(int first) {
+  Vector<int> keys;
+  keys.ReserveInitialCapacity(kNumKeys);
+  for (wtf_size_t i = 0; i < kNumKeys; ++i)
+    keys.push_back(first + static_cast<int>(i) * 7);
+  return keys;
+}
+
+Vector<String> StringKeys(const char* prefix) {
+  Vector<String> keys;
+  keys.ReserveInitialCapacity(kNumKeys);
+  for (wtf_size_t i = 0; i < kNumKeys; ++i)
+    keys.push_back(String(prefix) + String::Number(i));
+  return keys;
+}
+
+Vector<AtomicString> AtomicStringKeys(const char* prefix) {
+  Vector<AtomicString> keys;
+  keys.ReserveInitialCapacity(kNumKeys);
+  for (wtf_size_t i = 0; i < kNumKeys; ++i)
+    keys.push_back(AtomicString(String(prefix) + String::Number(i)));
+  return keys;
+}
+
+}  // namespace
+
+TEST(HashTablePerfTest, IntKeys) {
+  const Vector<int> keys = IntKeys(1);
+  const Vector<int> misses = IntKeys(1 << 24);
+  RunSetBenchmark<HashSet<int>>("IntKeys", keys, misses);
+  RunSetBenchmark<HashSet<int, DefaultHash<int>::Hash,
+                          GroupProbingHashTraits<int>>>("IntKeysGroupProbing",
+                                                        keys, misses);
+}
+
+TEST(HashTablePerfTest, PointerKeys) {
+  Vector<int> storage;
+  storage.resize(2 * kNumKeys);
+  Vector<int*> keys;
+  Vector<int*> misses;
+  for (wtf_size_t i = 0; i < kNumKeys; ++i) {
+    keys.push_back(&storage[i]);
+    misses.push_back(&storage[kNumKeys + i]);
+  }
+  RunSetBenchmark<HashSet<int*>>("PointerKeys", keys, misses);
+  RunSetBenchmark<HashSet<int*, DefaultHash<int*>::Hash,
+                          GroupProbingHashTraits<int*>>>(
+      "PointerKeysGroupProbing", keys, misses);
+}
+
+TEST(HashTablePerfTest, StringKeys) {
+  const Vector<String> keys = StringKeys("key");
+  const Vector<String> misses = StringKeys("miss");
+  RunSetBenchmark<HashSet<String>>("StringKeys", keys, misses);
+  RunSetBenchmark<
+      HashSet<String, StringHash, GroupProbingHashTraits<String>>>(
+      "StringKeysGroupProbing", keys, misses);
+}
+
+TEST(HashTablePerfTest, AtomicStringKeys) {
+  const Vector<AtomicString> keys = AtomicStringKeys("key");
+  const Vector<AtomicString> misses = AtomicStringKeys("miss");
+  RunSetBenchmark<HashSet<AtomicString>>("AtomicStringKeys", keys, misses);
+  RunSetBenchmark<HashSet<AtomicString, AtomicStringHash,
+                          GroupProbingHashTraits<AtomicString>>>(
+      "AtomicStringKeysGroupProbing", keys, misses);
+}
+
+}  // namespace WTF
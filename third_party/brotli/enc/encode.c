@@ -31,6 +31,7 @@
 #include "./prefix.h"
 #include "./quality.h"
 #include "./ringbuffer.h"
+#include "./thread.h"
 #include "./utf8_util.h"
 #include "./write_bits.h"
 
@@ -124,6 +125,16 @@ typedef struct BrotliEncoderStateStruct {
   uint32_t remaining_metadata_bytes_;
   BrotliEncoderStreamState stream_state_;
 
+  /* When compressing with multiple threads, the input is buffered until a
+     batch of chunks is collected. The buffer starts with the window of
+     already compressed input, which primes the encoders of the chunks. */
+  uint8_t* parallel_buf_;
+  size_t parallel_buf_size_;
+  size_t parallel_history_;
+  size_t parallel_pending_;
+  /* Stream position of the first pending byte. */
+  uint64_t parallel_pos_;
+
   BROTLI_BOOL is_last_block_emitted_;
   BROTLI_BOOL is_initialized_;
 } BrotliEncoderStateStruct;
@@ -191,6 +202,11 @@ BROTLI_BOOL BrotliEncoderSetParameter(
       state->params.stream_offset = value;
       return BROTLI_TRUE;
 
+    case BROTLI_PARAM_NUM_THREADS:
+      if (value > BROTLI_MAX_NUM_THREADS) return BROTLI_FALSE;
+      state->params.num_threads = (int)value;
+      return BROTLI_TRUE;
+
     default: return BROTLI_FALSE;
   }
 }
@@ -744,6 +760,7 @@ static void BrotliEncoderInitParams(BrotliEncoderParams* params) {
   params->lgblock = 0;
   params->stream_offset = 0;
   params->size_hint = 0;
+  params->num_threads = 1;
   params->disable_literal_context_modeling = BROTLI_FALSE;
   BrotliInitEncoderDictionary(&params->dictionary);
   params->dist.distance_postfix_bits = 0;
@@ -776,6 +793,11 @@ static void BrotliEncoderInitState(BrotliEncoderState* s) {
   s->available_out_ = 0;
   s->total_out_ = 0;
   s->stream_state_ = BROTLI_STREAM_PROCESSING;
+  s->parallel_buf_ = NULL;
+  s->parallel_buf_size_ = 0;
+  s->parallel_history_ = 0;
+  s->parallel_pending_ = 0;
+  s->parallel_pos_ = 0;
   s->is_last_block_emitted_ = BROTLI_FALSE;
   s->is_initialized_ = BROTLI_FALSE;
 
@@ -825,6 +847,7 @@ static void BrotliEncoderCleanupState(BrotliEncoderState* s) {
   BROTLI_FREE(m, s->large_table_);
   BROTLI_FREE(m, s->command_buf_);
   BROTLI_FREE(m, s->literal_buf_);
+  BROTLI_FREE(m, s->parallel_buf_);
 }
 
 /* Deinitializes and frees BrotliEncoderState instance. */
@@ -1718,6 +1741,308 @@ static BROTLI_BOOL BrotliEncoderCompressStreamFast(
   return BROTLI_TRUE;
 }
 
+static void UpdateSizeHint(BrotliEncoderState* s, size_t available_in) {
+  if (s->params.size_hint == 0) {
+    uint64_t delta = UnprocessedInputSize(s);
+    uint64_t tail = available_in;
+    uint32_t limit = 1u << 30;
+    uint32_t total;
+    if ((delta >= limit) || (tail >= limit) || ((delta + tail) >= limit)) {
+      total = limit;
+    } else {
+      total = (uint32_t)(delta + tail);
+    }
+    s->params.size_hint = total;
+  }
+}
+
+/* Size of the chunks of input compressed in parallel. Every chunk starts a
+   meta-block, and its encoder has to hash the window preceding the chunk;
+   with windows of up to 4 MiB, that takes less time than compressing it. */
+#define BROTLI_PARALLEL_CHUNK_SIZE (1u << 22)
+/* A batch cut short by a flush or by the end of the stream is split evenly
+   between the threads, in chunks of at least this size. */
+#define BROTLI_MIN_PARALLEL_CHUNK_SIZE (1u << 16)
+
+typedef struct ParallelJob {
+  BrotliEncoderState* encoder;
+  /* Window of input preceding the chunk, followed by the chunk. */
+  const uint8_t* data;
+  size_t history_size;
+  size_t input_size;
+  BrotliEncoderOperation op;
+  uint8_t* output;
+  size_t output_size;
+  size_t output_capacity;
+  BROTLI_BOOL result;
+  BrotliThread thread;
+} ParallelJob;
+
+/* Returns the number of bytes preceding a chunk which prime its encoder. */
+static size_t ParallelHistorySize(const BrotliEncoderParams* params) {
+  /* Fast qualities never reference the input of previous blocks. */
+  if (params->quality == FAST_ONE_PASS_COMPRESSION_QUALITY ||
+      params->quality == FAST_TWO_PASS_COMPRESSION_QUALITY) {
+    return 0;
+  }
+  return BROTLI_MAX_BACKWARD_LIMIT(params->lgwin);
+}
+
+static size_t ParallelBatchSize(const BrotliEncoderParams* params) {
+  return (size_t)params->num_threads * BROTLI_PARALLEL_CHUNK_SIZE;
+}
+
+static BROTLI_BOOL CopyInputToParallelBuffer(BrotliEncoderState* s,
+                                             const size_t input_size,
+                                             const uint8_t* input_buffer) {
+  MemoryManager* m = &s->memory_manager_;
+  const size_t size =
+      s->parallel_history_ + s->parallel_pending_ + input_size;
+  /* Hashing might read up to 7 bytes past the end of the input. */
+  if (s->parallel_buf_size_ < size + 7) {
+    const size_t max_size = ParallelHistorySize(&s->params) +
+        ParallelBatchSize(&s->params) + 7;
+    size_t new_size = BROTLI_MAX(size_t, size + 7, 2 * s->parallel_buf_size_);
+    uint8_t* new_buf;
+    new_size = BROTLI_MIN(size_t, new_size, max_size);
+    new_buf = BROTLI_ALLOC(m, uint8_t, new_size);
+    if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(new_buf)) return BROTLI_FALSE;
+    if (s->parallel_buf_) {
+      memcpy(new_buf, s->parallel_buf_,
+             s->parallel_history_ + s->parallel_pending_);
+      BROTLI_FREE(m, s->parallel_buf_);
+    }
+    s->parallel_buf_ = new_buf;
+    s->parallel_buf_size_ = new_size;
+  }
+  memcpy(s->parallel_buf_ + size - input_size, input_buffer, input_size);
+  memset(s->parallel_buf_ + size, 0, 7);
+  s->parallel_pending_ += input_size;
+  return BROTLI_TRUE;
+}
+
+/* Creates the encoder of a chunk starting at |position| in the stream of |s|,
+   preceded by |history_size| bytes of input. Only the first chunk of a batch
+   carries on the bits left in |s|, i.e. the stream header. */
+static BrotliEncoderState* CreateParallelEncoder(BrotliEncoderState* s,
+    uint64_t position, size_t history_size, BROTLI_BOOL is_first) {
+  MemoryManager* m = &s->memory_manager_;
+  BrotliEncoderState* encoder =
+      BrotliEncoderCreateInstance(m->alloc_func, m->free_func, m->opaque);
+  uint64_t offset;
+  if (!encoder) return NULL;
+  encoder->params = s->params;
+  encoder->params.num_threads = 1;
+  /* Backward distances are limited by the position in the whole stream;
+     bigger offsets have the same effect as the window size. */
+  offset = s->params.stream_offset + position - history_size;
+  encoder->params.stream_offset =
+      offset < (1u << 30) ? (size_t)offset : (1u << 30);
+  if (!EnsureInitialized(encoder)) {
+    BrotliEncoderDestroyInstance(encoder);
+    return NULL;
+  }
+  encoder->last_bytes_ = is_first ? s->last_bytes_ : 0;
+  encoder->last_bytes_bits_ = is_first ? s->last_bytes_bits_ : 0;
+  if (position != 0) {
+    /* The distance cache of the decoder depends on the previous chunks. */
+    encoder->flint_ = BROTLI_FLINT_DONE;
+    encoder->dist_cache_[0] = -16;
+    encoder->dist_cache_[1] = -16;
+    encoder->dist_cache_[2] = -16;
+    encoder->dist_cache_[3] = -16;
+    memcpy(encoder->saved_dist_cache_, encoder->dist_cache_,
+           sizeof(encoder->saved_dist_cache_));
+  }
+  return encoder;
+}
+
+/* Makes the history preceding the chunk available to backward references, as
+   if it was compressed by the same encoder. */
+static void PrimeParallelEncoder(BrotliEncoderState* s, const uint8_t* data,
+                                 size_t history_size, size_t input_size) {
+  MemoryManager* m = &s->memory_manager_;
+  CopyInputToRingBuffer(s, history_size, data);
+  if (BROTLI_IS_OOM(m)) return;
+  s->last_flush_pos_ = history_size;
+  s->last_processed_pos_ = history_size;
+  s->prev_byte_ = data[history_size - 1];
+  if (history_size > 1) s->prev_byte2_ = data[history_size - 2];
+  HasherPrependHistory(m, &s->hasher_, &s->params, data, history_size,
+                       history_size + input_size);
+}
+
+static void RunParallelJob(void* arg) {
+  ParallelJob* job = (ParallelJob*)arg;
+  BrotliEncoderState* encoder = job->encoder;
+  MemoryManager* m = &encoder->memory_manager_;
+  size_t available_in = job->input_size;
+  const uint8_t* next_in = job->data + job->history_size;
+  job->result = BROTLI_FALSE;
+  if (job->history_size != 0) {
+    PrimeParallelEncoder(encoder, job->data, job->history_size,
+                         job->input_size);
+    if (BROTLI_IS_OOM(m)) return;
+  }
+  while (BROTLI_TRUE) {
+    size_t available_out;
+    uint8_t* next_out;
+    BROTLI_ENSURE_CAPACITY(m, uint8_t, job->output, job->output_capacity,
+        BROTLI_MAX(size_t, job->output_size + 1, (job->input_size >> 1) + 512));
+    if (BROTLI_IS_OOM(m)) return;
+    available_out = job->output_capacity - job->output_size;
+    next_out = job->output + job->output_size;
+    if (!BrotliEncoderCompressStream(encoder, job->op, &available_in,
+        &next_in, &available_out, &next_out, NULL)) {
+      return;
+    }
+    job->output_size = job->output_capacity - available_out;
+    if (available_in == 0 && !BrotliEncoderHasMoreOutput(encoder) &&
+        (job->op == BROTLI_OPERATION_FLUSH ||
+         BrotliEncoderIsFinished(encoder))) {
+      break;
+    }
+  }
+  job->result = BROTLI_TRUE;
+}
+
+/* Compresses the pending input on up to |num_threads| threads, and stitches
+   the flushed output of the chunks. */
+static BROTLI_BOOL CompressParallelBatch(BrotliEncoderState* s,
+                                         BROTLI_BOOL is_last) {
+  MemoryManager* m = &s->memory_manager_;
+  const size_t max_history = ParallelHistorySize(&s->params);
+  const size_t pending = s->parallel_pending_;
+  size_t num_jobs = BROTLI_MIN(size_t, (size_t)s->params.num_threads,
+      pending / BROTLI_MIN_PARALLEL_CHUNK_SIZE);
+  size_t chunk_size;
+  size_t output_size = 0;
+  BROTLI_BOOL result = BROTLI_TRUE;
+  ParallelJob* jobs;
+  size_t i;
+
+  if (num_jobs == 0) {
+    /* The last chunk might be empty. */
+    if (pending == 0 && !is_last) return BROTLI_TRUE;
+    num_jobs = 1;
+  }
+  chunk_size = (pending + num_jobs - 1) / num_jobs;
+  jobs = BROTLI_ALLOC(m, ParallelJob, num_jobs);
+  if (BROTLI_IS_OOM(m) || BROTLI_IS_NULL(jobs)) return BROTLI_FALSE;
+  for (i = 0; i < num_jobs; ++i) {
+    ParallelJob* job = &jobs[i];
+    const size_t offset = i * chunk_size;
+    const size_t start = s->parallel_history_ + offset;
+    job->input_size = BROTLI_MIN(size_t, chunk_size, pending - offset);
+    job->history_size =
+        job->input_size ? BROTLI_MIN(size_t, start, max_history) : 0;
+    job->data = s->parallel_buf_ + start - job->history_size;
+    job->op = (is_last && i + 1 == num_jobs) ?
+        BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH;
+    job->output = NULL;
+    job->output_size = 0;
+    job->output_capacity = 0;
+    job->result = BROTLI_FALSE;
+    job->encoder = CreateParallelEncoder(s, s->parallel_pos_ + offset,
+        job->history_size, TO_BROTLI_BOOL(i == 0));
+    if (!job->encoder) result = BROTLI_FALSE;
+  }
+
+  if (result) {
+    /* The calling thread compresses the first chunk. */
+    for (i = 1; i < num_jobs; ++i) {
+      BrotliThreadStart(&jobs[i].thread, RunParallelJob, &jobs[i]);
+    }
+    RunParallelJob(&jobs[0]);
+    for (i = 1; i < num_jobs; ++i) BrotliThreadJoin(&jobs[i].thread);
+    for (i = 0; i < num_jobs; ++i) {
+      if (!jobs[i].result) result = BROTLI_FALSE;
+      output_size += jobs[i].output_size;
+    }
+  }
+
+  if (result) {
+    uint8_t* storage = GetBrotliStorage(s, output_size);
+    if (BROTLI_IS_OOM(m)) {
+      result = BROTLI_FALSE;
+    } else {
+      s->next_out_ = storage;
+      s->available_out_ = output_size;
+      for (i = 0; i < num_jobs; ++i) {
+        memcpy(storage, jobs[i].output, jobs[i].output_size);
+        storage += jobs[i].output_size;
+      }
+      /* Output of every chunk is byte-aligned. */
+      s->last_bytes_ = 0;
+      s->last_bytes_bits_ = 0;
+    }
+  }
+
+  for (i = 0; i < num_jobs; ++i) {
+    if (!jobs[i].encoder) continue;
+    BROTLI_FREE(&jobs[i].encoder->memory_manager_, jobs[i].output);
+    BrotliEncoderDestroyInstance(jobs[i].encoder);
+  }
+  BROTLI_FREE(m, jobs);
+  if (!result) return BROTLI_FALSE;
+
+  /* Keep the window preceding the next batch. */
+  if (s->parallel_buf_) {
+    const size_t size = s->parallel_history_ + pending;
+    const size_t history = BROTLI_MIN(size_t, size, max_history);
+    memmove(s->parallel_buf_, s->parallel_buf_ + size - history, history);
+    s->parallel_history_ = history;
+  }
+  s->parallel_pos_ += pending;
+  s->parallel_pending_ = 0;
+  return BROTLI_TRUE;
+}
+
+static BROTLI_BOOL BrotliEncoderCompressStreamParallel(
+    BrotliEncoderState* s, BrotliEncoderOperation op, size_t* available_in,
+    const uint8_t** next_in, size_t* available_out, uint8_t** next_out,
+    size_t* total_out) {
+  const size_t batch_size = ParallelBatchSize(&s->params);
+  while (BROTLI_TRUE) {
+    size_t remaining_batch_size = batch_size - s->parallel_pending_;
+
+    if (remaining_batch_size != 0 && *available_in != 0) {
+      size_t copy_input_size =
+          BROTLI_MIN(size_t, remaining_batch_size, *available_in);
+      if (!CopyInputToParallelBuffer(s, copy_input_size, *next_in)) {
+        return BROTLI_FALSE;
+      }
+      *next_in += copy_input_size;
+      *available_in -= copy_input_size;
+      continue;
+    }
+
+    if (InjectFlushOrPushOutput(s, available_out, next_out, total_out)) {
+      continue;
+    }
+
+    /* Compress the batch only when internal output buffer is empty, stream is
+       not finished and there is no pending flush request. */
+    if (s->available_out_ == 0 &&
+        s->stream_state_ == BROTLI_STREAM_PROCESSING) {
+      if (remaining_batch_size == 0 || op != BROTLI_OPERATION_PROCESS) {
+        BROTLI_BOOL is_last = TO_BROTLI_BOOL(
+            (*available_in == 0) && op == BROTLI_OPERATION_FINISH);
+        BROTLI_BOOL force_flush = TO_BROTLI_BOOL(
+            (*available_in == 0) && op == BROTLI_OPERATION_FLUSH);
+        UpdateSizeHint(s, s->parallel_pending_ + *available_in);
+        if (!CompressParallelBatch(s, is_last)) return BROTLI_FALSE;
+        if (force_flush) s->stream_state_ = BROTLI_STREAM_FLUSH_REQUESTED;
+        if (is_last) s->stream_state_ = BROTLI_STREAM_FINISHED;
+        continue;
+      }
+    }
+    break;
+  }
+  CheckFlushComplete(s);
+  return BROTLI_TRUE;
+}
+
 static BROTLI_BOOL ProcessMetadata(
     BrotliEncoderState* s, size_t* available_in, const uint8_t** next_in,
     size_t* available_out, uint8_t** next_out, size_t* total_out) {
@@ -1738,6 +2063,11 @@ static BROTLI_BOOL ProcessMetadata(
     }
     if (s->available_out_ != 0) break;
 
+    if (s->parallel_pending_ != 0) {
+      if (!CompressParallelBatch(s, BROTLI_FALSE)) return BROTLI_FALSE;
+      continue;
+    }
+
     if (s->input_pos_ != s->last_flush_pos_) {
       BROTLI_BOOL result = EncodeData(s, BROTLI_FALSE, BROTLI_TRUE,
           &s->available_out_, &s->next_out_);
@@ -1786,21 +2116,6 @@ static BROTLI_BOOL ProcessMetadata(
   return BROTLI_TRUE;
 }
 
-static void UpdateSizeHint(BrotliEncoderState* s, size_t available_in) {
-  if (s->params.size_hint == 0) {
-    uint64_t delta = UnprocessedInputSize(s);
-    uint64_t tail = available_in;
-    uint32_t limit = 1u << 30;
-    uint32_t total;
-    if ((delta >= limit) || (tail >= limit) || ((delta + tail) >= limit)) {
-      total = limit;
-    } else {
-      total = (uint32_t)(delta + tail);
-    }
-    s->params.size_hint = total;
-  }
-}
-
 BROTLI_BOOL BrotliEncoderCompressStream(
     BrotliEncoderState* s, BrotliEncoderOperation op, size_t* available_in,
     const uint8_t** next_in, size_t* available_out,uint8_t** next_out,
@@ -1827,6 +2142,10 @@ BROTLI_BOOL BrotliEncoderCompressStream(
   if (s->stream_state_ != BROTLI_STREAM_PROCESSING && *available_in != 0) {
     return BROTLI_FALSE;
   }
+  if (s->params.num_threads > 1) {
+    return BrotliEncoderCompressStreamParallel(s, op, available_in, next_in,
+        available_out, next_out, total_out);
+  }
   if (s->params.quality == FAST_ONE_PASS_COMPRESSION_QUALITY ||
       s->params.quality == FAST_TWO_PASS_COMPRESSION_QUALITY) {
     return BrotliEncoderCompressStreamFast(s, op, available_in, next_in,
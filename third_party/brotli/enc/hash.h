@@ -462,6 +462,32 @@ static BROTLI_INLINE void HasherSetup(MemoryManager* m, Hasher* hasher,
   }
 }
 
+/* Sets up the hasher for |input_size| bytes at |data|, which start with
+   |history_size| bytes of already compressed input, and stores the positions
+   of the history so that backward references into it can be found.
+   The last positions are stored by StitchToPreviousBlock, once the bytes
+   following them are known. */
+static BROTLI_INLINE void HasherPrependHistory(MemoryManager* m,
+    Hasher* hasher, BrotliEncoderParams* params, const uint8_t* data,
+    size_t history_size, size_t input_size) {
+  size_t overlap;
+  size_t i;
+  HasherSetup(m, hasher, params, data, 0, input_size, BROTLI_TRUE);
+  if (BROTLI_IS_OOM(m)) return;
+  switch (hasher->common.params.type) {
+#define PREPEND_(N)                                                 \
+    case N:                                                         \
+      overlap = (StoreLookaheadH ## N()) - 1;                       \
+      for (i = 0; i + overlap < history_size; i++) {                \
+        StoreH ## N(&hasher->privat._H ## N, data, ~(size_t)0, i);  \
+      }                                                             \
+      break;
+    FOR_ALL_HASHERS(PREPEND_)
+#undef PREPEND_
+    default: break;
+  }
+}
+
 static BROTLI_INLINE void InitOrStitchToPreviousBlock(
     MemoryManager* m, Hasher* hasher, const uint8_t* data, size_t mask,
     BrotliEncoderParams* params, size_t position, size_t input_size,
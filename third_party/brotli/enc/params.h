@@ -36,6 +36,7 @@ typedef struct BrotliEncoderParams {
   int lgblock;
   size_t stream_offset;
   size_t size_hint;
+  int num_threads;
   BROTLI_BOOL disable_literal_context_modeling;
   BROTLI_BOOL large_window;
   BrotliHasherParams hasher;
@@ -0,0 +1,94 @@
+/* Copyright 2021 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Minimal portable threads, used to compress chunks of input in parallel. */
+
+#ifndef BROTLI_ENC_THREAD_H_
+#define BROTLI_ENC_THREAD_H_
+
+#include "../common/platform.h"
+#include <brotli/types.h>
+
+#if defined(BROTLI_ENCODER_NO_THREADS)
+/* Chunks are compressed one after another on the calling thread. */
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+typedef void (*BrotliThreadFunc)(void* arg);
+
+typedef struct BrotliThread {
+  BrotliThreadFunc func;
+  void* arg;
+#if defined(BROTLI_ENCODER_NO_THREADS)
+#elif defined(_WIN32)
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif
+} BrotliThread;
+
+#if defined(BROTLI_ENCODER_NO_THREADS)
+#elif defined(_WIN32)
+static DWORD WINAPI BrotliThreadMain(LPVOID arg) {
+  BrotliThread* thread = (BrotliThread*)arg;
+  thread->func(thread->arg);
+  return 0;
+}
+#else
+static void* BrotliThreadMain(void* arg) {
+  BrotliThread* thread = (BrotliThread*)arg;
+  thread->func(thread->arg);
+  return NULL;
+}
+#endif
+
+/* Runs |func(arg)| on a new thread. If the thread can not be started, runs it
+   on the calling thread before returning. |thread| must stay valid until
+   BrotliThreadJoin() returns. */
+static BROTLI_INLINE void BrotliThreadStart(
+    BrotliThread* thread, BrotliThreadFunc func, void* arg) {
+  BROTLI_BOOL started = BROTLI_FALSE;
+  thread->func = func;
+  thread->arg = arg;
+#if defined(BROTLI_ENCODER_NO_THREADS)
+#elif defined(_WIN32)
+  thread->handle = CreateThread(NULL, 0, BrotliThreadMain, thread, 0, NULL);
+  started = TO_BROTLI_BOOL(thread->handle != NULL);
+#else
+  started = TO_BROTLI_BOOL(
+      pthread_create(&thread->handle, NULL, BrotliThreadMain, thread) == 0);
+#endif
+  if (!started) {
+    thread->func = NULL;
+    func(arg);
+  }
+}
+
+/* Waits for the function started by BrotliThreadStart() to return. */
+static BROTLI_INLINE void BrotliThreadJoin(BrotliThread* thread) {
+  if (!thread->func) return;
+#if defined(BROTLI_ENCODER_NO_THREADS)
+#elif defined(_WIN32)
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+#else
+  pthread_join(thread->handle, NULL);
+#endif
+  thread->func = NULL;
+}
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}  /* extern "C" */
+#endif
+
+#endif  /* BROTLI_ENC_THREAD_H_ */
@@ -40,6 +40,8 @@ extern "C" {
 #define BROTLI_MIN_QUALITY 0
 /** Maximal value for ::BROTLI_PARAM_QUALITY parameter. */
 #define BROTLI_MAX_QUALITY 11
+/** Maximal value for ::BROTLI_PARAM_NUM_THREADS parameter. */
+#define BROTLI_MAX_NUM_THREADS 256
 
 /** Options for ::BROTLI_PARAM_MODE parameter. */
 typedef enum BrotliEncoderMode {
@@ -217,7 +219,30 @@ typedef enum BrotliEncoderParameter {
    * maximal window size have the same effect. Values greater than 2**30 are not
    * allowed.
    */
-  BROTLI_PARAM_STREAM_OFFSET = 9
+  BROTLI_PARAM_STREAM_OFFSET = 9,
+  /**
+   * Number of threads used by ::BrotliEncoderCompressStream.
+   *
+   * Input is split into chunks of up to 4 MiB, which are compressed in
+   * parallel, each by an encoder primed with the window of input preceding
+   * the chunk. The flushed output of the chunks is stitched into a single
+   * stream, which any decoder reads.
+   *
+   * As every chunk starts a new meta-block, output is slightly bigger than
+   * with a single thread: on text, by 0.1% to 0.4% for qualities 10 and 11,
+   * by 0.2% to 0.7% for qualities 5 to 9, and by less than 0.1% for qualities
+   * 2 to 4. Smaller chunks lose more.
+   *
+   * Input is buffered until there is a chunk for every thread, or until
+   * ::BROTLI_OPERATION_FLUSH or ::BROTLI_OPERATION_FINISH; then pending input
+   * is split evenly between the threads, in chunks of at least 64 KiB.
+   * Every thread needs about as much memory as a single-threaded encoder.
+   * Custom memory allocators have to be thread-safe.
+   *
+   * The default value is 1. Values greater than ::BROTLI_MAX_NUM_THREADS
+   * are not allowed.
+   */
+  BROTLI_PARAM_NUM_THREADS = 10
 } BrotliEncoderParameter;
 
 /**
@@ -274,7 +299,8 @@ BROTLI_ENC_API void BrotliEncoderDestroyInstance(BrotliEncoderState* state);
  *
  * @warning Result is only valid if quality is at least @c 2 and, in
  *          case ::BrotliEncoderCompressStream was used, no flushes
- *          (::BROTLI_OPERATION_FLUSH) were performed.
+ *          (::BROTLI_OPERATION_FLUSH) were performed and
+ *          ::BROTLI_PARAM_NUM_THREADS was not set.
  *
  * @param input_size size of projected input
  * @returns @c 0 if result does not fit @c size_t
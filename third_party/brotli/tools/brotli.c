@@ -91,6 +91,7 @@ typedef struct {
   /* Parameters */
   int quality;
   int lgwin;
+  int num_threads;
   int verbosity;
   BROTLI_BOOL force_overwrite;
   BROTLI_BOOL junk_source;
@@ -132,6 +133,7 @@ typedef struct {
      until 4GiB+ files are compressed / decompressed on 32-bit CPUs. */
   size_t total_in;
   size_t total_out;
+  double start_time;
 } Context;
 
 /* Parse up to 5 decimal digits. */
@@ -188,6 +190,7 @@ static Command ParseParams(Context* params) {
   BROTLI_BOOL keep_set = BROTLI_FALSE;
   BROTLI_BOOL lgwin_set = BROTLI_FALSE;
   BROTLI_BOOL suffix_set = BROTLI_FALSE;
+  BROTLI_BOOL threads_set = BROTLI_FALSE;
   BROTLI_BOOL after_dash_dash = BROTLI_FALSE;
   Command command = ParseAlias(argv[0]);
 
@@ -203,7 +206,8 @@ static Command ParseParams(Context* params) {
     }
 
     /* Too many options. The expected longest option list is:
-       "-q 0 -w 10 -o f -D d -S b -d -f -k -n -v --", i.e. 16 items in total.
+       "-q 0 -w 10 -T 2 -o f -D d -S b -d -f -k -n -v --", i.e. 18 items in
+       total.
        This check is an additional guard that is never triggered, but provides
        a guard for future changes. */
     if (next_option_index > (MAX_OPTIONS - 2)) {
@@ -308,8 +312,9 @@ static Command ParseParams(Context* params) {
           params->quality = 11;
           continue;
         }
-        /* o/q/w/D/S with parameter is expected */
-        if (c != 'o' && c != 'q' && c != 'w' && c != 'D' && c != 'S') {
+        /* o/q/w/D/S/T with parameter is expected */
+        if (c != 'o' && c != 'q' && c != 'w' && c != 'D' && c != 'S' &&
+            c != 'T') {
           fprintf(stderr, "invalid argument -%c\n", c);
           return COMMAND_INVALID;
         }
@@ -364,6 +369,17 @@ static Command ParseParams(Context* params) {
           }
           suffix_set = BROTLI_TRUE;
           params->suffix = argv[i];
+        } else if (c == 'T') {
+          if (threads_set) {
+            fprintf(stderr, "number of threads already set\n");
+            return COMMAND_INVALID;
+          }
+          threads_set = ParseInt(argv[i], 1,
+                                 BROTLI_MAX_NUM_THREADS, &params->num_threads);
+          if (!threads_set) {
+            fprintf(stderr, "error parsing threads value [%s]\n", argv[i]);
+            return COMMAND_INVALID;
+          }
         }
       }
     } else {  /* Double-dash. */
@@ -504,6 +520,17 @@ static Command ParseParams(Context* params) {
           }
           suffix_set = BROTLI_TRUE;
           params->suffix = value;
+        } else if (strncmp("threads", arg, key_len) == 0) {
+          if (threads_set) {
+            fprintf(stderr, "number of threads already set\n");
+            return COMMAND_INVALID;
+          }
+          threads_set = ParseInt(value, 1,
+                                 BROTLI_MAX_NUM_THREADS, &params->num_threads);
+          if (!threads_set) {
+            fprintf(stderr, "error parsing threads value [%s]\n", value);
+            return COMMAND_INVALID;
+          }
         } else {
           fprintf(stderr, "invalid parameter: [%s]\n", arg);
           return COMMAND_INVALID;
@@ -576,6 +603,9 @@ static void PrintHelp(const char* name, BROTLI_BOOL error) {
 "  -S SUF, --suffix=SUF        output file suffix (default:'%s')\n",
           DEFAULT_SUFFIX);
   fprintf(media,
+"  -T NUM, --threads=NUM       compress with NUM threads (1-%d)\n",
+          BROTLI_MAX_NUM_THREADS);
+  fprintf(media,
 "  -V, --version               display version and exit\n"
 "  -Z, --best                  use best compression level (11) (default)\n"
 "Simple options could be coalesced, i.e. '-9kf' is equivalent to '-9 -k -f'.\n"
@@ -799,7 +829,19 @@ static BROTLI_BOOL CloseFiles(Context* context, BROTLI_BOOL success) {
 
 static const size_t kFileBufferSize = 1 << 19;
 
+/* Returns wall-clock time in seconds. */
+static double Now(void) {
+#if defined(_WIN32)
+  return (double)clock() / CLOCKS_PER_SEC;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
 static void InitializeBuffers(Context* context) {
+  context->start_time = Now();
   context->available_in = 0;
   context->next_in = NULL;
   context->available_out = kFileBufferSize;
@@ -875,6 +917,20 @@ static void PrintFileProcessingProgress(Context* context) {
   PrintBytes(context->total_out);
 }
 
+/* Reports compression speed, and its share per thread to compare how it
+   scales with the number of threads. */
+static void PrintThroughput(Context* context) {
+  double elapsed = Now() - context->start_time;
+  double speed;
+  if (elapsed <= 0.0) return;
+  speed = (double)context->total_in / 1048576.0 / elapsed;
+  fprintf(stderr, " in %0.3f s, %0.3f MiB/s", elapsed, speed);
+  if (context->num_threads > 1) {
+    fprintf(stderr, " with %d threads, %0.3f MiB/s per thread",
+            context->num_threads, speed / context->num_threads);
+  }
+}
+
 static BROTLI_BOOL DecompressFile(Context* context, BrotliDecoderState* s) {
   BrotliDecoderResult result = BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT;
   InitializeBuffers(context);
@@ -968,6 +1024,7 @@ static BROTLI_BOOL CompressFile(Context* context, BrotliEncoderState* s) {
       if (context->verbosity > 0) {
         fprintf(stderr, "Compressed ");
         PrintFileProcessingProgress(context);
+        PrintThroughput(context);
         fprintf(stderr, "\n");
       }
       return BROTLI_TRUE;
@@ -1007,6 +1064,10 @@ static BROTLI_BOOL CompressFiles(Context* context) {
       }
       BrotliEncoderSetParameter(s, BROTLI_PARAM_LGWIN, lgwin);
     }
+    if (context->num_threads > 1) {
+      BrotliEncoderSetParameter(s,
+          BROTLI_PARAM_NUM_THREADS, (uint32_t)context->num_threads);
+    }
     if (context->input_file_length > 0) {
       uint32_t size_hint = context->input_file_length < (1 << 30) ?
           (uint32_t)context->input_file_length : (1u << 30);
@@ -1034,6 +1095,7 @@ int main(int argc, char** argv) {
 
   context.quality = 11;
   context.lgwin = -1;
+  context.num_threads = 1;
   context.verbosity = 0;
   context.force_overwrite = BROTLI_FALSE;
   context.junk_source = BROTLI_FALSE;
@@ -512,6 +512,53 @@ static int ProgressReport(int percent, const WebPPicture* const picture) {
   return 1;  // all ok
 }
 
+// Encodes 'picture' losslessly with 1 to 'max_threads' threads, and prints the
+// throughput of each run and its size compared to the single-threaded one.
+static int BenchmarkThreads(const WebPConfig* const config,
+                            const WebPPicture* const picture,
+                            int max_threads) {
+  const double mpix = 1e-6 * picture->width * picture->height;
+  double time_ref = 0.;
+  size_t size_ref = 0;
+  int num_threads;
+  fprintf(stderr, "threads  time (s)    MPix/s  speed-up        size   delta\n");
+  for (num_threads = 1; num_threads <= max_threads; ++num_threads) {
+    WebPConfig bench_config = *config;
+    WebPPicture bench_picture = *picture;
+    WebPMemoryWriter writer;
+    Stopwatch stop_watch;
+    double time;
+    int ok;
+    // Shallow copy of 'picture', encoded to memory.
+    bench_picture.memory_ = bench_picture.memory_argb_ = NULL;
+    bench_picture.writer = WebPMemoryWrite;
+    bench_picture.custom_ptr = (void*)&writer;
+    bench_picture.stats = NULL;
+    bench_picture.progress_hook = NULL;
+    bench_config.thread_level = (num_threads > 1) ? num_threads : 0;
+    WebPMemoryWriterInit(&writer);
+    StopwatchReset(&stop_watch);
+    ok = WebPEncode(&bench_config, &bench_picture);
+    time = StopwatchReadAndReset(&stop_watch);
+    if (!ok) {
+      fprintf(stderr, "Error! Cannot encode picture with %d threads\n",
+              num_threads);
+      WebPMemoryWriterClear(&writer);
+      return 0;
+    }
+    if (num_threads == 1) {
+      time_ref = time;
+      size_ref = writer.size;
+    }
+    fprintf(stderr, "%7d %9.3f %9.2f %8.2fx %11d %+6.2f%%\n",
+            num_threads, time, (time > 0.) ? mpix / time : 0.,
+            (time > 0.) ? time_ref / time : 0., (int)writer.size,
+            100. * ((double)writer.size - size_ref) / size_ref);
+    WebPMemoryWriterClear(&writer);
+  }
+  return 1;
+}
+
 //------------------------------------------------------------------------------
 
 static void HelpShort(void) {
@@ -573,6 +620,10 @@ static void HelpLong(void) {
   printf("  -crop <x> <y> <w> <h> .. crop picture with the given rectangle\n");
   printf("  -resize <w> <h> ........ resize picture (after any cropping)\n");
   printf("  -mt .................... use multi-threading if available\n");
+  printf("  -threads <int> ......... number of threads for lossless encoding"
+         " (1..64)\n");
+  printf("  -mt_bench <int> ........ time lossless encoding with 1 to <int>"
+         " threads\n");
   printf("  -low_memory ............ reduce memory usage (slower encoding)\n");
   printf("  -map <int> ............. print map of extra info\n");
   printf("  -print_psnr ............ prints averaged PSNR distortion\n");
@@ -661,6 +712,7 @@ int main(int argc, const char* argv[]) {
   int lossless_preset = 6;
   int use_lossless_preset = -1;  // -1=unset, 0=don't use, 1=use it
   int show_progress = 0;
+  int mt_bench = 0;
   int keep_metadata = 0;
   int metadata_written = 0;
   WebPPicture picture;
@@ -791,6 +843,16 @@ int main(int argc, const char* argv[]) {
       config.emulate_jpeg_size = 1;
     } else if (!strcmp(argv[c], "-mt")) {
       ++config.thread_level;  // increase thread level
+    } else if (!strcmp(argv[c], "-threads") && c + 1 < argc) {
+      const int num_threads = ExUtilGetInt(argv[++c], 0, &parse_error);
+      if (num_threads < 1 || num_threads > 64) {
+        fprintf(stderr, "Error! -threads must be in the range [1..64]\n");
+        parse_error = 1;
+      }
+      // A thread_level of 1 runs a side thread, so one thread maps to 0.
+      config.thread_level = (num_threads > 1) ? num_threads : 0;
+    } else if (!strcmp(argv[c], "-mt_bench") && c + 1 < argc) {
+      mt_bench = ExUtilGetInt(argv[++c], 0, &parse_error);
     } else if (!strcmp(argv[c], "-low_memory")) {
       config.low_memory = 1;
     } else if (!strcmp(argv[c], "-strong")) {
@@ -949,6 +1011,12 @@ int main(int argc, const char* argv[]) {
                       " encoding. Ignoring this option!\n");
     }
   }
+  if (mt_bench > 0 && !config.lossless) {
+    fprintf(stderr, "Threads benchmark is only supported for lossless"
+                    " encoding. Ignoring this option!\n");
+    mt_bench = 0;
+  }
+  if (mt_bench > 64) mt_bench = 64;
   // If a target size or PSNR was given, but somehow the -pass option was
   // omitted, force a reasonable value.
   if (config.target_size > 0 || config.target_PSNR > 0) {
@@ -1106,6 +1174,10 @@ int main(int argc, const char* argv[]) {
     goto Error;
   }
 
+  if (mt_bench > 0 && !BenchmarkThreads(&config, &picture, mt_bench)) {
+    goto Error;
+  }
+
   // Compress.
   if (verbose) {
     StopwatchReset(&stop_watch);
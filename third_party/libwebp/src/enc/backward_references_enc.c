@@ -33,6 +33,9 @@
 // distance + length instead of each pixel as a literal.
 #define MIN_LENGTH 4
 
+// Minimum number of pixels in a region of the hash chain searched by one job.
+#define MIN_HASH_CHAIN_REGION_SIZE (1 << 16)
+
 // -----------------------------------------------------------------------------
 
 static const uint8_t plane_to_code_lut[128] = {
@@ -253,92 +256,40 @@ static WEBP_INLINE int MaxFindCopyLength(int len) {
   return (len < MAX_LENGTH) ? len : MAX_LENGTH;
 }
 
-int VP8LHashChainFill(VP8LHashChain* const p, int quality,
-                      const uint32_t* const argb, int xsize, int ysize,
-                      int low_effort) {
-  const int size = xsize * ysize;
-  const int iter_max = GetMaxItersForQuality(quality);
-  const uint32_t window_size = GetWindowSizeForHashChain(quality, xsize);
-  int pos;
-  int argb_comp;
+// Range of pixels [start_, end_) for which to find the best match interval.
+typedef struct {
+  uint32_t* offset_length_;  // output
+  const int32_t* chain_;     // pixels linked by hash, may alias offset_length_
+  const uint32_t* argb_;
+  int xsize_;
+  int size_;
+  int iter_max_;
+  uint32_t window_size_;
+  int low_effort_;
+  uint32_t start_;
+  uint32_t end_;
+} HashChainJob;
+
+// Finds the best match interval at each pixel of the job's range, going from
+// right to left. The chain is only read to the left of the pixel being
+// written, hence it can be stored in the output array itself.
+static int HashChainFindMatches(void* arg1, void* arg2) {
+  const HashChainJob* const job = (const HashChainJob*)arg1;
+  uint32_t* const offset_length = job->offset_length_;
+  const int32_t* const chain = job->chain_;
+  const uint32_t* const argb = job->argb_;
+  const int xsize = job->xsize_;
+  const int size = job->size_;
+  const uint32_t window_size = job->window_size_;
+  const uint32_t start = job->start_;
   uint32_t base_position;
-  int32_t* hash_to_first_index;
-  // Temporarily use the p->offset_length_ as a hash chain.
-  int32_t* chain = (int32_t*)p->offset_length_;
-  assert(size > 0);
-  assert(p->size_ != 0);
-  assert(p->offset_length_ != NULL);
-
-  if (size <= 2) {
-    p->offset_length_[0] = p->offset_length_[size - 1] = 0;
-    return 1;
-  }
-
-  hash_to_first_index =
-      (int32_t*)WebPSafeMalloc(HASH_SIZE, sizeof(*hash_to_first_index));
-  if (hash_to_first_index == NULL) return 0;
-
-  // Set the int32_t array to -1.
-  memset(hash_to_first_index, 0xff, HASH_SIZE * sizeof(*hash_to_first_index));
-  // Fill the chain linking pixels with the same hash.
-  argb_comp = (argb[0] == argb[1]);
-  for (pos = 0; pos < size - 2;) {
-    uint32_t hash_code;
-    const int argb_comp_next = (argb[pos + 1] == argb[pos + 2]);
-    if (argb_comp && argb_comp_next) {
-      // Consecutive pixels with the same color will share the same hash.
-      // We therefore use a different hash: the color and its repetition
-      // length.
-      uint32_t tmp[2];
-      uint32_t len = 1;
-      tmp[0] = argb[pos];
-      // Figure out how far the pixels are the same.
-      // The last pixel has a different 64 bit hash, as its next pixel does
-      // not have the same color, so we just need to get to the last pixel equal
-      // to its follower.
-      while (pos + (int)len + 2 < size && argb[pos + len + 2] == argb[pos]) {
-        ++len;
-      }
-      if (len > MAX_LENGTH) {
-        // Skip the pixels that match for distance=1 and length>MAX_LENGTH
-        // because they are linked to their predecessor and we automatically
-        // check that in the main for loop below. Skipping means setting no
-        // predecessor in the chain, hence -1.
-        memset(chain + pos, 0xff, (len - MAX_LENGTH) * sizeof(*chain));
-        pos += len - MAX_LENGTH;
-        len = MAX_LENGTH;
-      }
-      // Process the rest of the hash chain.
-      while (len) {
-        tmp[1] = len--;
-        hash_code = GetPixPairHash64(tmp);
-        chain[pos] = hash_to_first_index[hash_code];
-        hash_to_first_index[hash_code] = pos++;
-      }
-      argb_comp = 0;
-    } else {
-      // Just move one pixel forward.
-      hash_code = GetPixPairHash64(argb + pos);
-      chain[pos] = hash_to_first_index[hash_code];
-      hash_to_first_index[hash_code] = pos++;
-      argb_comp = argb_comp_next;
-    }
-  }
-  // Process the penultimate pixel.
-  chain[pos] = hash_to_first_index[GetPixPairHash64(argb + pos)];
-
-  WebPSafeFree(hash_to_first_index);
+  (void)arg2;
+  assert(start > 0);
 
-  // Find the best match interval at each pixel, defined by an offset to the
-  // pixel and a length. The right-most pixel cannot match anything to the right
-  // (hence a best length of 0) and the left-most pixel nothing to the left
-  // (hence an offset of 0).
-  assert(size > 2);
-  p->offset_length_[0] = p->offset_length_[size - 1] = 0;
-  for (base_position = size - 2; base_position > 0;) {
+  for (base_position = job->end_ - 1; base_position >= start;) {
     const int max_len = MaxFindCopyLength(size - 1 - base_position);
     const uint32_t* const argb_start = argb + base_position;
-    int iter = iter_max;
+    int iter = job->iter_max_;
     int best_length = 0;
     uint32_t best_distance = 0;
     uint32_t best_argb;
@@ -346,9 +297,10 @@ int VP8LHashChainFill(VP8LHashChain* const p, int quality,
         (base_position > window_size) ? base_position - window_size : 0;
     const int length_max = (max_len < 256) ? max_len : 256;
     uint32_t max_base_position;
+    int pos;
 
     pos = chain[base_position];
-    if (!low_effort) {
+    if (!job->low_effort_) {
       int curr_length;
       // Heuristic: use the comparison with the above line as an initialization.
       if (base_position >= (uint32_t)xsize) {
@@ -394,11 +346,11 @@ int VP8LHashChainFill(VP8LHashChain* const p, int quality,
     while (1) {
       assert(best_length <= MAX_LENGTH);
       assert(best_distance <= WINDOW_SIZE);
-      p->offset_length_[base_position] =
+      offset_length[base_position] =
           (best_distance << MAX_LENGTH_BITS) | (uint32_t)best_length;
       --base_position;
       // Stop if we don't have a match or if we are out of bounds.
-      if (best_distance == 0 || base_position == 0) break;
+      if (best_distance == 0 || base_position < start) break;
       // Stop if we cannot extend the matching intervals to the left.
       if (base_position < best_distance ||
           argb[base_position - best_distance] != argb[base_position]) {
@@ -421,6 +373,121 @@ int VP8LHashChainFill(VP8LHashChain* const p, int quality,
   return 1;
 }
 
+int VP8LHashChainFill(VP8LHashChain* const p, int quality,
+                      const uint32_t* const argb, int xsize, int ysize,
+                      int low_effort, VP8LWorkerPool* const pool) {
+  const int size = xsize * ysize;
+  const int iter_max = GetMaxItersForQuality(quality);
+  const uint32_t window_size = GetWindowSizeForHashChain(quality, xsize);
+  const int max_regions = size / MIN_HASH_CHAIN_REGION_SIZE;
+  const int num_regions = (VP8LWorkerPoolSize(pool) < max_regions) ?
+      VP8LWorkerPoolSize(pool) : (max_regions > 1) ? max_regions : 1;
+  HashChainJob jobs[MAX_WORKER_POOL_SIZE];
+  int pos;
+  int argb_comp;
+  int i;
+  int32_t* hash_to_first_index;
+  // Unless the regions are searched in parallel, temporarily use the
+  // p->offset_length_ as a hash chain.
+  int32_t* chain;
+  assert(size > 0);
+  assert(p->size_ != 0);
+  assert(p->offset_length_ != NULL);
+
+  if (size <= 2) {
+    p->offset_length_[0] = p->offset_length_[size - 1] = 0;
+    return 1;
+  }
+
+  hash_to_first_index =
+      (int32_t*)WebPSafeMalloc(HASH_SIZE, sizeof(*hash_to_first_index));
+  if (hash_to_first_index == NULL) return 0;
+  if (num_regions > 1) {
+    chain = (int32_t*)WebPSafeMalloc(size, sizeof(*chain));
+    if (chain == NULL) {
+      WebPSafeFree(hash_to_first_index);
+      return 0;
+    }
+  } else {
+    chain = (int32_t*)p->offset_length_;
+  }
+
+  // Set the int32_t array to -1.
+  memset(hash_to_first_index, 0xff, HASH_SIZE * sizeof(*hash_to_first_index));
+  // Fill the chain linking pixels with the same hash.
+  argb_comp = (argb[0] == argb[1]);
+  for (pos = 0; pos < size - 2;) {
+    uint32_t hash_code;
+    const int argb_comp_next = (argb[pos + 1] == argb[pos + 2]);
+    if (argb_comp && argb_comp_next) {
+      // Consecutive pixels with the same color will share the same hash.
+      // We therefore use a different hash: the color and its repetition
+      // length.
+      uint32_t tmp[2];
+      uint32_t len = 1;
+      tmp[0] = argb[pos];
+      // Figure out how far the pixels are the same.
+      // The last pixel has a different 64 bit hash, as its next pixel does
+      // not have the same color, so we just need to get to the last pixel equal
+      // to its follower.
+      while (pos + (int)len + 2 < size && argb[pos + len + 2] == argb[pos]) {
+        ++len;
+      }
+      if (len > MAX_LENGTH) {
+        // Skip the pixels that match for distance=1 and length>MAX_LENGTH
+        // because they are linked to their predecessor and we automatically
+        // check that in the main for loop below. Skipping means setting no
+        // predecessor in the chain, hence -1.
+        memset(chain + pos, 0xff, (len - MAX_LENGTH) * sizeof(*chain));
+        pos += len - MAX_LENGTH;
+        len = MAX_LENGTH;
+      }
+      // Process the rest of the hash chain.
+      while (len) {
+        tmp[1] = len--;
+        hash_code = GetPixPairHash64(tmp);
+        chain[pos] = hash_to_first_index[hash_code];
+        hash_to_first_index[hash_code] = pos++;
+      }
+      argb_comp = 0;
+    } else {
+      // Just move one pixel forward.
+      hash_code = GetPixPairHash64(argb + pos);
+      chain[pos] = hash_to_first_index[hash_code];
+      hash_to_first_index[hash_code] = pos++;
+      argb_comp = argb_comp_next;
+    }
+  }
+  // Process the penultimate pixel.
+  chain[pos] = hash_to_first_index[GetPixPairHash64(argb + pos)];
+
+  WebPSafeFree(hash_to_first_index);
+
+  // Find the best match interval at each pixel, defined by an offset to the
+  // pixel and a length. The right-most pixel cannot match anything to the right
+  // (hence a best length of 0) and the left-most pixel nothing to the left
+  // (hence an offset of 0).
+  assert(size > 2);
+  for (i = 0; i < num_regions; ++i) {
+    HashChainJob* const job = &jobs[i];
+    job->offset_length_ = p->offset_length_;
+    job->chain_ = chain;
+    job->argb_ = argb;
+    job->xsize_ = xsize;
+    job->size_ = size;
+    job->iter_max_ = iter_max;
+    job->window_size_ = window_size;
+    job->low_effort_ = low_effort;
+    job->start_ = 1 + (uint32_t)((uint64_t)(size - 2) * i / num_regions);
+    job->end_ = 1 + (uint32_t)((uint64_t)(size - 2) * (i + 1) / num_regions);
+  }
+  VP8LWorkerPoolRun(pool, HashChainFindMatches, jobs, sizeof(jobs[0]),
+                    num_regions, NULL);
+  if (num_regions > 1) WebPSafeFree(chain);
+  p->offset_length_[0] = p->offset_length_[size - 1] = 0;
+  return 1;
+}
+
 static WEBP_INLINE void AddSingleLiteral(uint32_t pixel, int use_color_cache,
                                          VP8LColorCache* const hashers,
                                          VP8LBackwardRefs* const refs) {
@@ -15,6 +15,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include "src/enc/worker_pool_enc.h"
 #include "src/webp/types.h"
 #include "src/webp/encode.h"
 #include "src/webp/format_constants.h"
@@ -134,10 +135,12 @@ struct VP8LHashChain {
 
 // Must be called first, to set size.
 int VP8LHashChainInit(VP8LHashChain* const p, int size);
-// Pre-compute the best matches for argb.
+// Pre-compute the best matches for argb. Large images are split into regions
+// searched in parallel by 'pool' (which may be NULL): a match found in one
+// region is then not extended to the left into the previous one.
 int VP8LHashChainFill(VP8LHashChain* const p, int quality,
                       const uint32_t* const argb, int xsize, int ysize,
-                      int low_effort);
+                      int low_effort, VP8LWorkerPool* const pool);
 void VP8LHashChainClear(VP8LHashChain* const p);  // release memory
 
 static WEBP_INLINE int VP8LHashChainFindOffset(const VP8LHashChain* const p,
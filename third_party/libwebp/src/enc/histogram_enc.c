@@ -30,6 +30,8 @@
 #define BIN_SIZE (NUM_PARTITIONS * NUM_PARTITIONS * NUM_PARTITIONS)
 // Maximum number of histograms allowed in greedy combining algorithm.
 #define MAX_HISTO_GREEDY 100
+// Number of random pairs each thread evaluates at once in stochastic combining.
+#define STOCHASTIC_PAIRS_PER_THREAD 16
 
 static void HistogramClear(VP8LHistogram* const p) {
   uint32_t* const literal = p->literal_;
@@ -830,6 +832,22 @@ static double HistoQueuePush(HistoQueue* const histo_queue,
   return pair.cost_diff;
 }
 
+// Histograms and threshold shared by the pairs evaluated at the same time.
+typedef struct {
+  VP8LHistogram** histograms_;
+  double threshold_;
+} HistoPairsContext;
+
+// Worker hook updating the costs of a pair with HistoQueueUpdatePair().
+static int HistoQueueEvaluatePair(void* arg1, void* arg2) {
+  HistogramPair* const pair = (HistogramPair*)arg1;
+  const HistoPairsContext* const context = (const HistoPairsContext*)arg2;
+  HistoQueueUpdatePair(context->histograms_[pair->idx1],
+                       context->histograms_[pair->idx2], context->threshold_,
+                       pair);
+  return 1;
+}
+
 // -----------------------------------------------------------------------------
 
 // Combines histograms by continuously choosing the one with the highest cost
@@ -905,9 +923,13 @@ static int PairComparison(const void* idx1, const void* idx2) {
   // To be used with bsearch: <0 when *idx1<*idx2, >0 if >, 0 when ==.
   return (*(int*) idx1 - *(int*) idx2);
 }
+// The random pairs are drawn in batches and evaluated over the threads of
+// 'pool', then pushed to the queue in the order they were drawn. The result is
+// the same as evaluating them one after the other.
 static int HistogramCombineStochastic(VP8LHistogramSet* const image_histo,
                                       int* const num_used, int min_cluster_size,
-                                      int* const do_greedy) {
+                                      int* const do_greedy,
+                                      VP8LWorkerPool* const pool) {
   int j, iter;
   uint32_t seed = 1;
   int tries_with_no_success = 0;
@@ -923,6 +945,12 @@ static int HistogramCombineStochastic(VP8LHistogramSet* const image_histo,
   // mapping from an index in image_histo with no NULL histogram to the full
   // blown image_histo.
   int* mappings;
+  // Batch of random pairs, and the seed after each of them was drawn.
+  const int batch_size = (VP8LWorkerPoolSize(pool) > 1)
+      ? VP8LWorkerPoolSize(pool) * STOCHASTIC_PAIRS_PER_THREAD : 1;
+  HistogramPair* pairs = NULL;
+  uint32_t* seeds = NULL;
+  HistoPairsContext context;
 
   if (*num_used < min_cluster_size) {
     *do_greedy = 1;
@@ -931,6 +959,10 @@ static int HistogramCombineStochastic(VP8LHistogramSet* const image_histo,
 
   mappings = (int*) WebPSafeMalloc(*num_used, sizeof(*mappings));
   if (mappings == NULL) return 0;
+  pairs = (HistogramPair*)WebPSafeMalloc(batch_size, sizeof(*pairs));
+  seeds = (uint32_t*)WebPSafeMalloc(batch_size, sizeof(*seeds));
+  if (pairs == NULL || seeds == NULL) goto End;
+  context.histograms_ = histograms;
   if (!HistoQueueInit(&histo_queue, kHistoQueueSize)) goto End;
   // Fill the initial mapping.
   for (j = 0, iter = 0; iter < image_histo->size; ++iter) {
@@ -954,23 +986,43 @@ static int HistogramCombineStochastic(VP8LHistogramSet* const image_histo,
     const int num_tries = (*num_used) / 2;
 
     // Pick random samples.
-    for (j = 0; *num_used >= 2 && j < num_tries; ++j) {
-      double curr_cost;
-      // Choose two different histograms at random and try to combine them.
-      const uint32_t tmp = MyRand(&seed) % rand_range;
-      uint32_t idx1 = tmp / (*num_used - 1);
-      uint32_t idx2 = tmp % (*num_used - 1);
-      if (idx2 >= idx1) ++idx2;
-      idx1 = mappings[idx1];
-      idx2 = mappings[idx2];
-
-      // Calculate cost reduction on combination.
-      curr_cost =
-          HistoQueuePush(&histo_queue, histograms, idx1, idx2, best_cost);
-      if (curr_cost < 0) {  // found a better pair?
-        best_cost = curr_cost;
-        // Empty the queue if we reached full capacity.
-        if (histo_queue.size == histo_queue.max_size) break;
+    for (j = 0; *num_used >= 2 && j < num_tries; j += batch_size) {
+      const int num_pairs =
+          (num_tries - j < batch_size) ? num_tries - j : batch_size;
+      int k;
+      for (k = 0; k < num_pairs; ++k) {
+        // Choose two different histograms at random and try to combine them.
+        const uint32_t tmp = MyRand(&seed) % rand_range;
+        uint32_t idx1 = tmp / (*num_used - 1);
+        uint32_t idx2 = tmp % (*num_used - 1);
+        if (idx2 >= idx1) ++idx2;
+        idx1 = mappings[idx1];
+        idx2 = mappings[idx2];
+        pairs[k].idx1 = (idx1 < idx2) ? idx1 : idx2;
+        pairs[k].idx2 = (idx1 < idx2) ? idx2 : idx1;
+        seeds[k] = seed;
+      }
+
+      // Calculate cost reduction on combination. A pair beating the current
+      // best cost also beats the one at the start of the batch, so its cost
+      // is fully computed.
+      context.threshold_ = best_cost;
+      VP8LWorkerPoolRun(pool, HistoQueueEvaluatePair, pairs, sizeof(*pairs),
+                        num_pairs, &context);
+      for (k = 0; k < num_pairs; ++k) {
+        if (pairs[k].cost_diff < best_cost) {  // found a better pair?
+          histo_queue.queue[histo_queue.size++] = pairs[k];
+          HistoQueueUpdateHead(&histo_queue,
+                               &histo_queue.queue[histo_queue.size - 1]);
+          best_cost = pairs[k].cost_diff;
+          // Empty the queue if we reached full capacity.
+          if (histo_queue.size == histo_queue.max_size) break;
+        }
+      }
+      if (k < num_pairs) {
+        // Forget the pairs drawn after the queue got full.
+        seed = seeds[k];
+        break;
       }
     }
     if (histo_queue.size == 0) continue;
@@ -1037,42 +1089,79 @@ static int HistogramCombineStochastic(VP8LHistogramSet* const image_histo,
 End:
   HistoQueueClear(&histo_queue);
   WebPSafeFree(mappings);
+  WebPSafeFree(pairs);
+  WebPSafeFree(seeds);
   return ok;
 }
 
 // -----------------------------------------------------------------------------
 // Histogram refinement
 
-// Find the best 'out' histogram for each of the 'in' histograms.
+// Range [start_, end_) of 'in' histograms to map to the 'out' ones.
+typedef struct {
+  const VP8LHistogramSet* in_;
+  const VP8LHistogramSet* out_;
+  int start_;
+  int end_;
+  uint16_t* symbols_;
+} RemapJob;
+
+static int HistogramRemapRange(void* arg1, void* arg2) {
+  const RemapJob* const job = (const RemapJob*)arg1;
+  VP8LHistogram** const in_histo = job->in_->histograms;
+  VP8LHistogram** const out_histo = job->out_->histograms;
+  const int out_size = job->out_->size;
+  int i;
+  (void)arg2;
+  for (i = job->start_; i < job->end_; ++i) {
+    int best_out = 0;
+    double best_bits = MAX_COST;
+    int k;
+    if (in_histo[i] == NULL) continue;
+    for (k = 0; k < out_size; ++k) {
+      double cur_bits;
+      cur_bits = HistogramAddThresh(out_histo[k], in_histo[i], best_bits);
+      if (k == 0 || cur_bits < best_bits) {
+        best_bits = cur_bits;
+        best_out = k;
+      }
+    }
+    job->symbols_[i] = best_out;
+  }
+  return 1;
+}
+
+// Find the best 'out' histogram for each of the 'in' histograms, sharing them
+// between the threads of 'pool'.
 // At call-time, 'out' contains the histograms of the clusters.
 // Note: we assume that out[]->bit_cost_ is already up-to-date.
 static void HistogramRemap(const VP8LHistogramSet* const in,
                            VP8LHistogramSet* const out,
-                           uint16_t* const symbols) {
+                           uint16_t* const symbols,
+                           VP8LWorkerPool* const pool) {
   int i;
   VP8LHistogram** const in_histo = in->histograms;
   VP8LHistogram** const out_histo = out->histograms;
   const int in_size = out->max_size;
   const int out_size = out->size;
   if (out_size > 1) {
+    const int num_jobs = (VP8LWorkerPoolSize(pool) < in_size) ?
+        VP8LWorkerPoolSize(pool) : in_size;
+    RemapJob jobs[MAX_WORKER_POOL_SIZE];
+    for (i = 0; i < num_jobs; ++i) {
+      jobs[i].in_ = in;
+      jobs[i].out_ = out;
+      jobs[i].start_ = in_size * i / num_jobs;
+      jobs[i].end_ = in_size * (i + 1) / num_jobs;
+      jobs[i].symbols_ = symbols;
+    }
+    VP8LWorkerPoolRun(pool, HistogramRemapRange, jobs, sizeof(jobs[0]),
+                      num_jobs, NULL);
     for (i = 0; i < in_size; ++i) {
-      int best_out = 0;
-      double best_bits = MAX_COST;
-      int k;
       if (in_histo[i] == NULL) {
         // Arbitrarily set to the previous value if unused to help future LZ77.
         symbols[i] = symbols[i - 1];
-        continue;
-      }
-      for (k = 0; k < out_size; ++k) {
-        double cur_bits;
-        cur_bits = HistogramAddThresh(out_histo[k], in_histo[i], best_bits);
-        if (k == 0 || cur_bits < best_bits) {
-          best_bits = cur_bits;
-          best_out = k;
-        }
       }
-      symbols[i] = best_out;
     }
   } else {
     assert(out_size == 1);
@@ -1174,7 +1263,8 @@ int VP8LGetHistoImageSymbols(int xsize, int ysize,
                              int histogram_bits, int cache_bits,
                              VP8LHistogramSet* const image_histo,
                              VP8LHistogram* const tmp_histo,
-                             uint16_t* const histogram_symbols) {
+                             uint16_t* const histogram_symbols,
+                             VP8LWorkerPool* const pool) {
   int ok = 0;
   const int histo_xsize =
       histogram_bits ? VP8LSubSampleSize(xsize, histogram_bits) : 1;
@@ -1228,7 +1318,7 @@ int VP8LGetHistoImageSymbols(int xsize, int ysize,
     const int threshold_size = (int)(1 + (x * x * x) * (MAX_HISTO_GREEDY - 1));
     int do_greedy;
     if (!HistogramCombineStochastic(image_histo, &num_used, threshold_size,
-                                    &do_greedy)) {
+                                    &do_greedy, pool)) {
       goto Error;
     }
     if (do_greedy) {
@@ -1241,7 +1331,7 @@ int VP8LGetHistoImageSymbols(int xsize, int ysize,
 
   // Find the optimal map from original histograms to the final ones.
   RemoveEmptyHistograms(image_histo);
-  HistogramRemap(orig_histo, image_histo, histogram_symbols);
+  HistogramRemap(orig_histo, image_histo, histogram_symbols, pool);
 
   ok = 1;
 
@@ -294,10 +294,10 @@ static WEBP_INLINE void GetResidual(
 // If max_quantization > 1, assumes that near lossless processing will be
 // applied, quantizing residuals to multiples of quantization levels up to
 // max_quantization (the actual quantization level depends on smoothness near
-// the given pixel).
+// the given pixel). The modes of the tiles above 'first_tile_y' are not used.
 static int GetBestPredictorForTile(int width, int height,
-                                   int tile_x, int tile_y, int bits,
-                                   int accumulated[4][256],
+                                   int tile_x, int tile_y, int first_tile_y,
+                                   int bits, int accumulated[4][256],
                                    uint32_t* const argb_scratch,
                                    const uint32_t* const argb,
                                    int max_quantization,
@@ -321,7 +321,7 @@ static int GetBestPredictorForTile(int width, int height,
   // Prediction modes of the left and above neighbor tiles.
   const int left_mode = (tile_x > 0) ?
       (modes[tile_y * tiles_per_row + tile_x - 1] >> 8) & 0xff : 0xff;
-  const int above_mode = (tile_y > 0) ?
+  const int above_mode = (tile_y > first_tile_y) ?
       (modes[(tile_y - 1) * tiles_per_row + tile_x] >> 8) & 0xff : 0xff;
   // The width of upper_row and current_row is one pixel larger than image width
   // to allow the top right pixel to point to the leftmost pixel of the next row
@@ -468,18 +468,56 @@ static void CopyImageWithPrediction(int width, int height,
   }
 }
 
+// Band of tile rows [tile_y_start_, tile_y_end_) of the residual image.
+typedef struct {
+  int width_;
+  int height_;
+  int bits_;
+  int tile_y_start_;
+  int tile_y_end_;
+  uint32_t* argb_scratch_;
+  const uint32_t* argb_;
+  int max_quantization_;
+  int exact_;
+  int used_subtract_green_;
+  uint32_t* image_;
+} PredictorJob;
+
+// Finds the best predictor for each tile of a band. Each band accumulates its
+// own histogram and ignores the modes of the band above, so that the bands can
+// be processed in parallel.
+static int GetBestPredictorsForBand(void* arg1, void* arg2) {
+  const PredictorJob* const job = (const PredictorJob*)arg1;
+  const int tiles_per_row = VP8LSubSampleSize(job->width_, job->bits_);
+  int tile_y;
+  int histo[4][256];
+  (void)arg2;
+  memset(histo, 0, sizeof(histo));
+  for (tile_y = job->tile_y_start_; tile_y < job->tile_y_end_; ++tile_y) {
+    int tile_x;
+    for (tile_x = 0; tile_x < tiles_per_row; ++tile_x) {
+      const int pred = GetBestPredictorForTile(job->width_, job->height_,
+          tile_x, tile_y, job->tile_y_start_, job->bits_, histo,
+          job->argb_scratch_, job->argb_, job->max_quantization_, job->exact_,
+          job->used_subtract_green_, job->image_);
+      job->image_[tile_y * tiles_per_row + tile_x] = ARGB_BLACK | (pred << 8);
+    }
+  }
+  return 1;
+}
+
 // Finds the best predictor for each tile, and converts the image to residuals
 // with respect to predictions. If near_lossless_quality < 100, applies
 // near lossless processing, shaving off more bits of residuals for lower
-// qualities.
+// qualities. The predictors are searched in one band of tile rows per thread
+// of 'pool' (which may be NULL), each using its own part of 'argb_scratch'.
 void VP8LResidualImage(int width, int height, int bits, int low_effort,
                        uint32_t* const argb, uint32_t* const argb_scratch,
                        uint32_t* const image, int near_lossless_quality,
-                       int exact, int used_subtract_green) {
+                       int exact, int used_subtract_green,
+                       VP8LWorkerPool* const pool) {
   const int tiles_per_row = VP8LSubSampleSize(width, bits);
   const int tiles_per_col = VP8LSubSampleSize(height, bits);
-  int tile_y;
-  int histo[4][256];
   const int max_quantization = 1 << VP8LNearLosslessBits(near_lossless_quality);
   if (low_effort) {
     int i;
@@ -487,16 +525,27 @@ void VP8LResidualImage(int width, int height, int bits, int low_effort,
       image[i] = ARGB_BLACK | (kPredLowEffort << 8);
     }
   } else {
-    memset(histo, 0, sizeof(histo));
-    for (tile_y = 0; tile_y < tiles_per_col; ++tile_y) {
-      int tile_x;
-      for (tile_x = 0; tile_x < tiles_per_row; ++tile_x) {
-        const int pred = GetBestPredictorForTile(width, height, tile_x, tile_y,
-            bits, histo, argb_scratch, argb, max_quantization, exact,
-            used_subtract_green, image);
-        image[tile_y * tiles_per_row + tile_x] = ARGB_BLACK | (pred << 8);
-      }
+    const int num_bands = (VP8LWorkerPoolSize(pool) < tiles_per_col) ?
+        VP8LWorkerPoolSize(pool) : tiles_per_col;
+    PredictorJob jobs[MAX_WORKER_POOL_SIZE];
+    int i;
+    for (i = 0; i < num_bands; ++i) {
+      PredictorJob* const job = &jobs[i];
+      job->width_ = width;
+      job->height_ = height;
+      job->bits_ = bits;
+      job->tile_y_start_ = tiles_per_col * i / num_bands;
+      job->tile_y_end_ = tiles_per_col * (i + 1) / num_bands;
+      job->argb_scratch_ =
+          argb_scratch + i * VP8LResidualImageScratchSize(width);
+      job->argb_ = argb;
+      job->max_quantization_ = max_quantization;
+      job->exact_ = exact;
+      job->used_subtract_green_ = used_subtract_green;
+      job->image_ = image;
     }
+    VP8LWorkerPoolRun(pool, GetBestPredictorsForBand, jobs, sizeof(jobs[0]),
+                      num_bands, NULL);
   }
 
   CopyImageWithPrediction(width, height, bits, image, argb_scratch, argb,
@@ -714,18 +763,39 @@ static void CopyTileWithColorTransform(int xsize, int ysize,
   }
 }
 
-void VP8LColorSpaceTransform(int width, int height, int bits, int quality,
-                             uint32_t* const argb, uint32_t* image) {
+// Band of tile rows [tile_y_start_, tile_y_end_) of the color transform image.
+typedef struct {
+  int width_;
+  int height_;
+  int bits_;
+  int quality_;
+  int tile_y_start_;
+  int tile_y_end_;
+  uint32_t* argb_;
+  uint32_t* image_;
+} ColorTransformJob;
+
+// Finds and applies the best color transform for each tile of a band. Each
+// band accumulates its own histograms and only looks at its own pixels and
+// tiles, so that the bands can be processed in parallel.
+static int ColorSpaceTransformBand(void* arg1, void* arg2) {
+  const ColorTransformJob* const job = (const ColorTransformJob*)arg1;
+  const int width = job->width_;
+  const int height = job->height_;
+  const int bits = job->bits_;
+  uint32_t* const argb = job->argb_;
+  uint32_t* const image = job->image_;
   const int max_tile_size = 1 << bits;
   const int tile_xsize = VP8LSubSampleSize(width, bits);
-  const int tile_ysize = VP8LSubSampleSize(height, bits);
+  const int band_start = job->tile_y_start_ * max_tile_size * width;
   int accumulated_red_histo[256] = { 0 };
   int accumulated_blue_histo[256] = { 0 };
   int tile_x, tile_y;
   VP8LMultipliers prev_x, prev_y;
+  (void)arg2;
   MultipliersClear(&prev_y);
   MultipliersClear(&prev_x);
-  for (tile_y = 0; tile_y < tile_ysize; ++tile_y) {
+  for (tile_y = job->tile_y_start_; tile_y < job->tile_y_end_; ++tile_y) {
     for (tile_x = 0; tile_x < tile_xsize; ++tile_x) {
       int y;
       const int tile_x_offset = tile_x * max_tile_size;
@@ -733,12 +803,12 @@ void VP8LColorSpaceTransform(int width, int height, int bits, int quality,
       const int all_x_max = GetMin(tile_x_offset + max_tile_size, width);
       const int all_y_max = GetMin(tile_y_offset + max_tile_size, height);
       const int offset = tile_y * tile_xsize + tile_x;
-      if (tile_y != 0) {
+      if (tile_y != job->tile_y_start_) {
         ColorCodeToMultipliers(image[offset - tile_xsize], &prev_y);
       }
       prev_x = GetBestColorTransformForTile(tile_x, tile_y, bits,
                                             prev_x, prev_y,
-                                            quality, width, height,
+                                            job->quality_, width, height,
                                             accumulated_red_histo,
                                             accumulated_blue_histo,
                                             argb);
@@ -752,12 +822,12 @@ void VP8LColorSpaceTransform(int width, int height, int bits, int quality,
         const int ix_end = ix + all_x_max - tile_x_offset;
         for (; ix < ix_end; ++ix) {
           const uint32_t pix = argb[ix];
-          if (ix >= 2 &&
+          if (ix >= band_start + 2 &&
               pix == argb[ix - 2] &&
               pix == argb[ix - 1]) {
             continue;  // repeated pixels are handled by backward references
           }
-          if (ix >= width + 2 &&
+          if (ix >= band_start + width + 2 &&
               argb[ix - 2] == argb[ix - width - 2] &&
               argb[ix - 1] == argb[ix - width - 1] &&
               pix == argb[ix - width]) {
@@ -769,4 +839,31 @@ void VP8LColorSpaceTransform(int width, int height, int bits, int quality,
       }
     }
   }
+  return 1;
+}
+
+// Finds the best color transform for each tile, and applies it to 'argb'. The
+// transforms are searched in one band of tile rows per thread of 'pool' (which
+// may be NULL).
+void VP8LColorSpaceTransform(int width, int height, int bits, int quality,
+                             uint32_t* const argb, uint32_t* image,
+                             VP8LWorkerPool* const pool) {
+  const int tile_ysize = VP8LSubSampleSize(height, bits);
+  const int num_bands = (VP8LWorkerPoolSize(pool) < tile_ysize) ?
+      VP8LWorkerPoolSize(pool) : tile_ysize;
+  ColorTransformJob jobs[MAX_WORKER_POOL_SIZE];
+  int i;
+  for (i = 0; i < num_bands; ++i) {
+    ColorTransformJob* const job = &jobs[i];
+    job->width_ = width;
+    job->height_ = height;
+    job->bits_ = bits;
+    job->quality_ = quality;
+    job->tile_y_start_ = tile_ysize * i / num_bands;
+    job->tile_y_end_ = tile_ysize * (i + 1) / num_bands;
+    job->argb_ = argb;
+    job->image_ = image;
+  }
+  VP8LWorkerPoolRun(pool, ColorSpaceTransformBand, jobs, sizeof(jobs[0]),
+                    num_bands, NULL);
 }
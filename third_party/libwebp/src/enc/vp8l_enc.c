@@ -1013,7 +1013,8 @@ static WebPEncodingError StoreImageToBitMask(
 static WebPEncodingError EncodeImageNoHuffman(
     VP8LBitWriter* const bw, const uint32_t* const argb,
     VP8LHashChain* const hash_chain, VP8LBackwardRefs* const refs_array,
-    int width, int height, int quality, int low_effort) {
+    int width, int height, int quality, int low_effort,
+    VP8LWorkerPool* const pool) {
   int i;
   int max_tokens = 0;
   WebPEncodingError err = VP8_ENC_OK;
@@ -1032,7 +1033,7 @@ static WebPEncodingError EncodeImageNoHuffman(
 
   // Calculate backward references from ARGB image.
   if (!VP8LHashChainFill(hash_chain, quality, argb, width, height,
-                         low_effort)) {
+                         low_effort, pool)) {
     err = VP8_ENC_ERROR_OUT_OF_MEMORY;
     goto Error;
   }
@@ -1099,7 +1100,8 @@ static WebPEncodingError EncodeImageInternal(
     VP8LHashChain* const hash_chain, VP8LBackwardRefs refs_array[4], int width,
     int height, int quality, int low_effort, int use_cache,
     const CrunchConfig* const config, int* cache_bits, int histogram_bits,
-    size_t init_byte_position, int* const hdr_size, int* const data_size) {
+    size_t init_byte_position, int* const hdr_size, int* const data_size,
+    VP8LWorkerPool* const pool) {
   WebPEncodingError err = VP8_ENC_ERROR_OUT_OF_MEMORY;
   const uint32_t histogram_image_xysize =
       VP8LSubSampleSize(width, histogram_bits) *
@@ -1131,7 +1133,7 @@ static WebPEncodingError EncodeImageInternal(
   if (huff_tree == NULL || histogram_symbols == NULL ||
       !VP8LHashChainInit(&hash_chain_histogram, histogram_image_xysize) ||
       !VP8LHashChainFill(hash_chain, quality, argb, width, height,
-                         low_effort)) {
+                         low_effort, pool)) {
     goto Error;
   }
   if (use_cache) {
@@ -1176,7 +1178,7 @@ static WebPEncodingError EncodeImageInternal(
           !VP8LGetHistoImageSymbols(width, height, &refs_array[i_cache],
                                     quality, low_effort, histogram_bits,
                                     cache_bits_tmp, histogram_image, tmp_histo,
-                                    histogram_symbols)) {
+                                    histogram_symbols, pool)) {
         goto Error;
       }
       // Create Huffman bit lengths and codes for each histogram image.
@@ -1230,7 +1232,8 @@ static WebPEncodingError EncodeImageInternal(
         err = EncodeImageNoHuffman(
             bw, histogram_argb, &hash_chain_histogram, &refs_array[2],
             VP8LSubSampleSize(width, histogram_bits),
-            VP8LSubSampleSize(height, histogram_bits), quality, low_effort);
+            VP8LSubSampleSize(height, histogram_bits), quality, low_effort,
+            pool);
         WebPSafeFree(histogram_argb);
         if (err != VP8_ENC_OK) goto Error;
       }
@@ -1320,7 +1323,7 @@ static WebPEncodingError ApplyPredictFilter(const VP8LEncoder* const enc,
   VP8LResidualImage(width, height, pred_bits, low_effort, enc->argb_,
                     enc->argb_scratch_, enc->transform_data_,
                     near_lossless_strength, enc->config_->exact,
-                    used_subtract_green);
+                    used_subtract_green, (VP8LWorkerPool*)&enc->pool_);
   VP8LPutBits(bw, TRANSFORM_PRESENT, 1);
   VP8LPutBits(bw, PREDICTOR_TRANSFORM, 2);
   assert(pred_bits >= 2);
@@ -1328,7 +1331,7 @@ static WebPEncodingError ApplyPredictFilter(const VP8LEncoder* const enc,
   return EncodeImageNoHuffman(
       bw, enc->transform_data_, (VP8LHashChain*)&enc->hash_chain_,
       (VP8LBackwardRefs*)&enc->refs_[0], transform_width, transform_height,
-      quality, low_effort);
+      quality, low_effort, (VP8LWorkerPool*)&enc->pool_);
 }
 
 static WebPEncodingError ApplyCrossColorFilter(const VP8LEncoder* const enc,
@@ -1340,7 +1343,8 @@ static WebPEncodingError ApplyCrossColorFilter(const VP8LEncoder* const enc,
   const int transform_height = VP8LSubSampleSize(height, ccolor_transform_bits);
 
   VP8LColorSpaceTransform(width, height, ccolor_transform_bits, quality,
-                          enc->argb_, enc->transform_data_);
+                          enc->argb_, enc->transform_data_,
+                          (VP8LWorkerPool*)&enc->pool_);
   VP8LPutBits(bw, TRANSFORM_PRESENT, 1);
   VP8LPutBits(bw, CROSS_COLOR_TRANSFORM, 2);
   assert(ccolor_transform_bits >= 2);
@@ -1348,7 +1352,7 @@ static WebPEncodingError ApplyCrossColorFilter(const VP8LEncoder* const enc,
   return EncodeImageNoHuffman(
       bw, enc->transform_data_, (VP8LHashChain*)&enc->hash_chain_,
       (VP8LBackwardRefs*)&enc->refs_[0], transform_width, transform_height,
-      quality, low_effort);
+      quality, low_effort, (VP8LWorkerPool*)&enc->pool_);
 }
 
 // -----------------------------------------------------------------------------
@@ -1433,13 +1437,12 @@ static WebPEncodingError AllocateTransformBuffer(VP8LEncoder* const enc,
                                                  int width, int height) {
   WebPEncodingError err = VP8_ENC_OK;
   const uint64_t image_size = width * height;
-  // VP8LResidualImage needs room for 2 scanlines of uint32 pixels with an extra
-  // pixel in each, plus 2 regular scanlines of bytes.
+  // VP8LResidualImage needs its scratch memory for each thread of the pool.
   // TODO(skal): Clean up by using arithmetic in bytes instead of words.
   const uint64_t argb_scratch_size =
       enc->use_predict_
-          ? (width + 1) * 2 +
-            (width * 2 + sizeof(uint32_t) - 1) / sizeof(uint32_t)
+          ? (uint64_t)VP8LResidualImageScratchSize(width) *
+                VP8LWorkerPoolSize(&enc->pool_)
           : 0;
   const uint64_t transform_data_size =
       (enc->use_predict_ || enc->use_cross_color_)
@@ -1668,7 +1671,7 @@ static WebPEncodingError EncodePalette(VP8LBitWriter* const bw, int low_effort,
   tmp_palette[0] = palette[0];
   return EncodeImageNoHuffman(bw, tmp_palette, &enc->hash_chain_,
                               &enc->refs_[0], palette_size, 1, /*quality=*/20,
-                              low_effort);
+                              low_effort, &enc->pool_);
 }
 
 // -----------------------------------------------------------------------------
@@ -1696,6 +1699,7 @@ static void VP8LEncoderDelete(VP8LEncoder* enc) {
     VP8LHashChainClear(&enc->hash_chain_);
     for (i = 0; i < 4; ++i) VP8LBackwardRefsClear(&enc->refs_[i]);
     ClearTransformBuffer(enc);
+    VP8LWorkerPoolClear(&enc->pool_);
     WebPSafeFree(enc);
   }
 }
@@ -1855,7 +1859,8 @@ static int EncodeStreamHook(void* input, void* data2) {
                               enc->current_width_, height, quality, low_effort,
                               use_cache, &crunch_configs[idx],
                               &enc->cache_bits_, enc->histo_bits_,
-                              byte_position, &hdr_size, &data_size);
+                              byte_position, &hdr_size, &data_size,
+                              &enc->pool_);
     if (err != VP8_ENC_OK) goto Error;
 
     // If we are better than what we already have.
@@ -1910,6 +1915,8 @@ WebPEncodingError VP8LEncodeStream(const WebPConfig* const config,
   WebPAuxStats stats_side;
   VP8LBitWriter bw_side;
   const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  // Threads shared by the heavy stages of the main and side encoders.
+  const int num_threads = (config->thread_level > 1) ? config->thread_level : 1;
   int ok_main;
 
   // Analyze image (entropy, num_palettes etc)
@@ -1936,6 +1943,13 @@ WebPEncodingError VP8LEncodeStream(const WebPConfig* const config,
     params_main.crunch_configs_[idx] = crunch_configs[idx];
   }
   params_main.num_crunch_configs_ = num_crunch_configs_main;
+  if (!VP8LWorkerPoolInit(&enc_main->pool_,
+                          (num_crunch_configs_side > 0)
+                              ? num_threads - num_threads / 2
+                              : num_threads)) {
+    err = VP8_ENC_ERROR_OUT_OF_MEMORY;
+    goto Error;
+  }
 
   // Fill in the parameters for the thread workers.
   {
@@ -1963,7 +1977,8 @@ WebPEncodingError VP8LEncodeStream(const WebPConfig* const config,
         param->bw_ = &bw_side;
         // Create a side encoder.
         enc_side = VP8LEncoderNew(config, picture);
-        if (enc_side == NULL || !EncoderInit(enc_side)) {
+        if (enc_side == NULL || !EncoderInit(enc_side) ||
+            !VP8LWorkerPoolInit(&enc_side->pool_, num_threads / 2)) {
           err = VP8_ENC_ERROR_OUT_OF_MEMORY;
           goto Error;
         }
@@ -76,6 +76,7 @@ typedef struct {
   struct VP8LBackwardRefs refs_[4];  // Backward Refs array for temporaries.
   VP8LHashChain hash_chain_;         // HashChain data for constructing
                                      // backward references.
+  VP8LWorkerPool pool_;              // Threads sharing the heavy stages.
 } VP8LEncoder;
 
 //------------------------------------------------------------------------------
@@ -103,13 +104,21 @@ int VP8ApplyNearLossless(const WebPPicture* const picture, int quality,
 //------------------------------------------------------------------------------
 // Image transforms in predictor.c.
 
+// Size, in words, of the 'argb_scratch' needed by each thread of the pool in
+// VP8LResidualImage(): 2 scanlines of uint32 pixels with an extra pixel in
+// each, plus 2 regular scanlines of bytes.
+static WEBP_INLINE size_t VP8LResidualImageScratchSize(int width) {
+  return (width + 1) * 2 + (width * 2 + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+}
+
 void VP8LResidualImage(int width, int height, int bits, int low_effort,
                        uint32_t* const argb, uint32_t* const argb_scratch,
                        uint32_t* const image, int near_lossless, int exact,
-                       int used_subtract_green);
+                       int used_subtract_green, VP8LWorkerPool* const pool);
 
 void VP8LColorSpaceTransform(int width, int height, int bits, int quality,
-                             uint32_t* const argb, uint32_t* image);
+                             uint32_t* const argb, uint32_t* image,
+                             VP8LWorkerPool* const pool);
 
 //------------------------------------------------------------------------------
 
@@ -0,0 +1,115 @@
+// Copyright 2021 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// Pool of workers sharing the heavy stages of the lossless encoder.
+//
+
+#include <assert.h>
+#include <string.h>
+
+#include "src/enc/worker_pool_enc.h"
+#include "src/utils/utils.h"
+
+// Jobs 'first_job_', 'first_job_ + step_', ... below 'num_jobs_'.
+struct VP8LWorkerPoolTask {
+  WebPWorkerHook hook_;
+  uint8_t* jobs_;
+  size_t job_size_;
+  int first_job_;
+  int step_;
+  int num_jobs_;
+  void* data_;
+};
+
+static int RunTask(void* arg1, void* arg2) {
+  const VP8LWorkerPoolTask* const task = (const VP8LWorkerPoolTask*)arg1;
+  int ok = 1;
+  int i;
+  (void)arg2;
+  for (i = task->first_job_; i < task->num_jobs_; i += task->step_) {
+    ok &= task->hook_(task->jobs_ + i * task->job_size_, task->data_);
+  }
+  return ok;
+}
+
+int VP8LWorkerPoolInit(VP8LWorkerPool* const pool, int num_threads) {
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  int i;
+  assert(pool != NULL);
+  memset(pool, 0, sizeof(*pool));
+  if (num_threads < 1) num_threads = 1;
+  if (num_threads > MAX_WORKER_POOL_SIZE) num_threads = MAX_WORKER_POOL_SIZE;
+  pool->tasks_ = (VP8LWorkerPoolTask*)WebPSafeMalloc(num_threads,
+                                                     sizeof(*pool->tasks_));
+  if (pool->tasks_ == NULL) return 0;
+  pool->size_ = 1;
+  if (num_threads == 1) return 1;
+
+  pool->workers_ = (WebPWorker*)WebPSafeMalloc(num_threads - 1,
+                                               sizeof(*pool->workers_));
+  if (pool->workers_ == NULL) {
+    VP8LWorkerPoolClear(pool);
+    return 0;
+  }
+  for (i = 0; i < num_threads - 1; ++i) {
+    WebPWorker* const worker = &pool->workers_[i];
+    worker_interface->Init(worker);
+    // Make do with the threads started so far.
+    if (!worker_interface->Reset(worker)) break;
+    worker->hook = RunTask;
+    worker->data1 = &pool->tasks_[i + 1];
+    worker->data2 = NULL;
+    ++pool->size_;
+  }
+  return 1;
+}
+
+void VP8LWorkerPoolClear(VP8LWorkerPool* const pool) {
+  if (pool != NULL) {
+    int i;
+    for (i = 0; i < pool->size_ - 1; ++i) {
+      WebPGetWorkerInterface()->End(&pool->workers_[i]);
+    }
+    WebPSafeFree(pool->workers_);
+    WebPSafeFree(pool->tasks_);
+    memset(pool, 0, sizeof(*pool));
+  }
+}
+
+int VP8LWorkerPoolRun(VP8LWorkerPool* const pool, WebPWorkerHook hook,
+                      void* const jobs, size_t job_size, int num_jobs,
+                      void* const data) {
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  const int pool_size = VP8LWorkerPoolSize(pool);
+  const int num_runners = (num_jobs < pool_size) ? num_jobs : pool_size;
+  VP8LWorkerPoolTask serial_task;
+  VP8LWorkerPoolTask* const tasks = (pool == NULL) ? &serial_task
+                                                   : pool->tasks_;
+  int ok;
+  int i;
+  if (num_jobs <= 0) return 1;
+  for (i = 0; i < num_runners; ++i) {
+    VP8LWorkerPoolTask* const task = &tasks[i];
+    task->hook_ = hook;
+    task->jobs_ = (uint8_t*)jobs;
+    task->job_size_ = job_size;
+    task->first_job_ = i;
+    task->step_ = num_runners;
+    task->num_jobs_ = num_jobs;
+    task->data_ = data;
+  }
+  for (i = 1; i < num_runners; ++i) {
+    worker_interface->Launch(&pool->workers_[i - 1]);
+  }
+  ok = RunTask(&tasks[0], NULL);
+  for (i = 1; i < num_runners; ++i) {
+    ok &= worker_interface->Sync(&pool->workers_[i - 1]);
+  }
+  return ok;
+}
@@ -0,0 +1,60 @@
+// Copyright 2021 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// Pool of workers sharing the heavy stages of the lossless encoder.
+//
+
+#ifndef WEBP_ENC_WORKER_POOL_ENC_H_
+#define WEBP_ENC_WORKER_POOL_ENC_H_
+
+#include <stddef.h>
+
+#include "src/utils/thread_utils.h"
+#include "src/webp/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum number of threads in a pool.
+#define MAX_WORKER_POOL_SIZE 64
+
+typedef struct VP8LWorkerPoolTask VP8LWorkerPoolTask;  // forward declaration
+
+typedef struct {
+  int size_;                   // number of jobs run at the same time
+  WebPWorker* workers_;        // 'size_ - 1' threads, the caller is the last.
+  VP8LWorkerPoolTask* tasks_;  // jobs handed to each of the 'size_' runners
+} VP8LWorkerPool;
+
+// Must be called first. Starts 'num_threads - 1' threads, or fewer if they can
+// not be started. Returns false in case of memory error.
+int VP8LWorkerPoolInit(VP8LWorkerPool* const pool, int num_threads);
+// Stops the threads and releases memory.
+void VP8LWorkerPoolClear(VP8LWorkerPool* const pool);
+
+// Returns the number of jobs 'pool' runs at the same time, 1 if it is NULL.
+static WEBP_INLINE int VP8LWorkerPoolSize(const VP8LWorkerPool* const pool) {
+  return (pool == NULL) ? 1 : pool->size_;
+}
+
+// Calls 'hook(jobs + i * job_size, data)' for each i in [0, num_jobs), running
+// up to VP8LWorkerPoolSize() of them at the same time, and returns when they
+// are all done. The calling thread runs its share of the jobs. 'pool' may be
+// NULL, in which case the jobs run one after the other.
+// Returns false if any of the calls did.
+int VP8LWorkerPoolRun(VP8LWorkerPool* const pool, WebPWorkerHook hook,
+                      void* const jobs, size_t job_size, int num_jobs,
+                      void* const data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WEBP_ENC_WORKER_POOL_ENC_H_
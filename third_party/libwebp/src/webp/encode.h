@@ -136,6 +136,10 @@ struct WebPConfig {
                           // JPEG compression. Generally, the output size will
                           // be similar but the degradation will be lower.
   int thread_level;       // If non-zero, try and use multi-threaded encoding.
+                          // In lossless mode, values above 1 [2..64] are
+                          // the number of threads to use. Extra threads may
+                          // increase the output size. The output is
+                          // deterministic for a given thread count.
   int low_memory;         // If set, reduce memory usage (but increase CPU use).
 
   int near_lossless;      // Near lossless encoding [0 = max loss .. 100 = off
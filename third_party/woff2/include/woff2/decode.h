@@ -11,10 +11,53 @@
 
 #include <stddef.h>
 #include <inttypes.h>
+#include <functional>
 #include <woff2/output.h>
 
 namespace woff2 {
 
+// Called with a table that is stored untransformed (every table except, in
+// most fonts, 'glyf', 'loca' and 'hmtx') once its data is decompressed, before
+// any glyph is reconstructed. The data is final, except for the
+// checkSumAdjustment of 'head' which is 0. It stays valid until the decoding
+// call returns. Decoding can still fail after tables were reported.
+typedef std::function<void(uint32_t tag, const uint8_t* data, size_t length)>
+    WOFF2TableCallback;
+
+// Runs |task| on another thread, for instance on a thread pool of the
+// embedder. |task| must eventually run, but does not need to start before the
+// decoding call returns.
+typedef std::function<void(std::function<void()> task)> WOFF2PostTask;
+
+// Wall-clock time spent decoding, in milliseconds.
+struct WOFF2DecodeTimings {
+  WOFF2DecodeTimings() : header_ms(0), uncompress_ms(0), glyf_ms(0),
+                         total_ms(0) {}
+
+  double header_ms;      // Reading the header, writing the table directory.
+  double uncompress_ms;  // Brotli decompression of the table data.
+  double glyf_ms;        // Reconstructing transformed 'glyf' and 'loca'.
+  double total_ms;
+};
+
+struct WOFF2DecodeParams {
+  WOFF2DecodeParams() : num_threads(1), timings(NULL) {}
+
+  // Number of threads reconstructing 'glyf' tables, including the calling
+  // one. With more than one, ranges of glyphs of every font in the file are
+  // reconstructed concurrently, and 'glyf' tables are held in memory once more
+  // before being written out.
+  int num_threads;
+  // If set, the extra threads are borrowed with this instead of being created
+  // for each decoding call.
+  WOFF2PostTask post_task;
+  // If set, the table data is decompressed a chunk at a time and this is
+  // called as untransformed tables become available.
+  WOFF2TableCallback on_table_ready;
+  // If not NULL, set to the phase timings of a successful decode.
+  WOFF2DecodeTimings* timings;
+};
+
 // Compute the size of the final uncompressed font, or 0 on error.
 size_t ComputeWOFF2FinalSize(const uint8_t *data, size_t length);
 
@@ -30,6 +73,8 @@ bool ConvertWOFF2ToTTF(uint8_t *result, size_t result_length,
 // Please prefer this API.
 bool ConvertWOFF2ToTTF(const uint8_t *data, size_t length,
                        WOFF2Out* out);
+bool ConvertWOFF2ToTTF(const uint8_t *data, size_t length,
+                       WOFF2Out* out, const WOFF2DecodeParams& params);
 
 } // namespace woff2
 
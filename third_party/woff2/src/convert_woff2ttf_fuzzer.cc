@@ -1,13 +1,35 @@
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <woff2/decode.h>
 
+// Thread counts the threaded decoder is run with, the output of which must be
+// identical to the serial one.
+static const int kThreadCounts[] = {2, 3, 8};
+
 // Entry point for LibFuzzer.
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
   std::string buf;
   woff2::WOFF2StringOut out(&buf);
   out.SetMaxSize(30 * 1024 * 1024);
-  woff2::ConvertWOFF2ToTTF(data, size, &out);
+  const bool ok = woff2::ConvertWOFF2ToTTF(data, size, &out);
+
+  for (int num_threads : kThreadCounts) {
+    woff2::WOFF2DecodeParams params;
+    params.num_threads = num_threads;
+    // Also exercise the chunked decompression with one of the thread counts.
+    if (num_threads == 3) {
+      params.on_table_ready = [](uint32_t, const uint8_t*, size_t) {};
+    }
+    std::string threaded_buf;
+    woff2::WOFF2StringOut threaded_out(&threaded_buf);
+    threaded_out.SetMaxSize(30 * 1024 * 1024);
+    const bool threaded_ok =
+        woff2::ConvertWOFF2ToTTF(data, size, &threaded_out, params);
+    if (threaded_ok != ok || (ok && threaded_buf != buf)) {
+      abort();
+    }
+  }
   return 0;
 }
@@ -12,13 +12,64 @@
 
 #include "./port.h"
 
+#if defined(WOFF_LITTLE_ENDIAN) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define WOFF2_CHECKSUM_SSE2
+#elif defined(WOFF_LITTLE_ENDIAN) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WOFF2_CHECKSUM_NEON
+#endif
+
 namespace woff2 {
 
+namespace {
+
+// Sums the big-endian 32-bit words of the first |*size| bytes of |buf| 16
+// bytes at a time, and sets |*size| to the number of bytes summed.
+uint32_t ComputeULongSumVector(const uint8_t* buf, size_t* size) {
+  const size_t vector_size = *size & ~static_cast<size_t>(15);
+  *size = vector_size;
+#if defined(WOFF2_CHECKSUM_SSE2)
+  // Without a byte shuffle, sum each byte of the words separately. The sum of
+  // byte-swapped words is then the sum of those sums, each shifted into place.
+  const __m128i low_byte = _mm_set1_epi32(0xFF);
+  __m128i sum0 = _mm_setzero_si128();
+  __m128i sum1 = _mm_setzero_si128();
+  __m128i sum2 = _mm_setzero_si128();
+  __m128i sum3 = _mm_setzero_si128();
+  for (size_t i = 0; i < vector_size; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    sum0 = _mm_add_epi32(sum0, _mm_and_si128(v, low_byte));
+    sum1 = _mm_add_epi32(sum1, _mm_and_si128(_mm_srli_epi32(v, 8), low_byte));
+    sum2 = _mm_add_epi32(sum2, _mm_and_si128(_mm_srli_epi32(v, 16), low_byte));
+    sum3 = _mm_add_epi32(sum3, _mm_srli_epi32(v, 24));
+  }
+  __m128i sum = _mm_add_epi32(
+      _mm_add_epi32(_mm_slli_epi32(sum0, 24), _mm_slli_epi32(sum1, 16)),
+      _mm_add_epi32(_mm_slli_epi32(sum2, 8), sum3));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+#elif defined(WOFF2_CHECKSUM_NEON)
+  uint32x4_t sum = vdupq_n_u32(0);
+  for (size_t i = 0; i < vector_size; i += 16) {
+    sum = vaddq_u32(sum, vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(buf + i))));
+  }
+  return vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) +
+         vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+#else
+  *size = 0;
+  return 0;
+#endif
+}
+
+}  // namespace
 
 uint32_t ComputeULongSum(const uint8_t* buf, size_t size) {
-  uint32_t checksum = 0;
+  size_t vector_size = size;
+  uint32_t checksum = ComputeULongSumVector(buf, &vector_size);
   size_t aligned_size = size & ~3;
-  for (size_t i = 0; i < aligned_size; i += 4) {
+  for (size_t i = vector_size; i < aligned_size; i += 4) {
 #if defined(WOFF_LITTLE_ENDIAN)
     uint32_t v = *reinterpret_cast<const uint32_t*>(buf + i);
     checksum += (((v & 0xFF) << 24) | ((v & 0xFF00) << 8) |
@@ -10,13 +10,18 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <chrono>
 #include <complex>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <utility>
 
 #include <brotli/decode.h>
@@ -66,6 +71,17 @@ const size_t kDefaultGlyphBuf = 5120;
 // >100 suggests you wrote a bad uncompressed size.
 const float kMaxPlausibleCompressionRatio = 100.0;
 
+// Amount of data decompressed between two checks for complete tables when
+// reporting tables early.
+const size_t kStreamingChunkSize = 64 * 1024;
+
+typedef std::chrono::steady_clock Clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
 // metadata for a TTC font entry
 struct TtcFont {
   uint32_t flavor;
@@ -397,35 +413,144 @@ bool StoreLoca(const std::vector<uint32_t>& loca_values, int index_format,
   return true;
 }
 
-// Reconstruct entire glyf table based on transformed original
-bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
-                     uint32_t* glyf_checksum, Table * loca_table,
-                     uint32_t* loca_checksum, WOFF2FontInfo* info,
-                     WOFF2Out* out) {
+// The seven substreams of a transformed 'glyf' table, positioned at the start
+// of some glyph.
+struct GlyfStreams {
+  explicit GlyfStreams(
+      const std::vector<std::pair<const uint8_t*, size_t> >& substreams)
+      : n_contour(substreams[0].first, substreams[0].second),
+        n_points(substreams[1].first, substreams[1].second),
+        flag(substreams[2].first, substreams[2].second),
+        glyph(substreams[3].first, substreams[3].second),
+        composite(substreams[4].first, substreams[4].second),
+        bbox(substreams[5].first, substreams[5].second),
+        instruction(substreams[6].first, substreams[6].second) {}
+
+  Buffer n_contour;
+  Buffer n_points;
+  Buffer flag;
+  Buffer glyph;
+  Buffer composite;
+  Buffer bbox;
+  Buffer instruction;
+};
+
+// A transformed 'glyf' table, split into ranges of glyphs that can be
+// reconstructed independently of each other.
+struct GlyfSource {
+  uint16_t num_glyphs;
+  uint16_t index_format;
+  const uint8_t* bbox_bitmap;
+  // First glyph of each range, followed by num_glyphs.
+  std::vector<unsigned int> range_starts;
+  // Substreams positioned at the first glyph of each range.
+  std::vector<GlyfStreams> range_streams;
+};
+
+bool HaveBbox(const uint8_t* bbox_bitmap, unsigned int glyph) {
+  return (bbox_bitmap[glyph >> 3] & (0x80 >> (glyph & 7))) != 0;
+}
+
+// Advances the substreams past one glyph without reconstructing it. This only
+// parses the lengths of the glyph's data, so it is much cheaper than
+// ReconstructGlyphRange().
+bool SkipGlyph(GlyfStreams* streams, bool have_bbox) {
+  uint16_t n_contours;
+  if (PREDICT_FALSE(!streams->n_contour.ReadU16(&n_contours))) {
+    return FONT_COMPRESSION_FAILURE();
+  }
+
+  unsigned int instruction_size = 0;
+  if (n_contours == 0xffff) {
+    // composite glyph
+    bool have_instructions = false;
+    size_t composite_size;
+    if (PREDICT_FALSE(!have_bbox ||
+                      !SizeOfComposite(streams->composite, &composite_size,
+                                       &have_instructions) ||
+                      !streams->composite.Skip(composite_size))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+    if (have_instructions) {
+      if (PREDICT_FALSE(!Read255UShort(&streams->glyph, &instruction_size))) {
+        return FONT_COMPRESSION_FAILURE();
+      }
+    }
+  } else if (n_contours > 0) {
+    // simple glyph
+    unsigned int total_n_points = 0;
+    for (unsigned int j = 0; j < n_contours; ++j) {
+      unsigned int n_points_contour;
+      if (PREDICT_FALSE(
+          !Read255UShort(&streams->n_points, &n_points_contour))) {
+        return FONT_COMPRESSION_FAILURE();
+      }
+      if (PREDICT_FALSE(total_n_points + n_points_contour < total_n_points)) {
+        return FONT_COMPRESSION_FAILURE();
+      }
+      total_n_points += n_points_contour;
+    }
+    if (PREDICT_FALSE(total_n_points >
+                      streams->flag.length() - streams->flag.offset())) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+    // The number of bytes of each triplet only depends on its flag, see
+    // TripletDecode().
+    const uint8_t* flags = streams->flag.buffer() + streams->flag.offset();
+    size_t triplet_size = 0;
+    for (unsigned int i = 0; i < total_n_points; ++i) {
+      uint8_t flag = flags[i] & 0x7f;
+      triplet_size += flag < 84 ? 1 : flag < 120 ? 2 : flag < 124 ? 3 : 4;
+    }
+    if (PREDICT_FALSE(!streams->flag.Skip(total_n_points) ||
+                      !streams->glyph.Skip(triplet_size) ||
+                      !Read255UShort(&streams->glyph, &instruction_size))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+  } else if (PREDICT_FALSE(have_bbox)) {
+    // n_contours == 0; empty glyph. Must NOT have a bbox.
+    return FONT_COMPRESSION_FAILURE();
+  }
+
+  if (have_bbox) {
+    if (PREDICT_FALSE(!streams->bbox.Skip(8))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+  }
+  if (PREDICT_FALSE(!streams->instruction.Skip(instruction_size))) {
+    return FONT_COMPRESSION_FAILURE();
+  }
+  return true;
+}
+
+// Reads the header and substreams of a transformed 'glyf' table, and splits
+// its glyphs into at most |num_ranges| ranges.
+bool ReadGlyfSource(const uint8_t* data, const Table& glyf_table,
+                    const Table& loca_table, unsigned int num_ranges,
+                    GlyfSource* source) {
   static const int kNumSubStreams = 7;
-  Buffer file(data, glyf_table->transform_length);
+  Buffer file(data, glyf_table.transform_length);
   uint32_t version;
   std::vector<std::pair<const uint8_t*, size_t> > substreams(kNumSubStreams);
-  const size_t glyf_start = out->Size();
 
   if (PREDICT_FALSE(!file.ReadU32(&version))) {
     return FONT_COMPRESSION_FAILURE();
   }
-  if (PREDICT_FALSE(!file.ReadU16(&info->num_glyphs) ||
-      !file.ReadU16(&info->index_format))) {
+  if (PREDICT_FALSE(!file.ReadU16(&source->num_glyphs) ||
+      !file.ReadU16(&source->index_format))) {
     return FONT_COMPRESSION_FAILURE();
   }
 
   // https://dev.w3.org/webfonts/WOFF2/spec/#conform-mustRejectLoca
   // dst_length here is origLength in the spec
-  uint32_t expected_loca_dst_length = (info->index_format ? 4 : 2)
-    * (static_cast<uint32_t>(info->num_glyphs) + 1);
-  if (PREDICT_FALSE(loca_table->dst_length != expected_loca_dst_length)) {
+  uint32_t expected_loca_dst_length = (source->index_format ? 4 : 2)
+    * (static_cast<uint32_t>(source->num_glyphs) + 1);
+  if (PREDICT_FALSE(loca_table.dst_length != expected_loca_dst_length)) {
     return FONT_COMPRESSION_FAILURE();
   }
 
   unsigned int offset = (2 + kNumSubStreams) * 4;
-  if (PREDICT_FALSE(offset > glyf_table->transform_length)) {
+  if (PREDICT_FALSE(offset > glyf_table.transform_length)) {
     return FONT_COMPRESSION_FAILURE();
   }
   // Invariant from here on: data_size >= offset
@@ -434,44 +559,64 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
     if (PREDICT_FALSE(!file.ReadU32(&substream_size))) {
       return FONT_COMPRESSION_FAILURE();
     }
-    if (PREDICT_FALSE(substream_size > glyf_table->transform_length - offset)) {
+    if (PREDICT_FALSE(substream_size > glyf_table.transform_length - offset)) {
       return FONT_COMPRESSION_FAILURE();
     }
     substreams[i] = std::make_pair(data + offset, substream_size);
     offset += substream_size;
   }
-  Buffer n_contour_stream(substreams[0].first, substreams[0].second);
-  Buffer n_points_stream(substreams[1].first, substreams[1].second);
-  Buffer flag_stream(substreams[2].first, substreams[2].second);
-  Buffer glyph_stream(substreams[3].first, substreams[3].second);
-  Buffer composite_stream(substreams[4].first, substreams[4].second);
-  Buffer bbox_stream(substreams[5].first, substreams[5].second);
-  Buffer instruction_stream(substreams[6].first, substreams[6].second);
+  GlyfStreams streams(substreams);
 
-  std::vector<uint32_t> loca_values(info->num_glyphs + 1);
-  std::vector<unsigned int> n_points_vec;
-  std::unique_ptr<Point[]> points;
-  size_t points_size = 0;
-  const uint8_t* bbox_bitmap = bbox_stream.buffer();
+  source->bbox_bitmap = streams.bbox.buffer();
   // Safe because num_glyphs is bounded
-  unsigned int bitmap_length = ((info->num_glyphs + 31) >> 5) << 2;
-  if (!bbox_stream.Skip(bitmap_length)) {
+  unsigned int bitmap_length = ((source->num_glyphs + 31) >> 5) << 2;
+  if (!streams.bbox.Skip(bitmap_length)) {
     return FONT_COMPRESSION_FAILURE();
   }
 
+  source->range_starts.clear();
+  source->range_streams.clear();
+  source->range_starts.push_back(0);
+  source->range_streams.push_back(streams);
+  unsigned int glyph = 0;
+  for (unsigned int range = 1; range < num_ranges; ++range) {
+    const unsigned int range_start =
+        static_cast<uint64_t>(source->num_glyphs) * range / num_ranges;
+    for (; glyph < range_start; ++glyph) {
+      if (PREDICT_FALSE(!SkipGlyph(&streams,
+                                   HaveBbox(source->bbox_bitmap, glyph)))) {
+        return FONT_COMPRESSION_FAILURE();
+      }
+    }
+    source->range_starts.push_back(range_start);
+    source->range_streams.push_back(streams);
+  }
+  source->range_starts.push_back(source->num_glyphs);
+  return true;
+}
+
+// Reconstructs the glyphs of one range of |source| and appends them to |out|.
+// loca values are relative to |glyf_start|, and are stored along with x_mins
+// at the index of each glyph.
+bool ReconstructGlyphRange(const GlyfSource& source, size_t range,
+                           size_t glyf_start, uint32_t* loca_values,
+                           int16_t* x_mins, uint32_t* glyf_checksum,
+                           WOFF2Out* out) {
+  GlyfStreams streams = source.range_streams[range];
+  std::vector<unsigned int> n_points_vec;
+  std::unique_ptr<Point[]> points;
+  size_t points_size = 0;
+
   // Temp buffer for glyph's.
   size_t glyph_buf_size = kDefaultGlyphBuf;
   std::unique_ptr<uint8_t[]> glyph_buf(new uint8_t[glyph_buf_size]);
 
-  info->x_mins.resize(info->num_glyphs);
-  for (unsigned int i = 0; i < info->num_glyphs; ++i) {
+  for (unsigned int i = source.range_starts[range];
+       i < source.range_starts[range + 1]; ++i) {
     size_t glyph_size = 0;
     uint16_t n_contours = 0;
-    bool have_bbox = false;
-    if (bbox_bitmap[i >> 3] & (0x80 >> (i & 7))) {
-      have_bbox = true;
-    }
-    if (PREDICT_FALSE(!n_contour_stream.ReadU16(&n_contours))) {
+    bool have_bbox = HaveBbox(source.bbox_bitmap, i);
+    if (PREDICT_FALSE(!streams.n_contour.ReadU16(&n_contours))) {
       return FONT_COMPRESSION_FAILURE();
     }
 
@@ -485,12 +630,12 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
       }
 
       size_t composite_size;
-      if (PREDICT_FALSE(!SizeOfComposite(composite_stream, &composite_size,
+      if (PREDICT_FALSE(!SizeOfComposite(streams.composite, &composite_size,
                                          &have_instructions))) {
         return FONT_COMPRESSION_FAILURE();
       }
       if (have_instructions) {
-        if (PREDICT_FALSE(!Read255UShort(&glyph_stream, &instruction_size))) {
+        if (PREDICT_FALSE(!Read255UShort(&streams.glyph, &instruction_size))) {
           return FONT_COMPRESSION_FAILURE();
         }
       }
@@ -502,20 +647,20 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
       }
 
       glyph_size = Store16(glyph_buf.get(), glyph_size, n_contours);
-      if (PREDICT_FALSE(!bbox_stream.Read(glyph_buf.get() + glyph_size, 8))) {
+      if (PREDICT_FALSE(!streams.bbox.Read(glyph_buf.get() + glyph_size, 8))) {
         return FONT_COMPRESSION_FAILURE();
       }
       glyph_size += 8;
 
-      if (PREDICT_FALSE(!composite_stream.Read(glyph_buf.get() + glyph_size,
+      if (PREDICT_FALSE(!streams.composite.Read(glyph_buf.get() + glyph_size,
             composite_size))) {
         return FONT_COMPRESSION_FAILURE();
       }
       glyph_size += composite_size;
       if (have_instructions) {
         glyph_size = Store16(glyph_buf.get(), glyph_size, instruction_size);
-        if (PREDICT_FALSE(!instruction_stream.Read(glyph_buf.get() + glyph_size,
-              instruction_size))) {
+        if (PREDICT_FALSE(!streams.instruction.Read(
+              glyph_buf.get() + glyph_size, instruction_size))) {
           return FONT_COMPRESSION_FAILURE();
         }
         glyph_size += instruction_size;
@@ -527,7 +672,7 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
       unsigned int n_points_contour;
       for (unsigned int j = 0; j < n_contours; ++j) {
         if (PREDICT_FALSE(
-            !Read255UShort(&n_points_stream, &n_points_contour))) {
+            !Read255UShort(&streams.n_points, &n_points_contour))) {
           return FONT_COMPRESSION_FAILURE();
         }
         n_points_vec.push_back(n_points_contour);
@@ -538,13 +683,13 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
       }
       unsigned int flag_size = total_n_points;
       if (PREDICT_FALSE(
-          flag_size > flag_stream.length() - flag_stream.offset())) {
+          flag_size > streams.flag.length() - streams.flag.offset())) {
         return FONT_COMPRESSION_FAILURE();
       }
-      const uint8_t* flags_buf = flag_stream.buffer() + flag_stream.offset();
-      const uint8_t* triplet_buf = glyph_stream.buffer() +
-        glyph_stream.offset();
-      size_t triplet_size = glyph_stream.length() - glyph_stream.offset();
+      const uint8_t* flags_buf = streams.flag.buffer() + streams.flag.offset();
+      const uint8_t* triplet_buf = streams.glyph.buffer() +
+        streams.glyph.offset();
+      size_t triplet_size = streams.glyph.length() - streams.glyph.offset();
       size_t triplet_bytes_consumed = 0;
       if (points_size < total_n_points) {
         points_size = total_n_points;
@@ -554,14 +699,14 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
           total_n_points, points.get(), &triplet_bytes_consumed))) {
         return FONT_COMPRESSION_FAILURE();
       }
-      if (PREDICT_FALSE(!flag_stream.Skip(flag_size))) {
+      if (PREDICT_FALSE(!streams.flag.Skip(flag_size))) {
         return FONT_COMPRESSION_FAILURE();
       }
-      if (PREDICT_FALSE(!glyph_stream.Skip(triplet_bytes_consumed))) {
+      if (PREDICT_FALSE(!streams.glyph.Skip(triplet_bytes_consumed))) {
         return FONT_COMPRESSION_FAILURE();
       }
       unsigned int instruction_size;
-      if (PREDICT_FALSE(!Read255UShort(&glyph_stream, &instruction_size))) {
+      if (PREDICT_FALSE(!Read255UShort(&streams.glyph, &instruction_size))) {
         return FONT_COMPRESSION_FAILURE();
       }
 
@@ -578,7 +723,8 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
 
       glyph_size = Store16(glyph_buf.get(), glyph_size, n_contours);
       if (have_bbox) {
-        if (PREDICT_FALSE(!bbox_stream.Read(glyph_buf.get() + glyph_size, 8))) {
+        if (PREDICT_FALSE(!streams.bbox.Read(glyph_buf.get() + glyph_size,
+                                             8))) {
           return FONT_COMPRESSION_FAILURE();
         }
       } else {
@@ -595,8 +741,8 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
       }
 
       glyph_size = Store16(glyph_buf.get(), glyph_size, instruction_size);
-      if (PREDICT_FALSE(!instruction_stream.Read(glyph_buf.get() + glyph_size,
-                                                 instruction_size))) {
+      if (PREDICT_FALSE(!streams.instruction.Read(glyph_buf.get() + glyph_size,
+                                                  instruction_size))) {
         return FONT_COMPRESSION_FAILURE();
       }
       glyph_size += instruction_size;
@@ -630,26 +776,58 @@ bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
     // We may need x_min to reconstruct 'hmtx'
     if (n_contours > 0) {
       Buffer x_min_buf(glyph_buf.get() + 2, 2);
-      if (PREDICT_FALSE(!x_min_buf.ReadS16(&info->x_mins[i]))) {
+      if (PREDICT_FALSE(!x_min_buf.ReadS16(&x_mins[i]))) {
         return FONT_COMPRESSION_FAILURE();
       }
     }
   }
 
+  return true;
+}
+
+// Completes a 'glyf' table whose glyphs have all been written to |out|, and
+// writes the matching 'loca' table after it.
+bool FinishGlyfAndStoreLoca(std::vector<uint32_t>* loca_values,
+                            int index_format, Table* glyf_table,
+                            Table* loca_table, uint32_t* loca_checksum,
+                            WOFF2Out* out) {
   // glyf_table dst_offset was set by ReconstructFont
   glyf_table->dst_length = out->Size() - glyf_table->dst_offset;
   loca_table->dst_offset = out->Size();
   // loca[n] will be equal the length of the glyph data ('glyf') table
-  loca_values[info->num_glyphs] = glyf_table->dst_length;
-  if (PREDICT_FALSE(!StoreLoca(loca_values, info->index_format, loca_checksum,
+  loca_values->back() = glyf_table->dst_length;
+  if (PREDICT_FALSE(!StoreLoca(*loca_values, index_format, loca_checksum,
       out))) {
     return FONT_COMPRESSION_FAILURE();
   }
   loca_table->dst_length = out->Size() - loca_table->dst_offset;
-
   return true;
 }
 
+// Reconstruct entire glyf table based on transformed original
+bool ReconstructGlyf(const uint8_t* data, Table* glyf_table,
+                     uint32_t* glyf_checksum, Table * loca_table,
+                     uint32_t* loca_checksum, WOFF2FontInfo* info,
+                     WOFF2Out* out) {
+  GlyfSource source;
+  if (PREDICT_FALSE(!ReadGlyfSource(data, *glyf_table, *loca_table, 1,
+                                    &source))) {
+    return FONT_COMPRESSION_FAILURE();
+  }
+  info->num_glyphs = source.num_glyphs;
+  info->index_format = source.index_format;
+
+  std::vector<uint32_t> loca_values(info->num_glyphs + 1);
+  info->x_mins.resize(info->num_glyphs);
+  if (PREDICT_FALSE(!ReconstructGlyphRange(source, 0, out->Size(),
+                                           &loca_values[0], info->x_mins.data(),
+                                           glyf_checksum, out))) {
+    return FONT_COMPRESSION_FAILURE();
+  }
+  return FinishGlyfAndStoreLoca(&loca_values, info->index_format, glyf_table,
+                                loca_table, loca_checksum, out);
+}
+
 Table* FindTable(std::vector<Table*>* tables, uint32_t tag) {
   for (Table* table : *tables) {
     if (table->tag == tag) {
@@ -780,6 +958,57 @@ bool Woff2Uncompress(uint8_t* dst_buf, size_t dst_size,
   return true;
 }
 
+// Like Woff2Uncompress(), but decompresses a chunk at a time, and passes each
+// table stored untransformed to |on_table_ready| as soon as all of its data is
+// available. |tables| must be in the order of the compressed stream.
+bool Woff2UncompressStreaming(uint8_t* dst_buf, size_t dst_size,
+    const uint8_t* src_buf, size_t src_size, const std::vector<Table>& tables,
+    const WOFF2TableCallback& on_table_ready) {
+  std::unique_ptr<BrotliDecoderState, void (*)(BrotliDecoderState*)> decoder(
+      BrotliDecoderCreateInstance(NULL, NULL, NULL),
+      BrotliDecoderDestroyInstance);
+  if (PREDICT_FALSE(!decoder)) {
+    return FONT_COMPRESSION_FAILURE();
+  }
+
+  size_t available_in = src_size;
+  const uint8_t* next_in = src_buf;
+  uint8_t* next_out = dst_buf;
+  size_t total_out = 0;
+  size_t next_table = 0;
+  BrotliDecoderResult result = BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT;
+  while (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+    size_t available_out = std::min(kStreamingChunkSize, dst_size - total_out);
+    if (PREDICT_FALSE(available_out == 0)) {
+      // More data than the table directory accounts for.
+      return FONT_COMPRESSION_FAILURE();
+    }
+    result = BrotliDecoderDecompressStream(decoder.get(), &available_in,
+        &next_in, &available_out, &next_out, &total_out);
+
+    for (; next_table < tables.size() &&
+           static_cast<uint64_t>(tables[next_table].src_offset) +
+               tables[next_table].src_length <= total_out;
+         ++next_table) {
+      const Table& table = tables[next_table];
+      if (table.flags & kWoff2FlagsTransform) {
+        continue;
+      }
+      uint8_t* table_data = dst_buf + table.src_offset;
+      if (table.tag == kHeadTableTag && table.src_length >= 12) {
+        // checkSumAdjustment = 0, as ReconstructFont() does.
+        StoreU32(table_data, kCheckSumAdjustmentOffset, 0);
+      }
+      on_table_ready(table.tag, table_data, table.src_length);
+    }
+  }
+  if (PREDICT_FALSE(result != BROTLI_DECODER_RESULT_SUCCESS ||
+                    total_out != dst_size)) {
+    return FONT_COMPRESSION_FAILURE();
+  }
+  return true;
+}
+
 bool ReadTableDirectory(Buffer* file, std::vector<Table>* tables,
     size_t num_tables) {
   uint32_t src_offset = 0;
@@ -891,13 +1120,200 @@ std::vector<Table*> Tables(WOFF2Header* hdr, size_t font_index) {
   return tables;
 }
 
+// Fewest glyphs worth handing to a thread of their own.
+const unsigned int kMinGlyphsPerRange = 128;
+
+// A 'glyf' table reconstructed ahead of ReconstructFont(), so that the glyph
+// ranges of every font in the file can be reconstructed concurrently.
+struct ReconstructedGlyf {
+  GlyfSource source;
+  std::vector<std::string> range_data;
+  std::vector<uint32_t> range_checksums;
+  // Relative to the start of the range each glyph is in.
+  std::vector<uint32_t> loca_values;
+  std::vector<int16_t> x_mins;
+};
+
+typedef std::map<const Table*, ReconstructedGlyf> ReconstructedGlyfMap;
+
+// Tasks shared by the threads of RunInParallel(). Workers posted with a
+// WOFF2PostTask may only start after RunInParallel() returned, so they own a
+// reference to this, and only call |task| while the caller waits for them.
+class ParallelTasks {
+ public:
+  ParallelTasks(size_t num_tasks, const std::function<bool(size_t)>& task)
+      : num_tasks_(num_tasks), task_(task), next_task_(0), running_(0),
+        failed_(false) {}
+
+  void Run() {
+    for (;;) {
+      size_t i;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (next_task_ >= num_tasks_ || failed_) {
+          return;
+        }
+        i = next_task_++;
+        running_++;
+      }
+      const bool ok = task_(i);
+      std::lock_guard<std::mutex> lock(mutex_);
+      failed_ = failed_ || !ok;
+      if (--running_ == 0) {
+        done_.notify_all();
+      }
+    }
+  }
+
+  // Waits for the tasks started by other threads, once Run() returned on the
+  // calling one. Returns false if any task failed.
+  bool Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return running_ == 0; });
+    return !failed_;
+  }
+
+ private:
+  const size_t num_tasks_;
+  const std::function<bool(size_t)> task_;
+  std::mutex mutex_;
+  std::condition_variable done_;
+  size_t next_task_;
+  size_t running_;
+  bool failed_;
+};
+
+// Runs |task| for every index below |num_tasks|, on up to |num_threads|
+// threads including the calling one, borrowed with |post_task| if set. Returns
+// false if any task failed, in which case the remaining tasks may not have run.
+bool RunInParallel(size_t num_tasks, int num_threads,
+                   const WOFF2PostTask& post_task,
+                   const std::function<bool(size_t)>& task) {
+  std::shared_ptr<ParallelTasks> tasks =
+      std::make_shared<ParallelTasks>(num_tasks, task);
+
+  std::vector<std::thread> threads;
+  const size_t num_workers =
+      std::min(num_tasks, static_cast<size_t>(std::max(num_threads, 1)));
+  for (size_t i = 1; i < num_workers; ++i) {
+    if (post_task) {
+      post_task([tasks]() { tasks->Run(); });
+    } else {
+      threads.emplace_back([tasks]() { tasks->Run(); });
+    }
+  }
+  tasks->Run();
+  const bool ok = tasks->Wait();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return ok;
+}
+
+// Reconstructs every transformed 'glyf' table of the file in |glyfs|, using
+// |num_threads| threads borrowed with |post_task| if set. Fonts that
+// ReconstructFont() will reject are skipped.
+bool ReconstructGlyfsInParallel(const uint8_t* transformed_buf,
+                                uint32_t transformed_buf_size,
+                                WOFF2Header* hdr, int num_threads,
+                                const WOFF2PostTask& post_task,
+                                ReconstructedGlyfMap* glyfs) {
+  const size_t num_fonts =
+      hdr->header_version ? hdr->ttc_fonts.size() : 1;
+  std::vector<std::pair<ReconstructedGlyf*, size_t> > tasks;
+  for (size_t font_index = 0; font_index < num_fonts; font_index++) {
+    std::vector<Table*> tables = Tables(hdr, font_index);
+    const Table* glyf_table = FindTable(&tables, kGlyfTableTag);
+    const Table* loca_table = FindTable(&tables, kLocaTableTag);
+    if (!glyf_table || !loca_table ||
+        !(glyf_table->flags & kWoff2FlagsTransform) ||
+        !(loca_table->flags & kWoff2FlagsTransform) ||
+        glyfs->count(glyf_table) ||
+        static_cast<uint64_t>(glyf_table->src_offset) + glyf_table->src_length
+            > transformed_buf_size) {
+      continue;
+    }
+
+    ReconstructedGlyf* glyf = &(*glyfs)[glyf_table];
+    // The glyph count is only known once the header is read, so read it
+    // twice rather than guessing how many ranges to ask for.
+    if (PREDICT_FALSE(!ReadGlyfSource(transformed_buf + glyf_table->src_offset,
+                                      *glyf_table, *loca_table, 1,
+                                      &glyf->source))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+    const unsigned int num_ranges = std::max(1u, std::min(
+        glyf->source.num_glyphs / kMinGlyphsPerRange,
+        4u * static_cast<unsigned int>(num_threads)));
+    if (num_ranges > 1 &&
+        PREDICT_FALSE(!ReadGlyfSource(transformed_buf + glyf_table->src_offset,
+                                      *glyf_table, *loca_table, num_ranges,
+                                      &glyf->source))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+
+    const size_t actual_ranges = glyf->source.range_streams.size();
+    glyf->range_data.resize(actual_ranges);
+    glyf->range_checksums.resize(actual_ranges, 0);
+    glyf->loca_values.resize(glyf->source.num_glyphs + 1);
+    glyf->x_mins.resize(glyf->source.num_glyphs);
+    for (size_t range = 0; range < actual_ranges; ++range) {
+      tasks.push_back(std::make_pair(glyf, range));
+    }
+  }
+
+  return RunInParallel(
+      tasks.size(), num_threads, post_task, [&tasks](size_t i) {
+        ReconstructedGlyf* glyf = tasks[i].first;
+        const size_t range = tasks[i].second;
+        WOFF2StringOut out(&glyf->range_data[range]);
+        return ReconstructGlyphRange(glyf->source, range, 0,
+                                     &glyf->loca_values[0],
+                                     glyf->x_mins.data(),
+                                     &glyf->range_checksums[range], &out);
+      });
+}
+
+// Writes a 'glyf' table built by ReconstructGlyfsInParallel(), and its 'loca'
+// table. Equivalent to ReconstructGlyf().
+bool WriteReconstructedGlyf(ReconstructedGlyf* glyf, Table* glyf_table,
+                            uint32_t* glyf_checksum, Table* loca_table,
+                            uint32_t* loca_checksum, WOFF2FontInfo* info,
+                            WOFF2Out* out) {
+  const GlyfSource& source = glyf->source;
+  info->num_glyphs = source.num_glyphs;
+  info->index_format = source.index_format;
+  info->x_mins.swap(glyf->x_mins);
+
+  const size_t glyf_start = out->Size();
+  for (size_t range = 0; range < glyf->range_data.size(); ++range) {
+    const uint32_t range_offset = out->Size() - glyf_start;
+    for (unsigned int i = source.range_starts[range];
+         i < source.range_starts[range + 1]; ++i) {
+      glyf->loca_values[i] += range_offset;
+    }
+    const std::string& data = glyf->range_data[range];
+    if (PREDICT_FALSE(!out->Write(data.data(), data.size()))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+    *glyf_checksum += glyf->range_checksums[range];
+  }
+  return FinishGlyfAndStoreLoca(&glyf->loca_values, info->index_format,
+                                glyf_table, loca_table, loca_checksum, out);
+}
+
 // Offset tables assumed to have been written in with 0's initially.
 // WOFF2Header isn't const so we can use [] instead of at() (which upsets FF)
+// |reconstructed_glyfs| holds the 'glyf' tables already rebuilt by
+// ReconstructGlyfsInParallel(), or is NULL. Time spent on 'glyf' is added to
+// |glyf_ms| if it is not NULL.
 bool ReconstructFont(uint8_t* transformed_buf,
                      const uint32_t transformed_buf_size,
                      RebuildMetadata* metadata,
                      WOFF2Header* hdr,
                      size_t font_index,
+                     ReconstructedGlyfMap* reconstructed_glyfs,
+                     double* glyf_ms,
                      WOFF2Out* out) {
   size_t dest_offset = out->Size();
   uint8_t table_entry[12];
@@ -975,12 +1391,23 @@ bool ReconstructFont(uint8_t* transformed_buf,
       } else {
         if (table.tag == kGlyfTableTag) {
           table.dst_offset = dest_offset;
+          const Clock::time_point glyf_start = Clock::now();
 
           Table* loca_table = FindTable(&tables, kLocaTableTag);
-          if (PREDICT_FALSE(!ReconstructGlyf(transformed_buf + table.src_offset,
-              &table, &checksum, loca_table, &loca_checksum, info, out))) {
+          if (reconstructed_glyfs && reconstructed_glyfs->count(&table)) {
+            if (PREDICT_FALSE(!WriteReconstructedGlyf(
+                &(*reconstructed_glyfs)[&table], &table, &checksum, loca_table,
+                &loca_checksum, info, out))) {
+              return FONT_COMPRESSION_FAILURE();
+            }
+          } else if (PREDICT_FALSE(!ReconstructGlyf(
+              transformed_buf + table.src_offset, &table, &checksum,
+              loca_table, &loca_checksum, info, out))) {
             return FONT_COMPRESSION_FAILURE();
           }
+          if (glyf_ms) {
+            *glyf_ms += MillisecondsSince(glyf_start);
+          }
         } else if (table.tag == kLocaTableTag) {
           // All the work was done by ReconstructGlyf. We already know checksum.
           checksum = loca_checksum;
@@ -1328,6 +1755,13 @@ bool ConvertWOFF2ToTTF(uint8_t *result, size_t result_length,
 
 bool ConvertWOFF2ToTTF(const uint8_t* data, size_t length,
                        WOFF2Out* out) {
+  return ConvertWOFF2ToTTF(data, length, out, WOFF2DecodeParams());
+}
+
+bool ConvertWOFF2ToTTF(const uint8_t* data, size_t length,
+                       WOFF2Out* out, const WOFF2DecodeParams& params) {
+  const Clock::time_point start = Clock::now();
+  WOFF2DecodeTimings timings;
   RebuildMetadata metadata;
   WOFF2Header hdr;
   if (!ReadWOFF2Header(data, length, &hdr)) {
@@ -1337,6 +1771,7 @@ bool ConvertWOFF2ToTTF(const uint8_t* data, size_t length,
   if (!WriteHeaders(data, length, &metadata, &hdr, out)) {
     return FONT_COMPRESSION_FAILURE();
   }
+  timings.header_ms = MillisecondsSince(start);
 
   const float compression_ratio = (float) hdr.uncompressed_size / length;
   if (compression_ratio > kMaxPlausibleCompressionRatio) {
@@ -1351,20 +1786,49 @@ bool ConvertWOFF2ToTTF(const uint8_t* data, size_t length,
   if (PREDICT_FALSE(hdr.uncompressed_size < 1)) {
     return FONT_COMPRESSION_FAILURE();
   }
-  if (PREDICT_FALSE(!Woff2Uncompress(&uncompressed_buf[0],
-                                     hdr.uncompressed_size, src_buf,
-                                     hdr.compressed_length))) {
+  const Clock::time_point uncompress_start = Clock::now();
+  if (params.on_table_ready) {
+    if (PREDICT_FALSE(!Woff2UncompressStreaming(&uncompressed_buf[0],
+                                                hdr.uncompressed_size, src_buf,
+                                                hdr.compressed_length,
+                                                hdr.tables,
+                                                params.on_table_ready))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+  } else if (PREDICT_FALSE(!Woff2Uncompress(&uncompressed_buf[0],
+                                            hdr.uncompressed_size, src_buf,
+                                            hdr.compressed_length))) {
     return FONT_COMPRESSION_FAILURE();
   }
+  timings.uncompress_ms = MillisecondsSince(uncompress_start);
+
+  ReconstructedGlyfMap reconstructed_glyfs;
+  if (params.num_threads > 1) {
+    const Clock::time_point glyf_start = Clock::now();
+    if (PREDICT_FALSE(!ReconstructGlyfsInParallel(&uncompressed_buf[0],
+                                                  hdr.uncompressed_size, &hdr,
+                                                  params.num_threads,
+                                                  params.post_task,
+                                                  &reconstructed_glyfs))) {
+      return FONT_COMPRESSION_FAILURE();
+    }
+    timings.glyf_ms = MillisecondsSince(glyf_start);
+  }
 
   for (size_t i = 0; i < metadata.font_infos.size(); i++) {
     if (PREDICT_FALSE(!ReconstructFont(&uncompressed_buf[0],
                                        hdr.uncompressed_size,
-                                       &metadata, &hdr, i, out))) {
+                                       &metadata, &hdr, i,
+                                       &reconstructed_glyfs,
+                                       &timings.glyf_ms, out))) {
       return FONT_COMPRESSION_FAILURE();
     }
   }
 
+  timings.total_ms = MillisecondsSince(start);
+  if (params.timings) {
+    *params.timings = timings;
+  }
   return true;
 }
 
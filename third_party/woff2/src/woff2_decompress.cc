@@ -7,31 +7,103 @@
 /* A very simple commandline tool for decompressing woff2 format files to true
    type font files. */
 
+#include <stdlib.h>
+#include <string.h>
 #include <string>
 
 #include "./file.h"
 #include <woff2/decode.h>
 
 
+namespace {
+
+void PrintUsage() {
+  fprintf(stderr,
+          "Usage: woff2_decompress [-t threads] [-b iterations] file.woff2\n"
+          "  -t  Number of threads reconstructing 'glyf' tables (default 1).\n"
+          "  -b  Decompress the file this many times, report the throughput\n"
+          "      and the time spent in each phase, and write no output.\n");
+}
+
+// Decompresses |input| |iterations| times and prints the average timings.
+bool RunBenchmark(const std::string& input, int iterations,
+                  const woff2::WOFF2DecodeParams& base_params) {
+  const uint8_t* raw_input = reinterpret_cast<const uint8_t*>(input.data());
+  std::string output(std::min(woff2::ComputeWOFF2FinalSize(raw_input,
+                                                           input.size()),
+                              woff2::kDefaultMaxSize), 0);
+  woff2::WOFF2DecodeParams params = base_params;
+  woff2::WOFF2DecodeTimings timings;
+  params.timings = &timings;
+  woff2::WOFF2DecodeTimings sum;
+  size_t output_size = 0;
+  for (int i = 0; i < iterations; ++i) {
+    woff2::WOFF2StringOut out(&output);
+    if (!woff2::ConvertWOFF2ToTTF(raw_input, input.size(), &out, params)) {
+      fprintf(stderr, "Decompression failed.\n");
+      return false;
+    }
+    output_size = out.Size();
+    sum.header_ms += timings.header_ms;
+    sum.uncompress_ms += timings.uncompress_ms;
+    sum.glyf_ms += timings.glyf_ms;
+    sum.total_ms += timings.total_ms;
+  }
+
+  const double other_ms =
+      sum.total_ms - sum.header_ms - sum.uncompress_ms - sum.glyf_ms;
+  printf("threads:     %d\n", params.num_threads);
+  printf("output:      %zu bytes\n", output_size);
+  printf("throughput:  %.1f MB/s\n",
+         static_cast<double>(output_size) * iterations / 1e6 /
+             (sum.total_ms / 1000));
+  printf("header:      %.3f ms\n", sum.header_ms / iterations);
+  printf("uncompress:  %.3f ms\n", sum.uncompress_ms / iterations);
+  printf("glyf:        %.3f ms\n", sum.glyf_ms / iterations);
+  printf("other:       %.3f ms\n", other_ms / iterations);
+  printf("total:       %.3f ms\n", sum.total_ms / iterations);
+  return true;
+}
+
+}  // namespace
+
 int main(int argc, char **argv) {
   using std::string;
 
-  if (argc != 2) {
+  woff2::WOFF2DecodeParams params;
+  int iterations = 0;
+  int arg = 1;
+  for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+    if (strcmp(argv[arg], "-t") == 0) {
+      params.num_threads = atoi(argv[arg + 1]);
+    } else if (strcmp(argv[arg], "-b") == 0) {
+      iterations = atoi(argv[arg + 1]);
+    } else {
+      break;
+    }
+  }
+  if (arg + 1 != argc || params.num_threads < 1 || iterations < 0) {
     fprintf(stderr, "One argument, the input filename, must be provided.\n");
+    PrintUsage();
     return 1;
   }
 
-  string filename(argv[1]);
+  string filename(argv[arg]);
   string outfilename = filename.substr(0, filename.find_last_of(".")) + ".ttf";
 
   // Note: update woff2_dec_fuzzer_new_entry.cc if this pattern changes.
   string input = woff2::GetFileContent(filename);
+  if (iterations > 0) {
+    return RunBenchmark(input, iterations, params) ? 0 : 1;
+  }
+
   const uint8_t* raw_input = reinterpret_cast<const uint8_t*>(input.data());
   string output(std::min(woff2::ComputeWOFF2FinalSize(raw_input, input.size()),
                          woff2::kDefaultMaxSize), 0);
   woff2::WOFF2StringOut out(&output);
 
-  const bool ok = woff2::ConvertWOFF2ToTTF(raw_input, input.size(), &out);
+  const bool ok = woff2::ConvertWOFF2ToTTF(raw_input, input.size(), &out,
+                                           params);
 
   if (ok) {
     woff2::SetFileContents(outfilename, output.begin(),
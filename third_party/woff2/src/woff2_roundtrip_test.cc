@@ -0,0 +1,197 @@
+/* Copyright 2021 Google Inc. All Rights Reserved.
+
+   Distributed under MIT license.
+   See file LICENSE for detail or copy at https://opensource.org/licenses/MIT
+*/
+
+/* Checks that the threaded decoder gives the same fonts as the serial one.
+
+   Every font given on the command line, and a collection of all of them, is
+   compressed to WOFF2, then decompressed serially and with several thread
+   counts. Exits with a non-zero status if any output differs. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./file.h"
+#include "./round.h"
+#include "./store_bytes.h"
+#include "./woff2_common.h"
+#include <woff2/decode.h>
+#include <woff2/encode.h>
+#include <woff2/output.h>
+
+
+namespace {
+
+const int kThreadCounts[] = {2, 3, 4, 8, 16};
+
+uint32_t Read32(const std::string& data, size_t offset) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data()) + offset;
+  return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) |
+         p[3];
+}
+
+uint16_t Read16(const std::string& data, size_t offset) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data()) + offset;
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// Builds a TrueType collection holding a copy of each of |fonts|, which must
+// be single fonts. Returns an empty string if a font is malformed.
+std::string BuildCollection(const std::vector<std::string>& fonts) {
+  const size_t header_size = 12 + 4 * fonts.size();
+  size_t directories_size = 0;
+  for (const std::string& font : fonts) {
+    if (font.size() < 12 || Read32(font, 0) == woff2::kTtcFontFlavor) {
+      return std::string();
+    }
+    directories_size += 12 + 16 * Read16(font, 4);
+  }
+
+  std::vector<uint8_t> ttc(header_size + directories_size);
+  size_t offset = 0;
+  woff2::StoreU32(woff2::kTtcFontFlavor, &offset, &ttc[0]);
+  woff2::StoreU32(0x00010000, &offset, &ttc[0]);
+  woff2::StoreU32(static_cast<uint32_t>(fonts.size()), &offset, &ttc[0]);
+
+  size_t directory_offset = header_size;
+  for (const std::string& font : fonts) {
+    woff2::StoreU32(static_cast<uint32_t>(directory_offset), &offset,
+                    &ttc[0]);
+    const uint16_t num_tables = Read16(font, 4);
+    if (font.size() < 12 + 16 * static_cast<size_t>(num_tables)) {
+      return std::string();
+    }
+    // The offset table is unchanged, the table records point to the copies of
+    // the tables appended to the collection.
+    memcpy(&ttc[directory_offset], font.data(), 12);
+    for (uint16_t i = 0; i < num_tables; ++i) {
+      const size_t record = 12 + 16 * i;
+      const uint32_t table_offset = Read32(font, record + 8);
+      const uint32_t table_length = Read32(font, record + 12);
+      if (static_cast<size_t>(table_offset) + table_length > font.size()) {
+        return std::string();
+      }
+      memcpy(&ttc[directory_offset + record], font.data() + record, 8);
+      size_t record_offset = directory_offset + record + 8;
+      woff2::StoreU32(static_cast<uint32_t>(ttc.size()), &record_offset,
+                      &ttc[0]);
+      woff2::StoreU32(table_length, &record_offset, &ttc[0]);
+      ttc.insert(ttc.end(), font.data() + table_offset,
+                 font.data() + table_offset + table_length);
+      ttc.resize(woff2::Round4(ttc.size()));
+    }
+    directory_offset += 12 + 16 * num_tables;
+  }
+  return std::string(ttc.begin(), ttc.end());
+}
+
+bool Decode(const std::string& woff2_data,
+            const woff2::WOFF2DecodeParams* params, std::string* result) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(woff2_data.data());
+  result->assign(std::min(woff2::ComputeWOFF2FinalSize(data,
+                                                       woff2_data.size()),
+                          woff2::kDefaultMaxSize), 0);
+  woff2::WOFF2StringOut out(result);
+  const bool ok =
+      params ? woff2::ConvertWOFF2ToTTF(data, woff2_data.size(), &out, *params)
+             : woff2::ConvertWOFF2ToTTF(data, woff2_data.size(), &out);
+  result->resize(out.Size());
+  return ok;
+}
+
+// Returns the number of decodings which differ from the serial one.
+int CheckFont(const std::string& name, const std::string& font) {
+  const uint8_t* font_data = reinterpret_cast<const uint8_t*>(font.data());
+  std::string woff2_data(woff2::MaxWOFF2CompressedSize(font_data, font.size()),
+                         0);
+  size_t woff2_size = woff2_data.size();
+  if (!woff2::ConvertTTFToWOFF2(
+          font_data, font.size(),
+          reinterpret_cast<uint8_t*>(&woff2_data[0]), &woff2_size)) {
+    fprintf(stderr, "%s: compression failed.\n", name.c_str());
+    return 1;
+  }
+  woff2_data.resize(woff2_size);
+
+  std::string expected;
+  if (!Decode(woff2_data, NULL, &expected)) {
+    fprintf(stderr, "%s: serial decompression failed.\n", name.c_str());
+    return 1;
+  }
+
+  int failures = 0;
+  for (int num_threads : kThreadCounts) {
+    for (int variant = 0; variant < 3; ++variant) {
+      woff2::WOFF2DecodeParams params;
+      params.num_threads = num_threads;
+      size_t reported_tables = 0;
+      std::vector<std::thread> posted_threads;
+      const char* variant_name = "threads";
+      if (variant == 1) {
+        variant_name = "threads and on_table_ready";
+        params.on_table_ready = [&reported_tables](uint32_t, const uint8_t*,
+                                                   size_t) {
+          reported_tables++;
+        };
+      } else if (variant == 2) {
+        variant_name = "post_task";
+        params.post_task = [&posted_threads](std::function<void()> task) {
+          posted_threads.emplace_back(task);
+        };
+      }
+
+      std::string actual;
+      const bool ok = Decode(woff2_data, &params, &actual);
+      for (std::thread& thread : posted_threads) {
+        thread.join();
+      }
+      if (!ok || actual != expected ||
+          (params.on_table_ready && !reported_tables)) {
+        fprintf(stderr, "%s: %s decompression with %d threads differs.\n",
+                name.c_str(), variant_name, num_threads);
+        failures++;
+      }
+    }
+  }
+  printf("%s: %zu bytes, %s\n", name.c_str(), expected.size(),
+         failures ? "FAILED" : "ok");
+  return failures;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: woff2_roundtrip_test font.ttf [font.ttf ...]\n");
+    return 1;
+  }
+
+  int failures = 0;
+  std::vector<std::string> single_fonts;
+  for (int i = 1; i < argc; ++i) {
+    std::string font = woff2::GetFileContent(argv[i]);
+    failures += CheckFont(argv[i], font);
+    if (font.size() >= 4 && Read32(font, 0) != woff2::kTtcFontFlavor) {
+      single_fonts.push_back(font);
+    }
+  }
+
+  if (!single_fonts.empty()) {
+    std::string collection = BuildCollection(single_fonts);
+    if (collection.empty()) {
+      fprintf(stderr, "Cannot build a collection of the fonts.\n");
+      failures++;
+    } else {
+      failures += CheckFont("collection", collection);
+    }
+  }
+  return failures ? 1 : 0;
+}
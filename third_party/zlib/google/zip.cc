@@ -145,6 +145,7 @@ bool Zip(const ZipParams& params) {
                                   params.progress_period);
   zip_writer->SetRecursive(params.recursive);
   zip_writer->ContinueOnError(params.continue_on_error);
+  zip_writer->SetNumWorkers(params.num_workers);
 
   if (!params.include_hidden_files || params.filter_callback)
     zip_writer->SetFilterCallback(base::BindRepeating(
@@ -137,6 +137,12 @@ struct ZipParams {
 
   // Should ignore errors when discovering files and zipping them?
   bool continue_on_error = false;
+
+  // Number of worker threads used to deflate file entries. If greater than 1,
+  // file entries (and chunks of big file entries) are compressed in parallel
+  // and then written to the ZIP file in order. Otherwise, all the entries are
+  // compressed on the calling thread. Values greater than 64 are treated as 64.
+  int num_workers = 0;
 };
 
 // Zip files specified into a ZIP archives. The source files and ZIP destination
@@ -354,7 +354,8 @@ zipFile OpenFdForZipping(int zip_fd, int append_flag) {
 bool ZipOpenNewFileInZip(zipFile zip_file,
                          const std::string& str_path,
                          base::Time last_modified_time,
-                         Compression compression) {
+                         Compression compression,
+                         bool raw) {
   // Section 4.4.4 http://www.pkware.com/documents/casestudies/APPNOTE.TXT
   // Setting the Language encoding flag so the file is told to be in utf-8.
   const uLong LANGUAGE_ENCODING_FLAG = 0x1 << 11;
@@ -371,7 +372,7 @@ bool ZipOpenNewFileInZip(zipFile zip_file,
       /*comment=*/nullptr,
       /*method=*/compression,
       /*level=*/Z_DEFAULT_COMPRESSION,
-      /*raw=*/0,
+      /*raw=*/raw ? 1 : 0,
       /*windowBits=*/-MAX_WBITS,
       /*memLevel=*/DEF_MEM_LEVEL,
       /*strategy=*/Z_DEFAULT_STRATEGY,
@@ -66,11 +66,14 @@ enum Compression {
   kDeflated = Z_DEFLATED,  // Deflated
 };
 
-// Adds a file (or directory) entry to the ZIP archive.
+// Adds a file (or directory) entry to the ZIP archive. If |raw| is true, the
+// data written to this entry must already be compressed with |compression|,
+// and the entry must be closed with zipCloseFileInZipRaw64().
 bool ZipOpenNewFileInZip(zipFile zip_file,
                          const std::string& str_path,
                          base::Time last_modified_time,
-                         Compression compression);
+                         Compression compression,
+                         bool raw);
 
 // Selects the best compression method for the given file. The heuristic is
 // based on the filename extension. By default, the compression method is
@@ -749,6 +749,60 @@ TEST_F(ZipTest, Compressed) {
   EXPECT_LT(dest_file_size, 1000);
 }
 
+// Tests that files deflated by several workers, including files bigger than
+// the chunks they are split into, can be unzipped back.
+TEST_F(ZipTest, ZipWithWorkers) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  const base::FilePath src_dir = temp_dir.GetPath().AppendASCII("input");
+  EXPECT_TRUE(base::CreateDirectory(src_dir.AppendASCII("sub")));
+
+  // Create source files of various sizes, with contents compressing somewhat.
+  for (const int size : {0, 1, 5000, 128 * 1024, 1'000'000}) {
+    std::string contents;
+    for (int i = 0; contents.size() < static_cast<size_t>(size); i++)
+      contents += base::StringPrintf("%d %d\n", i, i % 1000);
+    contents.resize(size);
+
+    const std::string name = base::StringPrintf("file%d.txt", size);
+    EXPECT_TRUE(base::WriteFile(src_dir.AppendASCII(name), contents));
+    EXPECT_TRUE(base::WriteFile(src_dir.AppendASCII("sub").AppendASCII(name),
+                                contents));
+  }
+
+  // A stored file between deflated ones.
+  EXPECT_TRUE(base::WriteFile(src_dir.AppendASCII("stored.zip"), "not a zip"));
+
+  // A worker count above the limit is clamped and still produces a valid ZIP.
+  for (const int num_workers : {4, 1000}) {
+    SCOPED_TRACE(base::StringPrintf("%d workers", num_workers));
+
+    const base::FilePath dest_file = temp_dir.GetPath().AppendASCII(
+        base::StringPrintf("dest%d.zip", num_workers));
+    EXPECT_TRUE(zip::Zip({.src_dir = src_dir,
+                          .dest_file = dest_file,
+                          .num_workers = num_workers}));
+
+    const base::FilePath out_dir = temp_dir.GetPath().AppendASCII(
+        base::StringPrintf("output%d", num_workers));
+    ASSERT_TRUE(zip::Unzip(dest_file, out_dir));
+
+    base::FileEnumerator files(src_dir, true, base::FileEnumerator::FILES);
+    int count = 0;
+    for (base::FilePath path = files.Next(); !path.empty();
+         path = files.Next()) {
+      base::FilePath relative_path;
+      ASSERT_TRUE(src_dir.AppendRelativePath(path, &relative_path));
+      EXPECT_TRUE(base::ContentsEqual(path, out_dir.Append(relative_path)))
+          << "Different contents for " << relative_path;
+      count++;
+    }
+
+    EXPECT_EQ(count, 11);
+  }
+}
+
 // Tests that a ZIP put inside a ZIP is simply stored instead of being
 // compressed.
 TEST_F(ZipTest, NestedZip) {
@@ -5,11 +5,14 @@
 #include "third_party/zlib/google/zip_writer.h"
 
 #include <algorithm>
+#include <string>
 
 #include "base/files/file.h"
 #include "base/logging.h"
 #include "base/strings/strcat.h"
 #include "base/strings/string_util.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
 #include "third_party/zlib/google/zip_internal.h"
 
 namespace zip {
@@ -27,6 +30,138 @@ class Redact {
   const base::FilePath& path_;
 };
 
+namespace {
+
+// Size of the chunks file contents are split into when deflated by worker
+// threads. Same default block size as pigz.
+constexpr size_t kDeflateChunkSize = 128 * 1024;
+
+// Size of the DEFLATE sliding window. Each chunk is deflated with the last
+// kDeflateWindowSize bytes of the previous chunk as a preset dictionary, so
+// that parallel compression costs very little compression ratio.
+constexpr size_t kDeflateWindowSize = 1 << MAX_WBITS;
+
+// Maximum number of chunks queued per worker thread. Bounds the memory used to
+// buffer the chunks that haven't been written to the ZIP file yet.
+constexpr size_t kMaxPendingJobsPerWorker = 4;
+
+// Maximum number of worker threads. Bounds the number of threads started and,
+// with kMaxPendingJobsPerWorker, the memory used by the queued chunks.
+constexpr int kMaxWorkers = 64;
+
+}  // namespace
+
+// A chunk of file contents deflated on a worker thread into a raw DEFLATE
+// fragment. Fragments of non-final chunks end on a byte boundary with an empty
+// stored block (Z_SYNC_FLUSH), so that the fragments of all the chunks of a
+// file can simply be concatenated into a single valid DEFLATE stream.
+class DeflateJob : public base::DelegateSimpleThread::Delegate {
+ public:
+  // |entry_path| is empty, unless this is the first chunk of a file entry.
+  DeflateJob(base::FilePath entry_path,
+             base::Time entry_last_modified,
+             std::string input,
+             std::string dictionary,
+             bool is_last)
+      : entry_path_(std::move(entry_path)),
+        entry_last_modified_(entry_last_modified),
+        input_(std::move(input)),
+        dictionary_(std::move(dictionary)),
+        is_last_(is_last) {}
+
+  DeflateJob(const DeflateJob&) = delete;
+  DeflateJob& operator=(const DeflateJob&) = delete;
+
+  ~DeflateJob() override = default;
+
+  // Deflates the input chunk. Called on a worker thread.
+  void Run() override {
+    input_size_ = input_.size();
+    crc_ = crc32(crc32(0L, Z_NULL, 0),
+                 reinterpret_cast<const Bytef*>(input_.data()), input_.size());
+    success_ = Deflate();
+
+    // Release the input as early as possible.
+    std::string().swap(input_);
+    std::string().swap(dictionary_);
+    done_.Signal();
+  }
+
+  // Waits until Run() has completed. Returns true if the chunk was
+  // successfully deflated.
+  bool Wait() {
+    done_.Wait();
+    return success_;
+  }
+
+  // Accessors only valid after Wait() returned.
+  const std::string& output() const { return output_; }
+  size_t input_size() const { return input_size_; }
+  uint32_t crc() const { return crc_; }
+  bool is_last() const { return is_last_; }
+  const base::FilePath& entry_path() const { return entry_path_; }
+  base::Time entry_last_modified() const { return entry_last_modified_; }
+
+ private:
+  bool Deflate() {
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+      return false;
+    }
+
+    if (!dictionary_.empty() &&
+        deflateSetDictionary(
+            &stream, reinterpret_cast<const Bytef*>(dictionary_.data()),
+            dictionary_.size()) != Z_OK) {
+      deflateEnd(&stream);
+      return false;
+    }
+
+    // deflateBound() does not account for the empty stored block emitted by
+    // Z_SYNC_FLUSH, hence the extra margin.
+    output_.resize(deflateBound(&stream, input_.size()) + 16);
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(input_.data()));
+    stream.avail_in = input_.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&output_[0]);
+    stream.avail_out = output_.size();
+
+    const int err = deflate(&stream, is_last_ ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool ok = stream.avail_in == 0 && stream.avail_out != 0 &&
+                    err == (is_last_ ? Z_STREAM_END : Z_OK);
+    output_.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (!ok)
+      DLOG(ERROR) << "Cannot deflate chunk: deflate returned " << err;
+
+    return ok;
+  }
+
+  // Path and last modification time of the file entry starting with this
+  // chunk.
+  const base::FilePath entry_path_;
+  const base::Time entry_last_modified_;
+
+  // Uncompressed data and preset dictionary. Released once deflated.
+  std::string input_;
+  std::string dictionary_;
+
+  // Is it the last chunk of the file entry?
+  const bool is_last_;
+
+  // Raw DEFLATE fragment.
+  std::string output_;
+
+  size_t input_size_ = 0;
+  uint32_t crc_ = 0;
+  bool success_ = false;
+
+  // Signaled once Run() has completed.
+  base::WaitableEvent done_;
+};
+
 bool ZipWriter::ShouldContinue() {
   if (!progress_callback_)
     return true;
@@ -72,7 +207,8 @@ bool ZipWriter::AddFileContent(const base::FilePath& path, base::File file) {
 
 bool ZipWriter::OpenNewFileEntry(const base::FilePath& path,
                                  bool is_directory,
-                                 base::Time last_modified) {
+                                 base::Time last_modified,
+                                 bool raw) {
   std::string str_path = path.AsUTF8Unsafe();
 
 #if defined(OS_WIN)
@@ -83,25 +219,169 @@ bool ZipWriter::OpenNewFileEntry(const base::FilePath& path,
 
   if (is_directory) {
     str_path += "/";
-  } else {
+  } else if (!raw) {
     compression = GetCompressionMethod(path);
   }
 
   return zip::internal::ZipOpenNewFileInZip(zip_file_, str_path, last_modified,
-                                            compression);
+                                            compression, raw);
 }
 
 bool ZipWriter::CloseNewFileEntry() {
   return zipCloseFileInZip(zip_file_) == ZIP_OK;
 }
 
+bool ZipWriter::CloseNewRawFileEntry(const uint64_t uncompressed_size,
+                                     const uint32_t crc) {
+  return zipCloseFileInZipRaw64(zip_file_, uncompressed_size, crc) == ZIP_OK;
+}
+
+void ZipWriter::SetNumWorkers(const int n) {
+  DCHECK(!workers_);
+  DCHECK(pending_jobs_.empty());
+
+  if (n <= 1)
+    return;
+
+  const int num_workers = std::min(n, kMaxWorkers);
+  workers_ = std::make_unique<base::DelegateSimpleThreadPool>("ZipWriter",
+                                                              num_workers);
+  workers_->Start();
+  max_pending_jobs_ = num_workers * kMaxPendingJobsPerWorker;
+}
+
+void ZipWriter::JoinWorkers() {
+  if (!workers_)
+    return;
+
+  // Wait for the jobs still running before destroying them.
+  workers_->JoinAll();
+  workers_.reset();
+  pending_jobs_.clear();
+}
+
+bool ZipWriter::QueueFileEntry(const base::FilePath& path,
+                               base::File file,
+                               const base::Time last_modified) {
+  DCHECK(workers_);
+  base::FilePath entry_path = path;
+  std::string dictionary;
+
+  while (ShouldContinue()) {
+    // Read a whole chunk, unless the end of the file is reached.
+    std::string chunk(kDeflateChunkSize, '\0');
+    size_t chunk_size = 0;
+    while (chunk_size < chunk.size()) {
+      const int num_bytes = file.ReadAtCurrentPos(
+          &chunk[chunk_size], static_cast<int>(chunk.size() - chunk_size));
+
+      if (num_bytes < 0) {
+        PLOG(ERROR) << "Cannot read file " << Redact(path);
+        return false;
+      }
+
+      if (num_bytes == 0)
+        break;
+
+      chunk_size += num_bytes;
+    }
+
+    chunk.resize(chunk_size);
+    progress_.bytes += chunk_size;
+
+    // An empty last chunk still produces a final DEFLATE block, so that each
+    // file entry is a complete DEFLATE stream.
+    const bool is_last = chunk_size < kDeflateChunkSize;
+
+    // The next chunk is primed with the last bytes of the current one.
+    std::string next_dictionary;
+    if (!is_last) {
+      next_dictionary.assign(chunk, chunk_size - kDeflateWindowSize,
+                             kDeflateWindowSize);
+    }
+
+    std::unique_ptr<DeflateJob>& job =
+        pending_jobs_.emplace_back(std::make_unique<DeflateJob>(
+            std::move(entry_path), last_modified, std::move(chunk),
+            std::move(dictionary), is_last));
+    workers_->AddWork(job.get());
+    entry_path.clear();
+    dictionary = std::move(next_dictionary);
+
+    // Write the oldest jobs to bound the memory used by the queued chunks.
+    while (pending_jobs_.size() > max_pending_jobs_) {
+      if (!WritePendingJob())
+        return false;
+    }
+
+    if (is_last)
+      return true;
+  }
+
+  return false;
+}
+
+bool ZipWriter::WritePendingJob() {
+  DCHECK(!pending_jobs_.empty());
+  const std::unique_ptr<DeflateJob> job = std::move(pending_jobs_.front());
+  pending_jobs_.pop_front();
+
+  if (!job->Wait())
+    return false;
+
+  if (!job->entry_path().empty()) {
+    if (!OpenNewFileEntry(job->entry_path(), /*is_directory=*/false,
+                          job->entry_last_modified(), /*raw=*/true)) {
+      return false;
+    }
+
+    raw_entry_size_ = 0;
+    raw_entry_crc_ = crc32(0L, Z_NULL, 0);
+  }
+
+  const std::string& output = job->output();
+  if (zipWriteInFileInZip(zip_file_, output.data(), output.size()) != ZIP_OK) {
+    PLOG(ERROR) << "Cannot write compressed data to ZIP";
+    return false;
+  }
+
+  raw_entry_crc_ = crc32_combine(raw_entry_crc_, job->crc(), job->input_size());
+  raw_entry_size_ += job->input_size();
+
+  if (!job->is_last())
+    return true;
+
+  progress_.files++;
+  return CloseNewRawFileEntry(raw_entry_size_, raw_entry_crc_);
+}
+
+bool ZipWriter::WritePendingJobs() {
+  while (!pending_jobs_.empty()) {
+    if (!WritePendingJob())
+      return false;
+  }
+
+  return true;
+}
+
 bool ZipWriter::AddFileEntry(const base::FilePath& path, base::File file) {
   base::File::Info info;
   if (!file.GetInfo(&info))
     return false;
 
-  if (!OpenNewFileEntry(path, /*is_directory=*/false, info.last_modified))
+  if (workers_) {
+    if (GetCompressionMethod(path) == kDeflated)
+      return QueueFileEntry(path, std::move(file), info.last_modified);
+
+    // Stored entries are written directly, after the queued entries.
+    if (!WritePendingJobs())
+      return false;
+  }
+
+  if (!OpenNewFileEntry(path, /*is_directory=*/false, info.last_modified,
+                        /*raw=*/false)) {
     return false;
+  }
 
   if (!AddFileContent(path, std::move(file)))
     return false;
@@ -118,9 +398,15 @@ bool ZipWriter::AddDirectoryEntry(const base::FilePath& path) {
     return continue_on_error_;
   }
 
-  if (!OpenNewFileEntry(path, /*is_directory=*/true, info.last_modified))
+  // Keep the entries in order.
+  if (!WritePendingJobs())
     return false;
 
+  if (!OpenNewFileEntry(path, /*is_directory=*/true, info.last_modified,
+                        /*raw=*/false)) {
+    return false;
+  }
+
   if (!CloseNewFileEntry())
     return false;
 
@@ -172,12 +458,17 @@ ZipWriter::ZipWriter(zipFile zip_file, FileAccessor* file_accessor)
     : zip_file_(zip_file), file_accessor_(file_accessor) {}
 
 ZipWriter::~ZipWriter() {
+  JoinWorkers();
+
   if (zip_file_)
     zipClose(zip_file_, nullptr);
 }
 
 bool ZipWriter::Close() {
-  const bool success = zipClose(zip_file_, nullptr) == ZIP_OK;
+  bool success = WritePendingJobs();
+  JoinWorkers();
+
+  success = zipClose(zip_file_, nullptr) == ZIP_OK && success;
   zip_file_ = nullptr;
 
   // Call the progress callback one last time with the final progress status.
@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 
+#include "base/containers/circular_deque.h"
 #include "base/files/file_path.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
@@ -21,9 +22,15 @@
 #include "third_party/zlib/contrib/minizip/zip.h"
 #endif
 
+namespace base {
+class DelegateSimpleThreadPool;
+}
+
 namespace zip {
 namespace internal {
 
+class DeflateJob;
+
 // A class used to write entries to a ZIP file and buffering the reading of
 // files to limit the number of calls to the FileAccessor. This is for
 // performance reasons as these calls may be expensive when IPC based).
@@ -66,6 +73,13 @@ class ZipWriter {
   // should be included.
   void SetRecursive(bool b) { recursive_ = b; }
 
+  // Sets the number of worker threads used to deflate file entries. If |n| is
+  // greater than 1, file contents are read on the calling thread, split into
+  // chunks and deflated in parallel by a pool of |n| threads, clamped to 64.
+  // The compressed chunks are then written to the ZIP file in the same order as
+  // they would be without workers. Must be called before adding any entry.
+  void SetNumWorkers(int n);
+
   // Sets the filter callback.
   void SetFilterCallback(FilterCallback callback) {
     filter_callback_ = std::move(callback);
@@ -97,6 +111,20 @@ class ZipWriter {
   // Adds a file entry (including file contents).
   bool AddFileEntry(const base::FilePath& path, base::File file);
 
+  // Reads the contents of a file entry, and queues DeflateJobs compressing
+  // them on the worker threads. The entry is written by WritePendingJob() once
+  // all the entries queued before it have been written.
+  bool QueueFileEntry(const base::FilePath& path,
+                      base::File file,
+                      base::Time last_modified);
+
+  // Waits for the oldest queued DeflateJob to complete, and writes its
+  // compressed data to the ZIP file, opening and closing its entry as needed.
+  bool WritePendingJob();
+
+  // Writes all the queued DeflateJobs to the ZIP file.
+  bool WritePendingJobs();
+
   // Adds file entries. All the paths should be existing files.
   bool AddFileEntries(Paths paths);
 
@@ -109,14 +137,22 @@ class ZipWriter {
   // added.
   bool AddDirectoryEntries(Paths paths);
 
-  // Opens a file or directory entry.
+  // Opens a file or directory entry. If |raw| is true, the entry is deflated
+  // and its data must be written already compressed.
   bool OpenNewFileEntry(const base::FilePath& path,
                         bool is_directory,
-                        base::Time last_modified);
+                        base::Time last_modified,
+                        bool raw);
 
   // Closes the currently open entry.
   bool CloseNewFileEntry();
 
+  // Closes the currently open raw entry.
+  bool CloseNewRawFileEntry(uint64_t uncompressed_size, uint32_t crc);
+
+  // Waits for the worker threads to finish and destroys them.
+  void JoinWorkers();
+
   // Filters entries.
   void Filter(std::vector<base::FilePath>* paths);
 
@@ -146,6 +182,22 @@ class ZipWriter {
 
   // Should ignore missing files and directories?
   bool continue_on_error_ = false;
+
+  // Deflate jobs that have been queued on the worker threads, but whose
+  // compressed data hasn't been written to the ZIP file yet. In the same order
+  // as the entries to write.
+  base::circular_deque<std::unique_ptr<DeflateJob>> pending_jobs_;
+
+  // Uncompressed size and CRC-32 of the raw entry currently being written.
+  uint64_t raw_entry_size_ = 0;
+  uint32_t raw_entry_crc_ = 0;
+
+  // Pool of worker threads deflating file entries. Null if the entries are
+  // deflated on the calling thread.
+  std::unique_ptr<base::DelegateSimpleThreadPool> workers_;
+
+  // Maximum number of DeflateJobs queued at any time.
+  size_t max_pending_jobs_ = 0;
 };
 
 }  // namespace internal